@@ -0,0 +1,372 @@
+#include "arcBallBasicControls.h"
+#include "arcBallQuat.h"
+#include "arcBallMath.h"
+
+#include <limits>
+#include <cmath>
+
+using namespace ArcBall;
+
+template<class Mode, class Scalar>
+ArcBall::BasicControls<Mode, Scalar>::BasicControls() {
+    setDeadZone( Scalar( 0.001 ) );
+    setRenormThreshold( std::numeric_limits<Scalar>::epsilon() * Scalar( 4 ) );
+    setPanDampingFactor( Scalar( 1 ) );
+    if constexpr (Mode::smooth) {
+        setRotDampingFactor( Scalar( 1 ) - Scalar( 0.9975 ) );
+    }
+    if constexpr (!Mode::fullCircle) {
+        setMaxTraditionalRotDeg( Scalar( 360 ) );
+        mTraditional.fixX = Scalar( 0 );
+        mTraditional.fixY = Scalar( 0 );
+    }
+    mLMBheldDown = false;
+
+    resetTrafos();
+}
+
+template<class Mode, class Scalar>
+void ArcBall::BasicControls<Mode, Scalar>::setDeadZone( const Scalar deadZone ) {
+    mDeadZone = deadZone;
+    mCosDeadZone = std::cos( deadZone );
+}
+
+template<class Mode, class Scalar>
+void ArcBall::BasicControls<Mode, Scalar>::resetTrafos() {
+    constexpr vec3_t zero{ Scalar( 0 ), Scalar( 0 ), Scalar( 0 ) };
+
+    mArcRot = RigidRot{ identityQuatOf<Scalar>, zero };
+    loadRotTransMatrix( mArcRotMat, identityQuatOf<Scalar>, zero );
+    loadRotTransMatrix( mViewMat, identityQuatOf<Scalar>, zero );
+    loadRotTransMatrix( mViewWithoutArcMat, identityQuatOf<Scalar>, zero );
+    mArcRotMatDirty = false;
+    mViewMatDirty = false;
+    mViewInputsDirty = true;
+
+    mPanVector = zero;
+    mRotationPivotPosArcSpaceWS = zero;
+
+    mRefFrameMat = mat3_t{ vec3_t{ Scalar( 1 ), Scalar( 0 ), Scalar( 0 ) }, vec3_t{ Scalar( 0 ), Scalar( 1 ), Scalar( 0 ) }, vec3_t{ Scalar( 0 ), Scalar( 0 ), Scalar( 1 ) } };
+    mRefFrameTiltRadAngle = Scalar( 0 );
+
+    if constexpr (!Mode::fullCircle) {
+        mTraditional.currRot = RigidRot{ identityQuatOf<Scalar>, zero };
+        mTraditional.prevRot = RigidRot{ identityQuatOf<Scalar>, zero };
+        mTraditional.startMouseNDC = vec3_t{ Scalar( 0 ), Scalar( 0 ), Scalar( 1 ) };
+    }
+    if constexpr (Mode::smooth) {
+        mSmooth.rotVelocity = zero;
+        mSmooth.dragRotVelocity = zero;
+        mSmooth.panVelocity = zero;
+        mSmooth.timeSinceDragMotionSec = Scalar( 0 );
+    }
+}
+
+template<class Mode, class Scalar>
+eRetVal ArcBall::BasicControls<Mode, Scalar>::update( const Scalar deltaTimeSec,
+                                                     const Scalar relMouseX,
+                                                     const Scalar relMouseY,
+                                                     const Scalar relMouse_dx,
+                                                     const Scalar relMouse_dy,
+                                                     const Scalar camDist,
+                                                     const vec3_t& camPanDelta,
+                                                     const Scalar camTiltRadAngle,
+                                                     const bool LMBpressed ) {
+    const RigidRot arcRotBefore = mArcRot;
+    const bool LMBwasHeldDown = mLMBheldDown;
+
+    calcRolledRefFrameMat( camTiltRadAngle );
+    calcArcRot( relMouseX, relMouseY, relMouse_dx, relMouse_dy, LMBpressed );
+
+    vec3_t panDelta = camPanDelta;
+    if constexpr (Mode::smooth) {
+        updateRotInertia( deltaTimeSec, arcRotBefore.quat, LMBwasHeldDown );
+        panDelta = calcSmoothPanDelta( deltaTimeSec, camPanDelta );
+    }
+
+    const bool arcRotChanged = (mArcRot.quat != arcRotBefore.quat || mArcRot.trans != arcRotBefore.trans);
+    const bool viewInputsChanged = mViewInputsDirty
+                                || panDelta[0] != Scalar( 0 ) || panDelta[1] != Scalar( 0 )
+                                || camTiltRadAngle != mViewTiltRadAngle
+                                || camDist != mViewCamDist
+                                || mRotationPivotPosArcSpaceWS != mViewRotationPivotPosArcSpaceWS;
+
+    if (viewInputsChanged) {
+        calcViewWithoutArcMat( camTiltRadAngle, panDelta, camDist );
+    }
+    if (arcRotChanged || viewInputsChanged) {
+        mViewMatDirty = true;
+    }
+
+    return eRetVal::OK;
+}
+
+template<class Mode, class Scalar>
+void ArcBall::BasicControls<Mode, Scalar>::calcRolledRefFrameMat( const Scalar camTiltRadAngle ) {
+    if (camTiltRadAngle == mRefFrameTiltRadAngle) { return; }
+
+    // transposed z-rotation by the tilt angle, already orthonormal
+    const Scalar c = std::cos( camTiltRadAngle );
+    const Scalar s = std::sin( camTiltRadAngle );
+    mRefFrameMat = mat3_t{ vec3_t{ c, s, Scalar( 0 ) }, vec3_t{ -s, c, Scalar( 0 ) }, vec3_t{ Scalar( 0 ), Scalar( 0 ), Scalar( 1 ) } };
+    mRefFrameTiltRadAngle = camTiltRadAngle;
+}
+
+template<class Mode, class Scalar>
+void ArcBall::BasicControls<Mode, Scalar>::calcArcRot( const Scalar relMouseX, const Scalar relMouseY, const Scalar mouse_dx, const Scalar mouse_dy, const bool LMBpressed ) {
+    Scalar relMouseDelta = std::sqrt( mouse_dx * mouse_dx + mouse_dy * mouse_dy );
+    if (!mLMBheldDown || relMouseDelta <= mDeadZone) {
+        relMouseDelta = Scalar( 0 );
+    }
+
+    if constexpr (Mode::fullCircle) {
+        if (mLMBheldDown) {
+            // start is always the center of the arc ball, {0,0,1}
+            vec3_t currMouseNDC = screenPosToArcBallPosNDC( Scalar( 0.5 ) + mouse_dx, Scalar( 0.5 ) + mouse_dy );
+            normalizeVec( currMouseNDC );
+
+            const Scalar cosAngle = currMouseNDC[2];
+            if (cosAngle < Scalar( 1 ) - std::numeric_limits<Scalar>::epsilon() && cosAngle < mCosDeadZone) {
+                // {0,0,1} x currMouseNDC, brought into the ref frame
+                const vec3_t normMousePtDirs = transformVector( mRefFrameMat, vec3_t{ -currMouseNDC[1], currMouseNDC[0], Scalar( 0 ) } );
+
+                vec4_t rotArcBallDeltaQuat{ normMousePtDirs[0], normMousePtDirs[1], normMousePtDirs[2], Scalar( 1 ) + cosAngle };
+                normalizeVec( rotArcBallDeltaQuat );
+
+                rotateArcAroundPivot( rotArcBallDeltaQuat );
+            }
+        }
+
+        if (!mLMBheldDown && LMBpressed) {
+            mLMBheldDown = true;
+        }
+        if (mLMBheldDown && !LMBpressed && relMouseDelta <= mDeadZone) {
+            mLMBheldDown = false;
+        }
+    } else {
+        TraditionalState& trad = mTraditional;
+        bool currOrPrevRotChanged = false;
+
+        if (mLMBheldDown) {
+            trad.fixX += mouse_dx;
+            trad.fixY += mouse_dy;
+            vec3_t currMouseNDC = screenPosToArcBallPosNDC( trad.fixX, trad.fixY );
+            normalizeVec( currMouseNDC );
+            currMouseNDC = transformVector( mRefFrameMat, currMouseNDC );
+            normalizeVec( currMouseNDC );
+
+            const Scalar cosAngle = dotVec( trad.startMouseNDC, currMouseNDC );
+            if (cosAngle < Scalar( 1 ) - std::numeric_limits<Scalar>::epsilon() * Scalar( 100 )) {
+                currOrPrevRotChanged = true;
+                trad.currRot.quat = quatPow( quatFromTwoUnitVectors( trad.startMouseNDC, currMouseNDC ), trad.maxTraditionalRotDeg * (Scalar( 1 ) / Scalar( 180 )) );
+                trad.currRot.trans = subVec( mRotationPivotPosArcSpaceWS, quatRotate( trad.currRot.quat, mRotationPivotPosArcSpaceWS ) );
+            }
+        }
+
+        if (!mLMBheldDown && LMBpressed) {
+            trad.startMouseNDC = transformVector( mRefFrameMat, screenPosToArcBallPosNDC( relMouseX, relMouseY ) );
+            normalizeVec( trad.startMouseNDC );
+
+            trad.fixX = relMouseX;
+            trad.fixY = relMouseY;
+
+            mLMBheldDown = true;
+        }
+
+        if (mLMBheldDown && !LMBpressed && relMouseDelta <= mDeadZone) {
+            currOrPrevRotChanged = true;
+
+            trad.prevRot.trans = addVec( quatRotate( trad.currRot.quat, trad.prevRot.trans ), trad.currRot.trans );
+            trad.prevRot.quat = quatMul( trad.currRot.quat, trad.prevRot.quat );
+            renormalizeQuat( trad.prevRot.quat, mRenormThreshold );
+            trad.currRot = RigidRot{ identityQuatOf<Scalar>, vec3_t{ Scalar( 0 ), Scalar( 0 ), Scalar( 0 ) } };
+            mLMBheldDown = false;
+
+            trad.fixX = Scalar( 0 );
+            trad.fixY = Scalar( 0 );
+        }
+
+        if (currOrPrevRotChanged) {
+            composeTraditionalArcRot();
+        }
+    }
+}
+
+template<class Mode, class Scalar>
+void ArcBall::BasicControls<Mode, Scalar>::composeTraditionalArcRot() {
+    if constexpr (!Mode::fullCircle) {
+        mArcRot.quat = quatMul( mTraditional.currRot.quat, mTraditional.prevRot.quat );
+        normalizeVec( mArcRot.quat );
+        mArcRot.trans = addVec( quatRotate( mTraditional.currRot.quat, mTraditional.prevRot.trans ), mTraditional.currRot.trans );
+        mArcRotMatDirty = true;
+    }
+}
+
+template<class Mode, class Scalar>
+void ArcBall::BasicControls<Mode, Scalar>::rotateArcAroundPivot( const vec4_t& deltaQuat ) {
+    // x' = delta * (arcRot(x) - pivot) + pivot
+    // traditional mode: goes into the rotation of the finished drags, the current drag stays on top of it
+    RigidRot* rot = &mArcRot;
+    if constexpr (!Mode::fullCircle) {
+        rot = &mTraditional.prevRot;
+    }
+    rot->quat = quatMul( deltaQuat, rot->quat );
+    renormalizeQuat( rot->quat, mRenormThreshold );
+    rot->trans = addVec( quatRotate( deltaQuat, subVec( rot->trans, mRotationPivotPosArcSpaceWS ) ), mRotationPivotPosArcSpaceWS );
+
+    if constexpr (!Mode::fullCircle) {
+        composeTraditionalArcRot();
+    }
+    mArcRotMatDirty = true;
+}
+
+template<class Mode, class Scalar>
+void ArcBall::BasicControls<Mode, Scalar>::updateRotInertia( const Scalar deltaTimeSec, const vec4_t& arcQuatBefore, const bool LMBwasHeldDown ) {
+    if constexpr (Mode::smooth) {
+        SmoothState& smooth = mSmooth;
+        if (deltaTimeSec <= Scalar( 0 )) {
+            smooth.rotVelocity = vec3_t{ Scalar( 0 ), Scalar( 0 ), Scalar( 0 ) };
+            return;
+        }
+
+        if (LMBwasHeldDown || mLMBheldDown) {
+            const vec3_t inputRotVelocity = calcStepRotVelocity( mArcRot.quat, arcQuatBefore, deltaTimeSec );
+            if (inputRotVelocity[0] != Scalar( 0 ) || inputRotVelocity[1] != Scalar( 0 ) || inputRotVelocity[2] != Scalar( 0 )) {
+                smooth.dragRotVelocity = inputRotVelocity;
+                smooth.timeSinceDragMotionSec = Scalar( 0 );
+            } else {
+                smooth.timeSinceDragMotionSec += deltaTimeSec;
+            }
+
+            smooth.rotVelocity = vec3_t{ Scalar( 0 ), Scalar( 0 ), Scalar( 0 ) };
+            if (LMBwasHeldDown && !mLMBheldDown && smooth.timeSinceDragMotionSec <= flingTimeoutSec<Scalar>) {
+                smooth.rotVelocity = smooth.dragRotVelocity;
+            }
+            return;
+        }
+
+        Scalar radPerSec = std::sqrt( dotVec( smooth.rotVelocity, smooth.rotVelocity ) );
+        if (radPerSec <= minInertiaVelocity<Scalar>) {
+            smooth.rotVelocity = vec3_t{ Scalar( 0 ), Scalar( 0 ), Scalar( 0 ) };
+            return;
+        }
+        const vec3_t axis = scaleVec( smooth.rotVelocity, Scalar( 1 ) / radPerSec );
+        const Scalar halfAngle = Scalar( 0.5 ) * integrateExpDecay( radPerSec, smooth.rotDampingFactor, deltaTimeSec );
+        smooth.rotVelocity = scaleVec( axis, radPerSec );
+
+        const Scalar sinHalfAngle = std::sin( halfAngle );
+        rotateArcAroundPivot( vec4_t{ axis[0] * sinHalfAngle, axis[1] * sinHalfAngle, axis[2] * sinHalfAngle, std::cos( halfAngle ) } );
+    }
+}
+
+template<class Mode, class Scalar>
+typename ArcBall::BasicControls<Mode, Scalar>::vec3_t ArcBall::BasicControls<Mode, Scalar>::calcSmoothPanDelta( const Scalar deltaTimeSec, const vec3_t& camPanDelta ) {
+    if constexpr (Mode::smooth) {
+        SmoothState& smooth = mSmooth;
+        if (deltaTimeSec <= Scalar( 0 )) {
+            smooth.panVelocity = vec3_t{ Scalar( 0 ), Scalar( 0 ), Scalar( 0 ) };
+            return camPanDelta;
+        }
+
+        if (camPanDelta[0] != Scalar( 0 ) || camPanDelta[1] != Scalar( 0 )) {
+            smooth.panVelocity = scaleVec( camPanDelta, Scalar( 1 ) / deltaTimeSec );
+            return camPanDelta;
+        }
+
+        Scalar panSpeed = std::sqrt( smooth.panVelocity[0] * smooth.panVelocity[0] + smooth.panVelocity[1] * smooth.panVelocity[1] );
+        if (panSpeed <= minInertiaVelocity<Scalar>) {
+            smooth.panVelocity = vec3_t{ Scalar( 0 ), Scalar( 0 ), Scalar( 0 ) };
+            return camPanDelta;
+        }
+        const vec3_t panDir{ smooth.panVelocity[0] / panSpeed, smooth.panVelocity[1] / panSpeed, Scalar( 0 ) };
+        const Scalar panDist = integrateExpDecay( panSpeed, mPanDampingFactor, deltaTimeSec );
+        smooth.panVelocity = scaleVec( panDir, panSpeed );
+
+        return vec3_t{ panDir[0] * panDist, panDir[1] * panDist, camPanDelta[2] };
+    } else {
+        return camPanDelta;
+    }
+}
+
+template<class Mode, class Scalar>
+void ArcBall::BasicControls<Mode, Scalar>::calcViewWithoutArcMat( const Scalar camTiltRadAngle, const vec3_t& camPanDelta, const Scalar camDist ) {
+    if constexpr (Mode::smooth) {
+        mPanVector[0] += camPanDelta[0];
+        mPanVector[1] += camPanDelta[1];
+    } else {
+        mPanVector[0] += camPanDelta[0] / mPanDampingFactor;
+        mPanVector[1] += camPanDelta[1] / mPanDampingFactor;
+    }
+
+    // translation * T(pivot) * tiltRot * T(-pivot)
+    const Scalar c = std::cos( camTiltRadAngle );
+    const Scalar s = std::sin( camTiltRadAngle );
+    const vec3_t& p = mRotationPivotPosArcSpaceWS;
+    mViewWithoutArcMat[0] = vec4_t{ c, -s, Scalar( 0 ), p[0] - (c * p[0] - s * p[1]) + mPanVector[0] };
+    mViewWithoutArcMat[1] = vec4_t{ s,  c, Scalar( 0 ), p[1] - (s * p[0] + c * p[1]) + mPanVector[1] };
+    mViewWithoutArcMat[2] = vec4_t{ Scalar( 0 ), Scalar( 0 ), Scalar( 1 ), camDist + mPanVector[2] };
+
+    mViewTiltRadAngle = camTiltRadAngle;
+    mViewCamDist = camDist;
+    mViewRotationPivotPosArcSpaceWS = mRotationPivotPosArcSpaceWS;
+    mViewInputsDirty = false;
+    mViewMatDirty = true;
+}
+
+template<class Mode, class Scalar>
+void ArcBall::BasicControls<Mode, Scalar>::addPanDelta( const vec3_t& delta ) {
+    mPanVector = addVec( mPanVector, delta );
+    mViewInputsDirty = true;
+}
+
+template<class Mode, class Scalar>
+void ArcBall::BasicControls<Mode, Scalar>::setRotationPivotWS( const vec3_t& pivotWS ) {
+    const vec3_t diff = subVec( pivotWS, mRotationPivotPosArcSpaceWS );
+    if (std::sqrt( dotVec( diff, diff ) ) <= std::numeric_limits<Scalar>::epsilon() * Scalar( 100 )) { return; }
+    mRotationPivotPosArcSpaceWS = addVec( quatRotate( mArcRot.quat, pivotWS ), mArcRot.trans );
+}
+
+template<class Mode, class Scalar>
+void ArcBall::BasicControls<Mode, Scalar>::setRotationPivotArcSpaceWS( const vec3_t& pivotArcSpaceWS ) {
+    mRotationPivotPosArcSpaceWS = pivotArcSpaceWS;
+}
+
+template<class Mode, class Scalar>
+void ArcBall::BasicControls<Mode, Scalar>::seamlessSetRotationPivotWS( const vec3_t& pivotWS, const Scalar camTiltRadAngle, const Scalar camDist ) {
+    setRotationPivotWS( pivotWS );
+
+    // keep the ArcSpaceWS origin where it is in eye space, see Controls::commonSeamlessSetRotationPivotWS()
+    const vec3_t prevRefPtES{ mViewWithoutArcMat[0][3], mViewWithoutArcMat[1][3], mViewWithoutArcMat[2][3] };
+    calcViewWithoutArcMat( camTiltRadAngle, vec3_t{ Scalar( 0 ), Scalar( 0 ), Scalar( 0 ) }, camDist );
+    const vec3_t newRefPtES{ mViewWithoutArcMat[0][3], mViewWithoutArcMat[1][3], mViewWithoutArcMat[2][3] };
+
+    addPanDelta( subVec( prevRefPtES, newRefPtES ) );
+}
+
+template<class Mode, class Scalar>
+void ArcBall::BasicControls<Mode, Scalar>::expandArcRotMat() const {
+    loadRotTransMatrix( mArcRotMat, mArcRot.quat, mArcRot.trans );
+    mArcRotMatDirty = false;
+}
+
+template<class Mode, class Scalar>
+void ArcBall::BasicControls<Mode, Scalar>::expandViewMat() const {
+    const mat3x4_t& a = mViewWithoutArcMat;
+    const mat3x4_t& b = getArcRotMat();
+    for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 4; c++) {
+            mViewMat[r][c] = a[r][0] * b[0][c] + a[r][1] * b[1][c] + a[r][2] * b[2][c];
+        }
+        mViewMat[r][3] += a[r][3];
+    }
+    mViewMatDirty = false;
+}
+
+template struct ArcBall::BasicControls<FullCircleMode, float>;
+template struct ArcBall::BasicControls<FullCircleSmoothMode, float>;
+template struct ArcBall::BasicControls<TraditionalMode, float>;
+template struct ArcBall::BasicControls<TraditionalSmoothMode, float>;
+template struct ArcBall::BasicControls<FullCircleMode, double>;
+template struct ArcBall::BasicControls<FullCircleSmoothMode, double>;
+template struct ArcBall::BasicControls<TraditionalMode, double>;
+template struct ArcBall::BasicControls<TraditionalSmoothMode, double>;
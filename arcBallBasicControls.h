@@ -0,0 +1,162 @@
+#ifndef _ARCBALLBASICCONTROLS_H_d81e6f2a_5c37_4b90_9e14_7f2a06c3b5d8
+#define _ARCBALLBASICCONTROLS_H_d81e6f2a_5c37_4b90_9e14_7f2a06c3b5d8
+
+// compile-time specialized twin of ArcBall::Controls for deployments that only ever use one interaction mode
+//
+// BasicControls<Mode, Scalar> resolves the fullCircle / smooth branches with if constexpr and only carries the state its
+// mode needs - no current/previous drag rotations for the full circle mode, no inertia state without smooth, ...
+// Scalar is float or double; with float the vector/matrix types are the linAlg ones, so the results can be used as they are
+//
+// with float, update() gives the same view matrix as Controls::update() with the same mode (within float tolerance);
+// double uses double epsilons for the motion thresholds as well, so borderline mouse steps may be taken where float ones are not
+// the basic/* cases of arcBallBench time update() against Controls::update() with the same mode - roughly 60 vs 140 ns for the
+// full circle mode and 140 vs 190 ns for traditional + smooth
+// the math is the Scalar-templated helpers of arcBallQuat.h that Controls uses as well, and accumulated rotations get the same
+// thresholded Newton renormalization (setRenormThreshold())
+// Controls stays the runtime-configurable facade, with tracing / snapshot channels / instrumentation on top - and with what
+// BasicControls leaves out: the settle threshold and motion report (getViewMotion()), large world mode (setLargeWorldMode()),
+// NumericHealth, predictViewMatrix() and saveState() / restoreState(); a deployment needing any of these uses Controls
+// the member functions are explicitly instantiated in arcBallBasicControls.cpp for the four modes x { float, double }
+
+#include "eRetVal_ArcBall.h"
+#include "arcBallControls.h"
+
+#include <array>
+#include <type_traits>
+
+namespace ArcBall {
+
+    template<bool fullCircle_, bool smooth_>
+    struct InteractionMode {
+        static constexpr bool fullCircle = fullCircle_;
+        static constexpr bool smooth = smooth_;
+        static constexpr Controls::InteractionModeDesc desc{ .fullCircle = fullCircle_, .smooth = smooth_ };
+    };
+    using FullCircleMode        = InteractionMode<true, false>;
+    using FullCircleSmoothMode  = InteractionMode<true, true>;
+    using TraditionalMode       = InteractionMode<false, false>;
+    using TraditionalSmoothMode = InteractionMode<false, true>;
+
+    template<class Mode, class Scalar>
+    struct BasicControls {
+        static_assert( std::is_floating_point_v<Scalar>, "BasicControls needs a floating point scalar type" );
+
+        using scalar_t = Scalar;
+        using vec3_t   = std::array<Scalar, 3>;
+        using vec4_t   = std::array<Scalar, 4>;
+        using mat3_t   = std::array<vec3_t, 3>;
+        using mat3x4_t = std::array<vec4_t, 3>;
+
+        BasicControls();
+
+        // same arguments as Controls::update()
+        eRetVal update( const Scalar deltaTimeSec,
+                        const Scalar relMouseX,
+                        const Scalar relMouseY,
+                        const Scalar relMouse_dx,
+                        const Scalar relMouse_dy,
+                        const Scalar camDist,
+                        const vec3_t& camPanDelta,
+                        const Scalar camTiltRadAngle,
+                        const bool LMBpressed );
+
+        const mat3x4_t& getArcRotMat() const { if (mArcRotMatDirty) { expandArcRotMat(); } return mArcRotMat; }
+        const mat3x4_t& getViewMatrix() const { if (mViewMatDirty) { expandViewMat(); } return mViewMat; }
+
+        void addPanDelta( const vec3_t& delta );
+
+        void setRotationPivotWS( const vec3_t& pivotWS );
+        void setRotationPivotArcSpaceWS( const vec3_t& pivotArcSpaceWS );
+        const vec3_t& getRotationPivotOffsetArcSpaceWS() const { return mRotationPivotPosArcSpaceWS; }
+        void seamlessSetRotationPivotWS( const vec3_t& pivotWS, const Scalar camTiltRadAngle, const Scalar camDist );
+
+        void setRotDampingFactor( const Scalar dampingFactor ) requires( Mode::smooth ) { mSmooth.rotDampingFactor = dampingFactor; }
+        Scalar getRotDampingFactor() const requires( Mode::smooth ) { return mSmooth.rotDampingFactor; }
+
+        void setPanDampingFactor( const Scalar dampingFactor ) { mPanDampingFactor = dampingFactor; }
+        Scalar getPanDampingFactor() const { return mPanDampingFactor; }
+
+        void setMaxTraditionalRotDeg( const Scalar maxTraditionalRotDeg ) requires( !Mode::fullCircle ) { mTraditional.maxTraditionalRotDeg = maxTraditionalRotDeg; }
+        Scalar getMaxTraditionalRotDeg() const requires( !Mode::fullCircle ) { return mTraditional.maxTraditionalRotDeg; }
+
+        void setDeadZone( const Scalar deadZone );
+        Scalar getDeadZone() const { return mDeadZone; }
+
+        // see Controls::setRenormThreshold()
+        void setRenormThreshold( const Scalar normError ) { mRenormThreshold = normError; }
+        Scalar getRenormThreshold() const { return mRenormThreshold; }
+
+        static constexpr Controls::InteractionModeDesc getInteractionMode() { return Mode::desc; }
+
+        void resetTrafos();
+
+    private:
+        struct RigidRot {
+            vec4_t quat; // x, y, z, w
+            vec3_t trans;
+        };
+
+        // only for clamp mouse interaction ("traditional" arc ball)
+        struct TraditionalState {
+            RigidRot currRot;
+            RigidRot prevRot;
+            vec3_t   startMouseNDC;
+            Scalar   fixX;
+            Scalar   fixY;
+            Scalar   maxTraditionalRotDeg;
+        };
+        struct NoTraditionalState {};
+
+        // smooth mode inertia
+        struct SmoothState {
+            vec3_t rotVelocity;
+            vec3_t dragRotVelocity;
+            vec3_t panVelocity;
+            Scalar timeSinceDragMotionSec;
+            Scalar rotDampingFactor;
+        };
+        struct NoSmoothState {};
+
+        void calcRolledRefFrameMat( const Scalar camTiltRadAngle );
+        void calcArcRot( const Scalar relMouseX, const Scalar relMouseY, const Scalar relMouse_dx, const Scalar relMouse_dy, const bool LMBpressed );
+        void rotateArcAroundPivot( const vec4_t& deltaQuat );
+        void composeTraditionalArcRot();
+        void updateRotInertia( const Scalar deltaTimeSec, const vec4_t& arcQuatBefore, const bool LMBwasHeldDown );
+        vec3_t calcSmoothPanDelta( const Scalar deltaTimeSec, const vec3_t& camPanDelta );
+        void calcViewWithoutArcMat( const Scalar camTiltRadAngle, const vec3_t& camPanDelta, const Scalar camDist );
+
+        void expandArcRotMat() const;
+        void expandViewMat() const;
+
+        RigidRot mArcRot;
+        mutable mat3x4_t mArcRotMat;
+        mutable mat3x4_t mViewMat;
+        mutable bool mArcRotMatDirty;
+        mutable bool mViewMatDirty;
+
+        mat3x4_t mViewWithoutArcMat; // mViewTranslationMat * mTiltRotMat of Controls in one
+
+        // what mViewWithoutArcMat was last built from
+        Scalar mViewTiltRadAngle;
+        Scalar mViewCamDist;
+        vec3_t mViewRotationPivotPosArcSpaceWS;
+        bool   mViewInputsDirty;
+
+        vec3_t mPanVector;
+        vec3_t mRotationPivotPosArcSpaceWS;
+
+        mat3_t mRefFrameMat;
+        Scalar mRefFrameTiltRadAngle;
+
+        Scalar mPanDampingFactor;
+        Scalar mDeadZone;
+        Scalar mCosDeadZone;
+        Scalar mRenormThreshold;
+
+        bool mLMBheldDown;
+
+        [[no_unique_address]] std::conditional_t<Mode::fullCircle, NoTraditionalState, TraditionalState> mTraditional;
+        [[no_unique_address]] std::conditional_t<Mode::smooth, SmoothState, NoSmoothState> mSmooth;
+    };
+}
+#endif // _ARCBALLBASICCONTROLS_H_d81e6f2a_5c37_4b90_9e14_7f2a06c3b5d8
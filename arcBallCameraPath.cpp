@@ -0,0 +1,205 @@
+#include "arcBallCameraPath.h"
+#include "arcBallQuat.h"
+#include "arcBallMath.h"
+#include "arcBallParallel.h"
+
+#include <math.h>
+#include <algorithm>
+
+using namespace ArcBall;
+
+namespace {
+    // below that many view matrices per thread spawning threads costs more than it saves
+    static constexpr size_t minTimesPerThread = 4096;
+
+    // log / exp of unit quaternions, the log is a pure quaternion stored as vec3
+    linAlg::vec3_t quatLog( const linAlg::vec4_t& q ) {
+        const float lenV = sqrtf( q[0] * q[0] + q[1] * q[1] + q[2] * q[2] );
+        if (lenV < 1e-7f) { return linAlg::vec3_t{ 0.0f, 0.0f, 0.0f }; }
+        const float s = atan2f( lenV, q[3] ) / lenV;
+        return linAlg::vec3_t{ q[0] * s, q[1] * s, q[2] * s };
+    }
+
+    linAlg::vec4_t quatExp( const linAlg::vec3_t& v ) {
+        const float angle = sqrtf( linAlg::dot( v, v ) );
+        if (angle < 1e-7f) { return identityQuat; }
+        const float s = sinf( angle ) / angle;
+        return linAlg::vec4_t{ v[0] * s, v[1] * s, v[2] * s, cosf( angle ) };
+    }
+
+    linAlg::vec3_t hermite( const linAlg::vec3_t& p0, const linAlg::vec3_t& m0, const linAlg::vec3_t& p1, const linAlg::vec3_t& m1, const float h00, const float h10, const float h01, const float h11 ) {
+        return linAlg::vec3_t{
+            h00 * p0[0] + h10 * m0[0] + h01 * p1[0] + h11 * m1[0],
+            h00 * p0[1] + h10 * m0[1] + h01 * p1[1] + h11 * m1[1],
+            h00 * p0[2] + h10 * m0[2] + h01 * p1[2] + h11 * m1[2] };
+    }
+
+    // non-uniform Catmull-Rom tangent (per second), one-sided at the ends
+    template<class getValue_t>
+    auto catmullRomTangent( const std::vector<CameraKeyframe>& keyframes, const size_t idx, getValue_t getValue ) {
+        const size_t prevIdx = (idx > 0) ? idx - 1 : idx;
+        const size_t nextIdx = (idx + 1 < keyframes.size()) ? idx + 1 : idx;
+        const float invDt = (nextIdx == prevIdx) ? 0.0f : static_cast<float>( 1.0 / (keyframes[nextIdx].timeSec - keyframes[prevIdx].timeSec) );
+        return getValue( keyframes[nextIdx], keyframes[prevIdx], invDt );
+    }
+}
+
+void ArcBall::CameraPath::clear() {
+    mKeyframes.clear();
+    mTangents.clear();
+}
+
+eRetVal ArcBall::CameraPath::addKeyframe( const CameraKeyframe& keyframe ) {
+    if (!mKeyframes.empty() && !(keyframe.timeSec > mKeyframes.back().timeSec)) { return eRetVal::ERROR; }
+
+    CameraKeyframe aligned = keyframe;
+    linAlg::normalize( aligned.arcQuat );
+    if (!mKeyframes.empty() && linAlg::dot( aligned.arcQuat, mKeyframes.back().arcQuat ) < 0.0f) {
+        // q and -q are the same rotation, keep neighbours on the same hemisphere so that squad takes the short way
+        aligned.arcQuat = linAlg::vec4_t{ -aligned.arcQuat[0], -aligned.arcQuat[1], -aligned.arcQuat[2], -aligned.arcQuat[3] };
+    }
+
+    mKeyframes.push_back( aligned );
+    mTangents.push_back( Tangents{} );
+
+    const size_t lastIdx = mKeyframes.size() - 1;
+    calcTangents( lastIdx );
+    if (lastIdx > 0) { calcTangents( lastIdx - 1 ); }
+
+    return eRetVal::OK;
+}
+
+void ArcBall::CameraPath::calcTangents( const size_t idx ) {
+    Tangents& tangents = mTangents[idx];
+
+    tangents.pivotWS = catmullRomTangent( mKeyframes, idx, []( const CameraKeyframe& next, const CameraKeyframe& prev, const float invDt ) {
+        return linAlg::vec3_t{ (next.pivotWS[0] - prev.pivotWS[0]) * invDt, (next.pivotWS[1] - prev.pivotWS[1]) * invDt, (next.pivotWS[2] - prev.pivotWS[2]) * invDt }; } );
+    tangents.panVector = catmullRomTangent( mKeyframes, idx, []( const CameraKeyframe& next, const CameraKeyframe& prev, const float invDt ) {
+        return linAlg::vec3_t{ (next.panVector[0] - prev.panVector[0]) * invDt, (next.panVector[1] - prev.panVector[1]) * invDt, (next.panVector[2] - prev.panVector[2]) * invDt }; } );
+    tangents.camTiltRadAngle = catmullRomTangent( mKeyframes, idx, []( const CameraKeyframe& next, const CameraKeyframe& prev, const float invDt ) {
+        return (next.camTiltRadAngle - prev.camTiltRadAngle) * invDt; } );
+    tangents.camDist = catmullRomTangent( mKeyframes, idx, []( const CameraKeyframe& next, const CameraKeyframe& prev, const float invDt ) {
+        return (next.camDist - prev.camDist) * invDt; } );
+
+    // squad: s_i = q_i * exp( -( log(q_i^-1 * q_i+1) + log(q_i^-1 * q_i-1) ) / 4 ), the end points are their own control points
+    const linAlg::vec4_t& q = mKeyframes[idx].arcQuat;
+    if (idx == 0 || idx + 1 == mKeyframes.size()) {
+        tangents.squadQuat = q;
+    } else {
+        const linAlg::vec4_t invQ = quatConjugate( q );
+        const linAlg::vec3_t logNext = quatLog( quatMul( invQ, mKeyframes[idx + 1].arcQuat ) );
+        const linAlg::vec3_t logPrev = quatLog( quatMul( invQ, mKeyframes[idx - 1].arcQuat ) );
+        tangents.squadQuat = quatMul( q, quatExp( linAlg::vec3_t{ -0.25f * (logNext[0] + logPrev[0]), -0.25f * (logNext[1] + logPrev[1]), -0.25f * (logNext[2] + logPrev[2]) } ) );
+        linAlg::normalize( tangents.squadQuat );
+    }
+}
+
+CameraKeyframe ArcBall::CameraPath::captureKeyframe( const double timeSec, const Controls& controls ) {
+    const linAlg::mat3x4_t& viewMatrix = controls.getViewMatrix();
+
+    CameraKeyframe keyframe;
+    keyframe.timeSec = timeSec;
+    keyframe.camTiltRadAngle = controls.getViewTiltRadAngle();
+    keyframe.camDist = controls.getViewCamDist();
+    keyframe.pivotWS = controls.getRotationPivotOffsetWS();
+
+    // view = T(pan + {0,0,camDist}) * rotZ(tilt) * rot(arcQuat) * T(-pivotWS)
+    const float halfTilt = 0.5f * keyframe.camTiltRadAngle;
+    const linAlg::vec4_t tiltQuat{ 0.0f, 0.0f, sinf( halfTilt ), cosf( halfTilt ) };
+    keyframe.arcQuat = quatMul( quatConjugate( tiltQuat ), quatFromRotMat( viewMatrix ) );
+    linAlg::normalize( keyframe.arcQuat );
+
+    const linAlg::vec3_t pivotES = transformPoint( viewMatrix, keyframe.pivotWS );
+    keyframe.panVector = linAlg::vec3_t{ pivotES[0], pivotES[1], pivotES[2] - keyframe.camDist };
+
+    return keyframe;
+}
+
+void ArcBall::CameraPath::applyKeyframe( Controls& controls, const CameraKeyframe& keyframe ) {
+    linAlg::mat3x4_t viewMatrix;
+    calcViewMatrix( keyframe, viewMatrix );
+    controls.setViewMatrix( viewMatrix, keyframe.pivotWS, keyframe.camTiltRadAngle, keyframe.camDist );
+}
+
+void ArcBall::CameraPath::calcViewMatrix( const CameraKeyframe& keyframe, linAlg::mat3x4_t& viewMatrix ) {
+    const float halfTilt = 0.5f * keyframe.camTiltRadAngle;
+    const linAlg::vec4_t tiltQuat{ 0.0f, 0.0f, sinf( halfTilt ), cosf( halfTilt ) };
+    const linAlg::vec4_t viewQuat = quatMul( tiltQuat, keyframe.arcQuat );
+
+    const linAlg::vec3_t rotatedPivot = quatRotate( viewQuat, keyframe.pivotWS );
+    const linAlg::vec3_t trans{
+        keyframe.panVector[0] - rotatedPivot[0],
+        keyframe.panVector[1] - rotatedPivot[1],
+        keyframe.panVector[2] + keyframe.camDist - rotatedPivot[2] };
+    loadRotTransMatrix( viewMatrix, viewQuat, trans );
+}
+
+void ArcBall::CameraPath::evaluateSegment( const size_t idx, const double timeSec, CameraKeyframe& keyframe ) const {
+    const CameraKeyframe& k0 = mKeyframes[idx];
+    const CameraKeyframe& k1 = mKeyframes[idx + 1];
+    const Tangents& m0 = mTangents[idx];
+    const Tangents& m1 = mTangents[idx + 1];
+
+    const double segmentDuration = k1.timeSec - k0.timeSec;
+    const float u = static_cast<float>( (timeSec - k0.timeSec) / segmentDuration );
+    const float h = static_cast<float>( segmentDuration ); // tangents are per second
+
+    // cubic Hermite basis
+    const float u2 = u * u;
+    const float u3 = u2 * u;
+    const float h00 = 2.0f * u3 - 3.0f * u2 + 1.0f;
+    const float h10 = (u3 - 2.0f * u2 + u) * h;
+    const float h01 = -2.0f * u3 + 3.0f * u2;
+    const float h11 = (u3 - u2) * h;
+
+    keyframe.timeSec = timeSec;
+    keyframe.pivotWS = hermite( k0.pivotWS, m0.pivotWS, k1.pivotWS, m1.pivotWS, h00, h10, h01, h11 );
+    keyframe.panVector = hermite( k0.panVector, m0.panVector, k1.panVector, m1.panVector, h00, h10, h01, h11 );
+    keyframe.camTiltRadAngle = h00 * k0.camTiltRadAngle + h10 * m0.camTiltRadAngle + h01 * k1.camTiltRadAngle + h11 * m1.camTiltRadAngle;
+    keyframe.camDist = h00 * k0.camDist + h10 * m0.camDist + h01 * k1.camDist + h11 * m1.camDist;
+
+    // squad( q0, q1, s0, s1, u ) = slerp( slerp( q0, q1, u ), slerp( s0, s1, u ), 2u(1-u) )
+    keyframe.arcQuat = quatSlerp( quatSlerp( k0.arcQuat, k1.arcQuat, u ), quatSlerp( m0.squadQuat, m1.squadQuat, u ), 2.0f * u * (1.0f - u) );
+}
+
+eRetVal ArcBall::CameraPath::evaluateKeyframe( const double timeSec, CameraKeyframe& keyframe ) const {
+    if (mKeyframes.empty()) { return eRetVal::ERROR; }
+
+    if (!(timeSec > mKeyframes.front().timeSec)) { // also catches NaN
+        keyframe = mKeyframes.front();
+        return eRetVal::OK;
+    }
+    if (timeSec >= mKeyframes.back().timeSec) {
+        keyframe = mKeyframes.back();
+        return eRetVal::OK;
+    }
+
+    // first keyframe after timeSec, the segment starts one before it
+    const auto nextIt = std::upper_bound( mKeyframes.begin(), mKeyframes.end(), timeSec, []( const double t, const CameraKeyframe& k ) { return t < k.timeSec; } );
+    evaluateSegment( static_cast<size_t>( nextIt - mKeyframes.begin() ) - 1, timeSec, keyframe );
+    return eRetVal::OK;
+}
+
+eRetVal ArcBall::CameraPath::evaluate( const double timeSec, linAlg::mat3x4_t& viewMatrix ) const {
+    CameraKeyframe keyframe;
+    if (evaluateKeyframe( timeSec, keyframe ) != eRetVal::OK) { return eRetVal::ERROR; }
+    calcViewMatrix( keyframe, viewMatrix );
+    return eRetVal::OK;
+}
+
+void ArcBall::CameraPath::evaluateRange( const double* timesSec, const size_t numTimes, linAlg::mat3x4_t* viewMatrices ) const {
+    CameraKeyframe keyframe;
+    for (size_t i = 0; i < numTimes; i++) {
+        evaluateKeyframe( timesSec[i], keyframe );
+        calcViewMatrix( keyframe, viewMatrices[i] );
+    }
+}
+
+eRetVal ArcBall::CameraPath::evaluateBatch( const double* timesSec, const size_t numTimes, linAlg::mat3x4_t* viewMatrices, const uint32_t numThreads ) const {
+    if (mKeyframes.empty()) { return eRetVal::ERROR; }
+
+    parallelForRanges( numTimes, numThreads, minTimesPerThread, [&]( const size_t start, const size_t count ) {
+        evaluateRange( timesSec + start, count, viewMatrices + start );
+    } );
+    return eRetVal::OK;
+}
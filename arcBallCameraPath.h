@@ -0,0 +1,79 @@
+#ifndef _ARCBALLCAMERAPATH_H_9a3c71e5_4f28_4d0b_8e6a_c25b1f07d943
+#define _ARCBALLCAMERAPATH_H_9a3c71e5_4f28_4d0b_8e6a_c25b1f07d943
+
+// keyframed camera paths for flythroughs and offline rendering, no more faking mouse input into Controls::update()
+//
+// a keyframe holds the state Controls builds its view from: arc rotation around the pivot, tilt, pan, distance and pivot, so
+//   view = T(pan + {0,0,camDist}) * rotZ(camTiltRadAngle) * rot(arcQuat) * T(-pivotWS)
+// the arc rotation is interpolated with squad, everything else with a time-aware Catmull-Rom spline,
+// the path goes exactly through its keyframes and is clamped to the first / last keyframe outside of its time range
+//
+// keyframes are relative to the origin of the Controls they were captured from (see Controls::setLargeWorldMode()),
+// a path should not span an origin rebase
+
+#include "eRetVal_ArcBall.h"
+#include "arcBallControls.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace ArcBall {
+
+    struct CameraKeyframe {
+        double         timeSec;
+        linAlg::vec4_t arcQuat; // x, y, z, w - rotation around the pivot, tilt not included
+        linAlg::vec3_t pivotWS;
+        linAlg::vec3_t panVector; // where the pivot ends up in eye space, minus { 0, 0, camDist }
+        float          camTiltRadAngle;
+        float          camDist;
+    };
+
+    struct CameraPath {
+
+        void clear();
+
+        // keyframes have to come in strictly increasing time order, ERROR otherwise
+        eRetVal addKeyframe( const CameraKeyframe& keyframe );
+
+        // keyframe from the current view of controls - uses the tilt and distance of its last update()
+        static CameraKeyframe captureKeyframe( const double timeSec, const Controls& controls );
+
+        // puts controls into the state of keyframe; the next update() with keyframe.camTiltRadAngle and keyframe.camDist
+        // (and no mouse / pan input) yields exactly the keyframe's view, and the arc ball rotates around keyframe.pivotWS
+        static void applyKeyframe( Controls& controls, const CameraKeyframe& keyframe );
+
+        static void calcViewMatrix( const CameraKeyframe& keyframe, linAlg::mat3x4_t& viewMatrix );
+
+        // ERROR if the path has no keyframes
+        eRetVal evaluateKeyframe( const double timeSec, CameraKeyframe& keyframe ) const;
+        eRetVal evaluate( const double timeSec, linAlg::mat3x4_t& viewMatrix ) const;
+
+        // viewMatrices must have room for numTimes matrices; timesSec don't have to be sorted
+        // numThreads == 0 uses all hardware threads, small batches are evaluated on the calling thread
+        eRetVal evaluateBatch( const double* timesSec, const size_t numTimes, linAlg::mat3x4_t* viewMatrices, const uint32_t numThreads = 0 ) const;
+
+        size_t getNumKeyframes() const { return mKeyframes.size(); }
+        const CameraKeyframe& getKeyframe( const size_t idx ) const { return mKeyframes[idx]; }
+        double getStartTimeSec() const { return mKeyframes.empty() ? 0.0 : mKeyframes.front().timeSec; }
+        double getEndTimeSec() const { return mKeyframes.empty() ? 0.0 : mKeyframes.back().timeSec; }
+
+    private:
+        // per-keyframe spline data, recalculated for the neighbours whenever a keyframe gets added
+        struct Tangents {
+            linAlg::vec4_t squadQuat; // inner squad control point
+            linAlg::vec3_t pivotWS;
+            linAlg::vec3_t panVector;
+            float          camTiltRadAngle;
+            float          camDist;
+        };
+
+        void calcTangents( const size_t idx );
+        void evaluateSegment( const size_t idx, const double timeSec, CameraKeyframe& keyframe ) const;
+        void evaluateRange( const double* timesSec, const size_t numTimes, linAlg::mat3x4_t* viewMatrices ) const;
+
+        std::vector<CameraKeyframe> mKeyframes; // arcQuat hemisphere-aligned with its predecessor
+        std::vector<Tangents>       mTangents;
+    };
+}
+#endif // _ARCBALLCAMERAPATH_H_9a3c71e5_4f28_4d0b_8e6a_c25b1f07d943
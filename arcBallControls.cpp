@@ -1,14 +1,24 @@
 #include "arcBallControls.h"
+#include "arcBallViewSnapshot.h"
+#include "arcBallTrace.h"
+#include "arcBallQuat.h"
+#include "arcBallMath.h"
+#include "arcBallParallel.h"
 
 #include <limits>
 #include <assert.h>
+#include <string.h>
 
 #include <utility>
+#include <type_traits>
 
 using namespace ArcBall;
 
 namespace {
     static constexpr float practicallyZero = std::numeric_limits<float>::epsilon() * 10.0f;
+
+    // bulk point transforms: ~1.1 ns per point, so a chunk this size is ~150 us of work against the ~15 us a thread costs (see arcBallParallel.h)
+    static constexpr size_t minPointsPerThread = size_t{ 1 } << 17;
 }
 
 // https://github.com/offa/cpp-guards/blob/master/include/guards/ScopeGuard.h
@@ -41,35 +51,39 @@ namespace guards
 
 
 void ArcBall::Controls::mapScreenPosToArcBallPosNDC( linAlg::vec3_t& mCurrMouseNDC, const linAlg::vec2_t& relative_screenPos ) {
-    // map cursor pos to NDC and project to unit sphere for z coordinate
-    mCurrMouseNDC[0] = (2.0f * relative_screenPos[0]) - 1.0f;
-    mCurrMouseNDC[1] = 2.0f - (2.0f * relative_screenPos[1]) - 1.0f;
-
-    const float currX2 = mCurrMouseNDC[0] * mCurrMouseNDC[0];
-    const float currY2 = mCurrMouseNDC[1] * mCurrMouseNDC[1];
-
-    // http://courses.cms.caltech.edu/cs171/assignments/hw3/hw3-notes/notes-hw3.html
-    //mCurrMouseNDC[2] = (currX2 + currY2 <= 1.0f) ? sqrtf( 1.0f - currX2 - currY2 ) : 0.0f;
-    // https://www.xarg.org/2021/07/trackball-rotation-using-quaternions/
-    mCurrMouseNDC[2] = (currX2 + currY2 <= 0.5f) ? sqrtf( 1.0f - currX2 - currY2 ) : 0.5f / (sqrtf( currX2 + currY2 ));
-
-    linAlg::normalize( mCurrMouseNDC );
+    mCurrMouseNDC = screenPosToArcBallPosNDC( relative_screenPos[0], relative_screenPos[1] );
 }
 
 
 ArcBall::Controls::Controls()
-    : mDeadZone( /*practicallyZero * 1000.0f*/ 0.001f )
-    , mIsActive( true ) {
+    : mIsActive( true )
+    , mTraceRecorder( nullptr ) {
+
+    setDeadZone( /*practicallyZero * 1000.0f*/ 0.001f );
 
     resetTrafos();
 
     setInteractionMode( InteractionModeDesc{ .fullCircle = true, .smooth = true } );
 
     setRotDampingFactor( 1.0f - 0.9975f );
+    setPanDampingFactor( 1.0f ); // no pan glide - pan deltas are applied as they come in
     setMouseSensitivity( 0.866f );
     setMaxTraditionalRotDeg( 360.0f ); 
+    setLargeWorldMode( false );
+    setSettleThreshold( 0.0f );
+    setRenormThreshold( std::numeric_limits<float>::epsilon() * 4.0f );
+    resetNumericHealth();
+
+    // the view before the first update() is the identity, as resetTrafos() left it
+    mMotionViewQuat = identityQuat;
+    mMotionViewTrans = linAlg::vec3_t{ 0.0f, 0.0f, 0.0f };
+    mViewMotion = ViewMotion{ .hasViewChanged = true, .isSettled = false, .rotRadAngle = 0.0f, .eyeTranslation = 0.0f, .pivotDepth = 0.0f };
 
     mLMBheldDown = false;
+    mFixX = 0.0f;
+    mFixY = 0.0f;
+
+    mSnapshotChannel = nullptr;
 
     mStartMouseNDC = linAlg::vec3_t{ 0.0f, 0.0f, 0.0f };
     mCurrMouseNDC = linAlg::vec3_t{ 0.0f, 0.0f, 0.0f };
@@ -77,64 +91,140 @@ ArcBall::Controls::Controls()
 
 
 void ArcBall::Controls::setRotationPivotWS( const linAlg::vec3_t& pivotWSIn ) { 
+    TraceRecorder::CallScope traceScope( mTraceRecorder );
+    if (TraceRecorder* trace = traceScope.get()) { trace->recordVec3( *this, eTraceRecord::SET_ROTATION_PIVOT_WS, pivotWSIn ); }
+    ARCBALL_STAT_TIME( mStats, SET_ROTATION_PIVOT );
 
 #if 0 // STABLE!!!
     mRotationPivotPosArcSpaceWS = pivotWSIn;
 #else // UNSTABLE!!!
-    if (linAlg::dist( pivotWSIn, mRotationPivotPosArcSpaceWS ) <= std::numeric_limits<float>::epsilon() * 100.0f) { return; }
-    linAlg::vec3_t pivotWS = pivotWSIn;
-    linAlg::applyTransformationToPoint( getArcRotMat(), &pivotWS, 1 );
-    mRotationPivotPosArcSpaceWS = pivotWS;
+    if (linAlg::dist( pivotWSIn, mRotationPivotPosArcSpaceWS ) <= std::numeric_limits<float>::epsilon() * 100.0f) { 
+        ARCBALL_STAT_COUNT( mStats, PIVOT_EPSILON_SKIPS );
+        return; 
+    }
+    ARCBALL_STAT_COUNT( mStats, PIVOT_SETS );
+    mRotationPivotPosArcSpaceWS = transformPoint( getArcRotMat(), pivotWSIn );
 #endif
 }
 void ArcBall::Controls::setRotationPivotArcSpaceWS( const linAlg::vec3_t& pivotArcSpaceWS ) {
+    TraceRecorder::CallScope traceScope( mTraceRecorder );
+    if (TraceRecorder* trace = traceScope.get()) { trace->recordVec3( *this, eTraceRecord::SET_ROTATION_PIVOT_ARC_SPACE_WS, pivotArcSpaceWS ); }
+    ARCBALL_STAT_TIME( mStats, SET_ROTATION_PIVOT );
+    ARCBALL_STAT_COUNT( mStats, PIVOT_SETS );
     mRotationPivotPosArcSpaceWS = pivotArcSpaceWS;
 }
 
 
-linAlg::vec3_t ArcBall::Controls::getRotationPivotOffsetArcSpaceWS() { 
+linAlg::vec3_t ArcBall::Controls::getRotationPivotOffsetArcSpaceWS() const { 
     return mRotationPivotPosArcSpaceWS; 
 }
-linAlg::vec3_t ArcBall::Controls::getRotationPivotOffsetWS() { 
-    linAlg::mat4_t arcRotMat4;
-    linAlg::castMatrix( arcRotMat4, getArcRotMat() );
-    linAlg::mat4_t invArcRotMat4;
-    linAlg::inverse( invArcRotMat4, arcRotMat4 );
-    
-    linAlg::vec4_t pivotWS{ mRotationPivotPosArcSpaceWS[0], mRotationPivotPosArcSpaceWS[1], mRotationPivotPosArcSpaceWS[2], 1.0f };
-
-    linAlg::applyTransformationToPoint( invArcRotMat4, &pivotWS, 1 );
-    return linAlg::vec3_t{ pivotWS[0], pivotWS[1], pivotWS[2] };
+linAlg::vec3_t ArcBall::Controls::getRotationPivotOffsetWS() const { 
+    // arcRot^(-1)( pivot ) = q^(-1) * (pivot - t) - no need for the matrix, let alone a general inverse
+    const linAlg::vec4_t invQuat{ -mArcRot.quat[0], -mArcRot.quat[1], -mArcRot.quat[2], mArcRot.quat[3] };
+    return quatRotate( invQuat, mRotationPivotPosArcSpaceWS - mArcRot.trans );
 }
 
 void ArcBall::Controls::seamlessSetRotationPivotWS( const linAlg::vec3_t& pivotWSIn, const float& camTiltRadAngle, const float& camDist ) {
+    TraceRecorder::CallScope traceScope( mTraceRecorder );
+    if (TraceRecorder* trace = traceScope.get()) { trace->recordPivot( *this, eTraceRecord::SEAMLESS_SET_ROTATION_PIVOT_WS, pivotWSIn, camTiltRadAngle, camDist ); }
+    ARCBALL_STAT_TIME( mStats, SEAMLESS_SET_ROTATION_PIVOT );
     setRotationPivotWS( pivotWSIn );
     commonSeamlessSetRotationPivotWS( camTiltRadAngle, camDist );
 }
 
 void ArcBall::Controls::seamlessSetRotationPivotArcSpaceWS( const linAlg::vec3_t& pivotArcSpaceWS, const float& camTiltRadAngle, const float& camDist ) {
+    TraceRecorder::CallScope traceScope( mTraceRecorder );
+    if (TraceRecorder* trace = traceScope.get()) { trace->recordPivot( *this, eTraceRecord::SEAMLESS_SET_ROTATION_PIVOT_ARC_SPACE_WS, pivotArcSpaceWS, camTiltRadAngle, camDist ); }
+    ARCBALL_STAT_TIME( mStats, SEAMLESS_SET_ROTATION_PIVOT );
     setRotationPivotArcSpaceWS( pivotArcSpaceWS );
     commonSeamlessSetRotationPivotWS( camTiltRadAngle, camDist );
 }
 
 void ArcBall::Controls::commonSeamlessSetRotationPivotWS( const float& camTiltRadAngle, const float& camDist )
 {
-    linAlg::vec3_t prevRefPtES{ 0.0f, 0.0f, 0.0f };
-    auto viewWithoutArcMat = getViewTranslationMat() * getTiltRotMat();
+    TraceRecorder::CallScope traceScope( mTraceRecorder );
+    if (TraceRecorder* trace = traceScope.get()) { trace->recordPivot( *this, eTraceRecord::COMMON_SEAMLESS_SET_ROTATION_PIVOT_WS, linAlg::vec3_t{ 0.0f, 0.0f, 0.0f }, camTiltRadAngle, camDist ); }
 
-    linAlg::applyTransformationToPoint( viewWithoutArcMat, &prevRefPtES, 1 );
+    // where the ArcSpaceWS origin ends up in eye space before and after the pivot change - (mViewTranslationMat * mTiltRotMat) * {0,0,0} 
+    // is just the sum of the two translation columns
+    const linAlg::vec3_t prevRefPtES{ mViewTranslationMat[0][3] + mTiltRotMat[0][3], mViewTranslationMat[1][3] + mTiltRotMat[1][3], mViewTranslationMat[2][3] + mTiltRotMat[2][3] };
 
     calcViewWithoutArcMatFrameMatrices( camTiltRadAngle, { 0.0f, 0.0f, 0.0f }, camDist );
 
-    linAlg::vec3_t newRefPtES{ 0.0f, 0.0f, 0.0f };
-
-    viewWithoutArcMat = getViewTranslationMat() * getTiltRotMat();
-    linAlg::applyTransformationToPoint( viewWithoutArcMat, &newRefPtES, 1 );
+    const linAlg::vec3_t newRefPtES{ mViewTranslationMat[0][3] + mTiltRotMat[0][3], mViewTranslationMat[1][3] + mTiltRotMat[1][3], mViewTranslationMat[2][3] + mTiltRotMat[2][3] };
 
     auto panDeltaPivotCompensation = prevRefPtES - newRefPtES;
     addPanDelta( panDeltaPivotCompensation );
 }
 
+linAlg::mat3x4_t ArcBall::Controls::getCoordSpaceTransform( const eCoordSpace from, const eCoordSpace to ) const {
+    linAlg::mat3x4_t m;
+    if (from == to) {
+        linAlg::loadIdentityMatrix( m );
+    } else if (from == eCoordSpace::WS) {
+        m = (to == eCoordSpace::ARC_SPACE_WS) ? getArcRotMat() : getViewMatrix();
+    } else if (from == eCoordSpace::ARC_SPACE_WS) {
+        if (to == eCoordSpace::WS) {
+            m = getInvArcRotMat();
+        } else {
+            // mViewTranslationMat * mTiltRotMat, see expandInvViewWithoutArcMat()
+            m = mTiltRotMat;
+            for (int r = 0; r < 3; r++) {
+                m[r][3] += mViewTranslationMat[r][3];
+            }
+        }
+    } else {
+        m = (to == eCoordSpace::WS) ? getInvViewMatrix() : getInvViewWithoutArcMat();
+    }
+    return m;
+}
+
+eRetVal ArcBall::Controls::transformPoints( const eCoordSpace from, const eCoordSpace to, const std::span<const linAlg::vec3_t> in, const std::span<linAlg::vec3_t> out, 
+                                            const uint32_t numThreads ) const {
+    if (in.size() != out.size()) { return eRetVal::ERROR; }
+    return transformPoints( from, to, reinterpret_cast<const float*>( in.data() ), sizeof( linAlg::vec3_t ), reinterpret_cast<float*>( out.data() ), sizeof( linAlg::vec3_t ), 
+                            in.size(), numThreads );
+}
+
+eRetVal ArcBall::Controls::transformPoints( const eCoordSpace from, const eCoordSpace to, const float* in, const size_t inStrideBytes, float* out, const size_t outStrideBytes, 
+                                            const size_t numPoints, const uint32_t numThreads ) const {
+    if (numPoints == 0) { return eRetVal::OK; }
+    if (in == nullptr || out == nullptr || inStrideBytes < 3 * sizeof( float ) || outStrideBytes < 3 * sizeof( float )) { return eRetVal::ERROR; }
+
+    // matrices are expanded here on the calling thread, the workers only read the copy
+    const linAlg::mat3x4_t m = getCoordSpaceTransform( from, to );
+    const char* src = reinterpret_cast<const char*>( in );
+    char* dst = reinterpret_cast<char*>( out );
+    parallelForRanges( numPoints, numThreads, minPointsPerThread, [&]( const size_t start, const size_t count ) {
+        transformPointsStrided( m, reinterpret_cast<const float*>( src + start * inStrideBytes ), inStrideBytes, 
+                                reinterpret_cast<float*>( dst + start * outStrideBytes ), outStrideBytes, count );
+    } );
+    return eRetVal::OK;
+}
+
+eRetVal ArcBall::Controls::transformPoints( const eCoordSpace from, const eCoordSpace to, 
+                                            const std::span<const float> inX, const std::span<const float> inY, const std::span<const float> inZ, 
+                                            const std::span<float> outX, const std::span<float> outY, const std::span<float> outZ, const uint32_t numThreads ) const {
+    const size_t numPoints = inX.size();
+    if (inY.size() != numPoints || inZ.size() != numPoints || outX.size() != numPoints || outY.size() != numPoints || outZ.size() != numPoints) { 
+        return eRetVal::ERROR; 
+    }
+
+    const linAlg::mat3x4_t m = getCoordSpaceTransform( from, to );
+    parallelForRanges( numPoints, numThreads, minPointsPerThread, [&]( const size_t start, const size_t count ) {
+        transformPointsSoA( m, inX.data() + start, inY.data() + start, inZ.data() + start, outX.data() + start, outY.data() + start, outZ.data() + start, count );
+    } );
+    return eRetVal::OK;
+}
+
+void ArcBall::Controls::addPanDelta( const linAlg::vec3_t& delta ) {
+    TraceRecorder::CallScope traceScope( mTraceRecorder );
+    if (TraceRecorder* trace = traceScope.get()) { trace->recordVec3( *this, eTraceRecord::ADD_PAN_DELTA, delta ); }
+
+    mPanVector = mPanVector + delta;
+    mViewInputsDirty = true;
+}
+
 eRetVal ArcBall::Controls::update(  const float deltaTimeSec, 
                                     const float relMouseX, 
                                     const float relMouseY, 
@@ -146,63 +236,370 @@ eRetVal ArcBall::Controls::update(  const float deltaTimeSec,
                                     ,const bool LMBpressed
 ) {
 
-    (void)deltaTimeSec;
-
     auto scopeGuard = guards::makeScopeGuard([&]{ 
         //mPrevRelMouseX = relMouseX; 
         //mPrevRelMouseY = relMouseY;
      } );
 
+    TraceRecorder::CallScope traceScope( mTraceRecorder );
+    TraceRecorder* trace = traceScope.get();
+    if (trace != nullptr) { trace->recordUpdate( *this, deltaTimeSec, relMouseX, relMouseY, relMouse_dx, relMouse_dy, camDist, camPanDelta, camTiltRadAngle, LMBpressed ); }
+    ARCBALL_STAT_TIME( mStats, UPDATE );
+    ARCBALL_STAT_COUNT( mStats, UPDATE_CALLS );
+
+    const RigidRot arcRotBefore = mArcRot;
+    const bool LMBwasHeldDown = mLMBheldDown;
+
     calcArcMat( camTiltRadAngle, relMouseX, relMouseY, relMouse_dx, relMouse_dy, LMBpressed );
 
-    calcViewWithoutArcMatFrameMatrices( camTiltRadAngle, camPanDelta, camDist );
+    finishUpdate( deltaTimeSec, arcRotBefore, LMBwasHeldDown, camDist, camPanDelta, camTiltRadAngle );
 
-    mViewRotMat = mViewRotMat * mArcRotMat;
-    mViewMat = mViewMat * mArcRotMat;
-    
+    if (trace != nullptr && trace->recordsViewMatrices()) { trace->recordViewMatrix( getViewMatrix() ); }
+
+    return eRetVal::OK;
+}
+
+eRetVal ArcBall::Controls::ingestEvents( const float deltaTimeSec,
+                                         const std::span<const MouseEvent> events,
+                                         const float camDist,
+                                         const linAlg::vec3_t& camPanDelta,
+                                         const float camTiltRadAngle
+) {
+    // each event goes through calcArcMat() just like it would with one update() per event - the roll ref frame only 
+    // depends on the tilt so it is set up once, per event that leaves a quaternion composition; matrices are built once below
+    // checked up front - a batch that comes back with ERROR must not have touched anything
+    for (size_t i = 1; i < events.size(); i++) {
+        if (events[i].timeSec < events[i - 1].timeSec) { return eRetVal::ERROR; }
+    }
+
+    TraceRecorder::CallScope traceScope( mTraceRecorder );
+    TraceRecorder* trace = traceScope.get();
+    if (trace != nullptr) { trace->recordIngestEvents( *this, deltaTimeSec, events, camDist, camPanDelta, camTiltRadAngle ); }
+    ARCBALL_STAT_TIME( mStats, UPDATE );
+    ARCBALL_STAT_COUNT( mStats, INGEST_EVENTS_CALLS );
+
+    const RigidRot arcRotBefore = mArcRot;
+    const bool LMBwasHeldDown = mLMBheldDown;
+
+    calcRolledRefFrameMat( camTiltRadAngle );
+    for (const MouseEvent& event : events) {
+        ARCBALL_STAT_COUNT( mStats, MOUSE_EVENTS );
+
+        calcArcRot( event.relMouseX, event.relMouseY, event.relMouse_dx, event.relMouse_dy, event.LMBpressed );
+    }
+
+    finishUpdate( deltaTimeSec, arcRotBefore, LMBwasHeldDown, camDist, camPanDelta, camTiltRadAngle );
+
+    if (trace != nullptr && trace->recordsViewMatrices()) { trace->recordViewMatrix( getViewMatrix() ); }
+
+    return eRetVal::OK;
+}
+
+void ArcBall::Controls::finishUpdate( const float deltaTimeSec, const RigidRot& arcRotBefore, const bool LMBwasHeldDown, const float camDist, const linAlg::vec3_t& camPanDelta, const float camTiltRadAngle ) {
 
     ////////////////////////////
     // book keeping & updates //
     ////////////////////////////
 
-#if 0 // only for fullCircle interaction mode
-    if (mInteractionModeDesc.smooth) {
-    //if (mInteractionModeDesc.smooth && mInteractionModeDesc.fullCircle) {
-        //if (fabsf( mTargetRelativeMouse_dx ) > mDeadZone) { // prevent mTargetmouse_dx from becomming too small "#DEN => denormalized" - may have caused the weird disappearance glitch on mouse interaction
-        //    mTargetRelativeMouse_dx *= getRotDampingFactor();
-        //} else {
-        //    mTargetRelativeMouse_dx = 0.0f;
-        //}
-        //if (fabsf( mTargetRelativeMouse_dy ) > mDeadZone) { // prevent mTargetmouse_dx from becomming too small "#DEN => denormalized" - may have caused the weird disappearance glitch on mouse interaction
-        //    mTargetRelativeMouse_dy *= getRotDampingFactor();
-        //} else {
-        //    mTargetRelativeMouse_dy = 0.0f;
-        //}
-    } /*else {
-        mTargetRelativeMouse_dx = 0.0f;
-        mTargetRelativeMouse_dy = 0.0f;
-    }*/
-#endif
+    if (mIsLargeWorldMode && 
+        (linAlg::dot( mRotationPivotPosArcSpaceWS, mRotationPivotPosArcSpaceWS ) > mRebaseDist * mRebaseDist || 
+         linAlg::dot( mArcRot.trans, mArcRot.trans ) > mRebaseDist * mRebaseDist)) {
+        rebaseOrigin();
+    }
+
+    // what the mouse did to the arc - for the fling and for predictViewMatrix()
+    mInputRotVelocity = (deltaTimeSec > 0.0f) ? calcStepRotVelocity( mArcRot.quat, arcRotBefore.quat, deltaTimeSec ) : linAlg::vec3_t{ 0.0f, 0.0f, 0.0f };
+
+    updateRotInertia( deltaTimeSec, LMBwasHeldDown );
+
+    const linAlg::vec3_t panDelta = calcSmoothPanDelta( deltaTimeSec, camPanDelta );
+    const linAlg::vec3_t panVectorBefore = mPanVector;
+
+    // only rebuild what actually changed - an idle update leaves all matrices (and their inverses) alone
+    const bool arcRotChanged = (mArcRot.quat != arcRotBefore.quat || mArcRot.trans != arcRotBefore.trans);
+    const bool viewInputsChanged = mViewInputsDirty 
+                                || panDelta[0] != 0.0f || panDelta[1] != 0.0f 
+                                || camTiltRadAngle != mViewTiltRadAngle 
+                                || camDist != mViewCamDist 
+                                || mRotationPivotPosArcSpaceWS != mViewRotationPivotPosArcSpaceWS;
+
+    if (viewInputsChanged) {
+        ARCBALL_STAT_COUNT( mStats, VIEW_REBUILDS );
+        calcViewWithoutArcMatFrameMatrices( camTiltRadAngle, panDelta, camDist );
+    } else if (arcRotChanged) {
+        loadViewMatsWithoutArcRot();
+    } else {
+        ARCBALL_STAT_COUNT( mStats, IDLE_UPDATES );
+    }
+
+    if (viewInputsChanged || arcRotChanged || !(mViewMatsNeedArcRot || mViewMatsHaveArcRot)) {
+        // mViewRotMat = mViewRotMat * mArcRotMat; and mViewMat = mViewMat * mArcRotMat; happen lazily once they are read
+        mViewMatsNeedArcRot = true;
+        mInvViewMatDirty = true;
+    }
+
+    if (deltaTimeSec > 0.0f && (camPanDelta[0] != 0.0f || camPanDelta[1] != 0.0f)) {
+        mInputPanVelocity = scaleVec( linAlg::vec3_t{ mPanVector[0] - panVectorBefore[0], mPanVector[1] - panVectorBefore[1], 0.0f }, 1.0f / deltaTimeSec );
+    } else {
+        mInputPanVelocity = linAlg::vec3_t{ 0.0f, 0.0f, 0.0f };
+    }
+
+    updateViewMotion( deltaTimeSec, LMBwasHeldDown );
+
+    if (mSnapshotChannel != nullptr) {
+        mSnapshotChannel->publish( *this );
+    }
+}
+
+void ArcBall::Controls::rebaseOrigin() {
+    // move the WS origin onto the pivot (delta) and the ArcSpaceWS origin onto the pivot (p):
+    //   arcRot' = T(-p) * arcRot * T(delta), tilt around {0,0,0}, pan' = pan + p  =>  the view matrix stays the same
+    // the new state is (close to) zero, the WS shift goes into the double precision origin
+    ARCBALL_STAT_COUNT( mStats, ORIGIN_REBASES );
+
+    const linAlg::vec3_t p = mRotationPivotPosArcSpaceWS;
+    const linAlg::vec3_t delta = getRotationPivotOffsetWS();
+    for (int i = 0; i < 3; i++) {
+        mOriginWS[i] += static_cast<double>( delta[i] );
+    }
+    // the previous view in the shifted WS, so that the rebase doesn't count as motion
+    mMotionViewTrans = mMotionViewTrans + quatRotate( mMotionViewQuat, delta );
+
+    if (mInteractionModeDesc.fullCircle) {
+        mArcRot.trans = linAlg::vec3_t{ 0.0f, 0.0f, 0.0f }; // Ra * delta + ta - p, which is exactly zero with delta = Ra^(-1) * (p - ta)
+    } else {
+        // arcRot = curr * prev  =>  curr' = T(-p) * curr * T(p), prev' = T(-p) * prev * T(delta)
+        mCurrRot.trans = quatRotate( mCurrRot.quat, p ) + mCurrRot.trans - p;
+        mPrevRot.trans = quatRotate( mPrevRot.quat, delta ) + mPrevRot.trans - p;
+        mArcRot.trans = quatRotate( mCurrRot.quat, mPrevRot.trans ) + mCurrRot.trans;
+    }
+    invalidateArcRotMats();
+
+    mPanVector = mPanVector + p;
+    mRotationPivotPosArcSpaceWS = linAlg::vec3_t{ 0.0f, 0.0f, 0.0f };
+    mViewInputsDirty = true;
+}
+
+void ArcBall::Controls::updateViewMotion( const float deltaTimeSec, const bool LMBwasHeldDown ) {
+    // between two updates x_ES' = stepQuat * x_ES + stepTrans - a point at distance r from the eye moves
+    // by at most 2 * sin(angle / 2) * r + |stepTrans|, i.e. by less than angle + |stepTrans| / r rad as seen from the eye
+    const RigidRot viewRot = calcViewRigidRot( mArcRot, mPanVector );
+    const linAlg::vec4_t& viewQuat = viewRot.quat;
+    const linAlg::vec3_t& viewTrans = viewRot.trans;
+    const linAlg::vec3_t& p = mRotationPivotPosArcSpaceWS;
+    const linAlg::vec3_t pivotES{ mPanVector[0] + p[0], mPanVector[1] + p[1], mViewCamDist + mPanVector[2] + p[2] };
+
+    mViewMotion.hasViewChanged = (viewQuat != mMotionViewQuat || viewTrans != mMotionViewTrans);
+    if (mViewMotion.hasViewChanged) {
+        const linAlg::vec4_t stepQuat = quatMul( viewQuat, quatConjugate( mMotionViewQuat ) );
+        const linAlg::vec3_t stepTrans = viewTrans - quatRotate( stepQuat, mMotionViewTrans );
+        const float sinHalfAngle = sqrtf( stepQuat[0] * stepQuat[0] + stepQuat[1] * stepQuat[1] + stepQuat[2] * stepQuat[2] );
+        mViewMotion.rotRadAngle = 2.0f * atan2f( sinHalfAngle, fabsf( stepQuat[3] ) );
+        mViewMotion.eyeTranslation = sqrtf( linAlg::dot( stepTrans, stepTrans ) );
+    } else {
+        mViewMotion.rotRadAngle = 0.0f;
+        mViewMotion.eyeTranslation = 0.0f;
+    }
+    mViewMotion.pivotDepth = sqrtf( linAlg::dot( pivotES, pivotES ) );
+
+    const float motionRate = (deltaTimeSec > 0.0f) 
+                           ? (mViewMotion.rotRadAngle + mViewMotion.eyeTranslation / fmaxf( mViewMotion.pivotDepth, practicallyZero )) / deltaTimeSec 
+                           : 0.0f;
+    // not on the release step - a fling only starts moving with the next update()
+    const bool isCoasting = !mLMBheldDown && !LMBwasHeldDown && 
+                            (linAlg::dot( mRotVelocity, mRotVelocity ) > 0.0f || linAlg::dot( mPanVelocity, mPanVelocity ) > 0.0f);
+    if (isCoasting && deltaTimeSec > 0.0f && motionRate <= mSettleThreshold) {
+        // too slow to be seen - stop instead of creeping on for seconds
+        mRotVelocity = linAlg::vec3_t{ 0.0f, 0.0f, 0.0f };
+        mPanVelocity = linAlg::vec3_t{ 0.0f, 0.0f, 0.0f };
+        ARCBALL_STAT_COUNT( mStats, INERTIA_SETTLES );
+    }
+    const bool hasInertia = linAlg::dot( mRotVelocity, mRotVelocity ) > 0.0f || linAlg::dot( mPanVelocity, mPanVelocity ) > 0.0f;
+    mViewMotion.isSettled = !hasInertia && ((deltaTimeSec > 0.0f) ? motionRate <= mSettleThreshold : !mViewMotion.hasViewChanged);
+
+    mMotionViewQuat = viewQuat;
+    mMotionViewTrans = viewTrans;
+}
+
+ArcBall::Controls::RigidRot ArcBall::Controls::calcViewRigidRot( const RigidRot& arcRot, const linAlg::vec3_t& panVector ) const {
+    // view = T(pan + {0,0,camDist}) * [tilt around p] * arcRot, with the pivot p ending up at pivotES = pan + {0,0,camDist} + p
+    //   x_ES = tilt * arcRot.quat * x + pivotES + tilt * (arcRot.trans - p)
+    const float halfTilt = 0.5f * mViewTiltRadAngle;
+    const linAlg::vec4_t tiltQuat{ 0.0f, 0.0f, sinf( halfTilt ), cosf( halfTilt ) };
+    const linAlg::vec3_t& p = mRotationPivotPosArcSpaceWS;
+    const linAlg::vec3_t pivotES{ panVector[0] + p[0], panVector[1] + p[1], mViewCamDist + panVector[2] + p[2] };
+    return RigidRot{ quatMul( tiltQuat, arcRot.quat ), pivotES + quatRotate( tiltQuat, arcRot.trans - p ) };
+}
+
+void ArcBall::Controls::predictViewMatrix( const float tAheadSec, linAlg::mat3x4_t& viewMatrix ) const {
+    const linAlg::vec3_t& p = mRotationPivotPosArcSpaceWS;
+    RigidRot arcRot = mArcRot;
+    linAlg::vec3_t panVector = mPanVector;
+
+    // x' = delta * (x - p) + p on top of rot, like rotateArcAroundPivot()
+    auto rotateAroundPivot = [&p]( RigidRot& rot, const linAlg::vec3_t& velocity, const float radAngle ) {
+        const linAlg::vec4_t deltaQuat = quatFromAxisAngle( scaleVec( velocity, 1.0f / sqrtf( linAlg::dot( velocity, velocity ) ) ), radAngle );
+        rot.quat = quatMul( deltaQuat, rot.quat );
+        linAlg::normalize( rot.quat );
+        rot.trans = quatRotate( deltaQuat, rot.trans - p ) + p;
+    };
+
+    if (tAheadSec > 0.0f) {
+        const float inputRadPerSec = sqrtf( linAlg::dot( mInputRotVelocity, mInputRotVelocity ) );
+        const float coastRadPerSec = sqrtf( linAlg::dot( mRotVelocity, mRotVelocity ) );
+        if (mLMBheldDown && inputRadPerSec > 0.0f) {
+            // dragging - the hand is assumed to keep going like it did during the last update()
+            rotateAroundPivot( arcRot, mInputRotVelocity, inputRadPerSec * tAheadSec );
+        } else if (!mLMBheldDown && mInteractionModeDesc.smooth && coastRadPerSec > minInertiaVelocity<float>) {
+            // coasting - exactly what the next update()s will do without input
+            float radPerSec = coastRadPerSec;
+            const float radAngle = integrateExpDecay( radPerSec, mRotDampingFactor, tAheadSec );
+            if (mInteractionModeDesc.fullCircle) {
+                rotateAroundPivot( arcRot, mRotVelocity, radAngle );
+            } else {
+                RigidRot prevRot = mPrevRot;
+                rotateAroundPivot( prevRot, mRotVelocity, radAngle );
+                arcRot.quat = quatMul( mCurrRot.quat, prevRot.quat );
+                linAlg::normalize( arcRot.quat );
+                arcRot.trans = quatRotate( mCurrRot.quat, prevRot.trans ) + mCurrRot.trans;
+            }
+        }
 
+        const float coastPanSpeed = sqrtf( mPanVelocity[0] * mPanVelocity[0] + mPanVelocity[1] * mPanVelocity[1] );
+        if (mInputPanVelocity[0] != 0.0f || mInputPanVelocity[1] != 0.0f) {
+            panVector[0] += mInputPanVelocity[0] * tAheadSec;
+            panVector[1] += mInputPanVelocity[1] * tAheadSec;
+        } else if (mInteractionModeDesc.smooth && coastPanSpeed > minInertiaVelocity<float>) {
+            float panSpeed = coastPanSpeed;
+            const float panDist = integrateExpDecay( panSpeed, mPanDampingFactor, tAheadSec );
+            panVector[0] += mPanVelocity[0] / coastPanSpeed * panDist;
+            panVector[1] += mPanVelocity[1] / coastPanSpeed * panDist;
+        }
+    }
+
+    const RigidRot viewRot = calcViewRigidRot( arcRot, panVector );
+    loadRotTransMatrix( viewMatrix, viewRot.quat, viewRot.trans );
+}
 
+eRetVal ArcBall::Controls::latchViewMatrix( const float lateDeltaTimeSec, const std::span<const MouseEvent> lateEvents, const linAlg::vec3_t& lateCamPanDelta, 
+                                            const float tAheadSec, linAlg::mat3x4_t& viewMatrix ) const {
+    ARCBALL_STAT_TIME( mStats, LATCH_VIEW_MATRIX );
+    ARCBALL_STAT_COUNT( mStats, LATCH_VIEW_MATRIX_CALLS );
+
+    // run the late input through a scratch copy - neither published, traced nor counted, the real update() will see the same input again
+    Controls latched( *this );
+    latched.mSnapshotChannel = nullptr;
+    latched.mTraceRecorder = nullptr;
+    ARCBALL_STAT_EXPR( latched.mStats.isSuspended = true );
+    if (latched.ingestEvents( lateDeltaTimeSec, lateEvents, mViewCamDist, lateCamPanDelta, mViewTiltRadAngle ) != eRetVal::OK) { return eRetVal::ERROR; }
+    latched.predictViewMatrix( tAheadSec, viewMatrix );
     return eRetVal::OK;
 }
 
+void ArcBall::Controls::rotateArcAroundPivot( const linAlg::vec4_t& deltaQuat ) {
+    // x' = delta * (arcRot(x) - pivot) + pivot
+    // traditional mode: goes into the rotation of the finished drags, the current drag stays on top of it
+    RigidRot& rot = (mInteractionModeDesc.fullCircle) ? mArcRot : mPrevRot;
+    rot.quat = quatMul( deltaQuat, rot.quat );
+    renormalizeAccumulatedQuat( rot.quat );
+    rot.trans = quatRotate( deltaQuat, rot.trans - mRotationPivotPosArcSpaceWS ) + mRotationPivotPosArcSpaceWS;
+
+    if (!mInteractionModeDesc.fullCircle) {
+        mArcRot.quat = quatMul( mCurrRot.quat, mPrevRot.quat );
+        linAlg::normalize( mArcRot.quat );
+        mArcRot.trans = quatRotate( mCurrRot.quat, mPrevRot.trans ) + mCurrRot.trans;
+    }
+    invalidateArcRotMats();
+}
+
+void ArcBall::Controls::renormalizeAccumulatedQuat( linAlg::vec4_t& quat ) {
+    const float absNormError = renormalizeQuat( quat, mRenormThreshold );
+    ARCBALL_STAT_EXPR( mStats.maxArcQuatNormError = fmaxf( mStats.maxArcQuatNormError, absNormError ) );
+    mNumericHealth.arcQuatNormError = absNormError;
+    mNumericHealth.maxArcQuatNormError = fmaxf( mNumericHealth.maxArcQuatNormError, absNormError );
+    mNumericHealth.numCompositions++;
+    if (absNormError > mRenormThreshold) {
+        mNumericHealth.numCorrections++;
+    }
+}
+
+void ArcBall::Controls::resetNumericHealth() {
+    mNumericHealth = NumericHealth{ .arcQuatNormError = 0.0f, .maxArcQuatNormError = 0.0f, .numCompositions = 0, .numCorrections = 0 };
+}
+
+void ArcBall::Controls::updateRotInertia( const float deltaTimeSec, const bool LMBwasHeldDown ) {
+    if (!mInteractionModeDesc.smooth || deltaTimeSec <= 0.0f) {
+        mRotVelocity = linAlg::vec3_t{ 0.0f, 0.0f, 0.0f };
+        return;
+    }
+
+    if (LMBwasHeldDown || mLMBheldDown) { 
+        // dragging - track the angular velocity the drag had when it last moved
+        if (mInputRotVelocity[0] != 0.0f || mInputRotVelocity[1] != 0.0f || mInputRotVelocity[2] != 0.0f) {
+            mDragRotVelocity = mInputRotVelocity;
+            mTimeSinceDragMotionSec = 0.0f;
+        } else {
+            mTimeSinceDragMotionSec += deltaTimeSec;
+        }
+
+        mRotVelocity = linAlg::vec3_t{ 0.0f, 0.0f, 0.0f };
+        if (LMBwasHeldDown && !mLMBheldDown && mTimeSinceDragMotionSec <= flingTimeoutSec<float>) { // released => fling
+            mRotVelocity = mDragRotVelocity;
+        }
+        return;
+    }
+
+    // coasting - angular velocity decays exponentially around a fixed axis, so the covered angle is known in closed form
+    float radPerSec = sqrtf( linAlg::dot( mRotVelocity, mRotVelocity ) );
+    if (radPerSec <= minInertiaVelocity<float>) {
+        mRotVelocity = linAlg::vec3_t{ 0.0f, 0.0f, 0.0f };
+        return;
+    }
+    const linAlg::vec3_t axis = scaleVec( mRotVelocity, 1.0f / radPerSec );
+    const float radAngle = integrateExpDecay( radPerSec, mRotDampingFactor, deltaTimeSec );
+    mRotVelocity = scaleVec( axis, radPerSec );
+
+    rotateArcAroundPivot( quatFromAxisAngle( axis, radAngle ) );
+}
+
+linAlg::vec3_t ArcBall::Controls::calcSmoothPanDelta( const float deltaTimeSec, const linAlg::vec3_t& camPanDelta ) {
+    if (!mInteractionModeDesc.smooth || deltaTimeSec <= 0.0f) {
+        mPanVelocity = linAlg::vec3_t{ 0.0f, 0.0f, 0.0f };
+        return camPanDelta;
+    }
+
+    if (camPanDelta[0] != 0.0f || camPanDelta[1] != 0.0f) {
+        // panning - remember the speed so that the pan can glide on once the deltas stop coming in
+        mPanVelocity = scaleVec( camPanDelta, 1.0f / deltaTimeSec );
+        return camPanDelta;
+    }
+
+    float panSpeed = sqrtf( mPanVelocity[0] * mPanVelocity[0] + mPanVelocity[1] * mPanVelocity[1] );
+    if (panSpeed <= minInertiaVelocity<float>) {
+        mPanVelocity = linAlg::vec3_t{ 0.0f, 0.0f, 0.0f };
+        return camPanDelta;
+    }
+    const linAlg::vec3_t panDir{ mPanVelocity[0] / panSpeed, mPanVelocity[1] / panSpeed, 0.0f };
+    const float panDist = integrateExpDecay( panSpeed, mPanDampingFactor, deltaTimeSec );
+    mPanVelocity = scaleVec( panDir, panSpeed );
+
+    return linAlg::vec3_t{ panDir[0] * panDist, panDir[1] * panDist, camPanDelta[2] };
+}
+
 void ArcBall::Controls::calcViewWithoutArcMatFrameMatrices( const float camTiltRadAngle, const linAlg::vec3_t& camPanDelta, const float camDist )
 {
+    TraceRecorder::CallScope traceScope( mTraceRecorder );
+    if (TraceRecorder* trace = traceScope.get()) { trace->recordCalcViewWithoutArcMatFrameMatrices( *this, camTiltRadAngle, camPanDelta, camDist ); }
+
     linAlg::loadRotationZMatrix( mTiltRotMat, camTiltRadAngle );
 
 #if 1 // works (up to small jumps when resetting pivot anker pos); uses transform from last frame (seems to be okay as well)
-    linAlg::mat3x4_t pivotTranslationMatrix;
-    auto pivotTranslationPos = linAlg::vec3_t{ -mRotationPivotPosArcSpaceWS[0], -mRotationPivotPosArcSpaceWS[1], -mRotationPivotPosArcSpaceWS[2] };
-    linAlg::loadTranslationMatrix( pivotTranslationMatrix, pivotTranslationPos );
-    linAlg::mat3x4_t invPivotTranslationMatrix;
-    auto invPivotTranslationPos = linAlg::vec3_t{ -pivotTranslationPos[0], -pivotTranslationPos[1], -pivotTranslationPos[2] };
-    linAlg::loadTranslationMatrix( invPivotTranslationMatrix, invPivotTranslationPos );
-    mTiltRotMat = invPivotTranslationMatrix * mTiltRotMat * pivotTranslationMatrix;
+    // T(pivot) * tiltRot * T(-pivot) - rotation part stays, translation becomes pivot - tiltRot * pivot
+    const linAlg::vec3_t& p = mRotationPivotPosArcSpaceWS;
+    for (int r = 0; r < 3; r++) {
+        mTiltRotMat[r][3] = p[r] - (mTiltRotMat[r][0] * p[0] + mTiltRotMat[r][1] * p[1] + mTiltRotMat[r][2] * p[2]);
+    }
 #endif
-    
-    mViewRotMat = mTiltRotMat;
 
     if (mInteractionModeDesc.smooth) {
         mPanVector[0] += camPanDelta[0];
@@ -215,12 +612,80 @@ void ArcBall::Controls::calcViewWithoutArcMatFrameMatrices( const float camTiltR
 
     linAlg::loadTranslationMatrix( mViewTranslationMat, panVec3 );
 
-    mViewMat = mViewTranslationMat * mViewRotMat;
+    loadViewMatsWithoutArcRot();
+    mViewMatsNeedArcRot = false;
+    mInvViewMatDirty = true;
+    mInvViewWithoutArcMatDirty = true;
+
+    mViewTiltRadAngle = camTiltRadAngle;
+    mViewCamDist = camDist;
+    mViewRotationPivotPosArcSpaceWS = mRotationPivotPosArcSpaceWS;
+    mViewInputsDirty = false;
+}
+
+void ArcBall::Controls::loadViewMatsWithoutArcRot() {
+    // mViewTranslationMat is a pure translation, so mViewTranslationMat * mTiltRotMat just adds up the translations
+    mViewMatsHaveArcRot = false;
+    mViewRotMat = mTiltRotMat;
+    mViewMat = mTiltRotMat;
+    for (int r = 0; r < 3; r++) {
+        mViewMat[r][3] += mViewTranslationMat[r][3];
+    }
+}
+
+void ArcBall::Controls::invalidateArcRotMats() {
+    mArcRotMatDirty = true;
+    mInvArcRotMatDirty = true;
+}
+
+void ArcBall::Controls::expandInvArcRotMat() const {
+    // R^T and -R^T * t, straight from the conjugate quaternion
+    const linAlg::vec4_t invQuat{ -mArcRot.quat[0], -mArcRot.quat[1], -mArcRot.quat[2], mArcRot.quat[3] };
+    const linAlg::vec3_t invTrans = quatRotate( invQuat, linAlg::vec3_t{ -mArcRot.trans[0], -mArcRot.trans[1], -mArcRot.trans[2] } );
+    loadRotTransMatrix( mInvArcRotMat, invQuat, invTrans );
+    mInvArcRotMatDirty = false;
+}
+
+void ArcBall::Controls::expandInvViewMat() const {
+    loadRigidInverse( mInvViewMat, getViewMatrix() );
+    mInvViewMatDirty = false;
+}
+
+void ArcBall::Controls::expandInvViewWithoutArcMat() const {
+    linAlg::mat3x4_t viewWithoutArcMat = mTiltRotMat;
+    for (int r = 0; r < 3; r++) {
+        viewWithoutArcMat[r][3] += mViewTranslationMat[r][3];
+    }
+    loadRigidInverse( mInvViewWithoutArcMat, viewWithoutArcMat );
+    mInvViewWithoutArcMatDirty = false;
+}
+
+void ArcBall::Controls::expandArcRotMat() const {
+    loadRotTransMatrix( mArcRotMat, mArcRot.quat, mArcRot.trans );
+    mArcRotMatDirty = false;
+}
+
+void ArcBall::Controls::applyArcRotToViewMats() const {
+    const linAlg::mat3x4_t& arcRotMat = getArcRotMat();
+    mulAffine( mViewRotMat, mViewRotMat, arcRotMat );
+    mulAffine( mViewMat, mViewMat, arcRotMat );
+    mViewMatsNeedArcRot = false;
+    mViewMatsHaveArcRot = true;
 }
 
 void ArcBall::Controls::calcArcMat( const float camTiltRadAngle, const float relMouseX, const float relMouseY, const float mouse_dx, const float mouse_dy
     , const bool LMBpressed 
     ) {
+    TraceRecorder::CallScope traceScope( mTraceRecorder );
+    if (TraceRecorder* trace = traceScope.get()) { trace->recordCalcArcMat( *this, camTiltRadAngle, relMouseX, relMouseY, mouse_dx, mouse_dy, LMBpressed ); }
+
+    calcRolledRefFrameMat( camTiltRadAngle );
+    calcArcRot( relMouseX, relMouseY, mouse_dx, mouse_dy, LMBpressed );
+}
+
+void ArcBall::Controls::calcRolledRefFrameMat( const float camTiltRadAngle ) {
+    if (camTiltRadAngle == mRefFrameTiltRadAngle) { return; }
+
     linAlg::mat3_t rolledRefFrameMatT;
     {
         linAlg::mat3x4_t camRollMat;
@@ -241,7 +706,10 @@ void ArcBall::Controls::calcArcMat( const float camTiltRadAngle, const float rel
 
         setRefFrameMat( rolledRefFrameMatT );
     }
+    mRefFrameTiltRadAngle = camTiltRadAngle;
+}
 
+void ArcBall::Controls::calcArcRot( const float relMouseX, const float relMouseY, const float mouse_dx, const float mouse_dy, const bool LMBpressed ) {
     float relMouseDelta = sqrtf( mouse_dx * mouse_dx + mouse_dy * mouse_dy );
     if (!mLMBheldDown || relMouseDelta <= mDeadZone) {
         relMouseDelta = 0.0f;
@@ -263,34 +731,24 @@ void ArcBall::Controls::calcArcMat( const float camTiltRadAngle, const float rel
             float cosAngle = linAlg::dot( mStartMouseNDC, mCurrMouseNDC );
             assert( cosAngle > 0.0 );
             if (cosAngle < 1.0f - std::numeric_limits<float>::epsilon()) {
-                const float cosMousePtDirs = linAlg::minimum( 1.0f, cosAngle ); // <= 1.0 so that arccos doesn't freak out
-                const float radMousePtDir = acosf( cosMousePtDirs );
-                if (fabsf( radMousePtDir > mDeadZone ))
+                if (cosAngle < mCosDeadZone) // same as acos( cosAngle ) > mDeadZone
                 {
                     linAlg::vec3_t normMousePtDirs;
                     linAlg::cross( normMousePtDirs, mStartMouseNDC, mCurrMouseNDC );
-                    linAlg::normalize( normMousePtDirs );
 
-                    linAlg::mat3x4_t rotArcBallDeltaMat;
+                    // bring rotation vector into ref frame (mRefFrameMat is orthonormal, so the length - sin of the angle - is kept)
+                    normMousePtDirs = transformVector( mRefFrameMat, normMousePtDirs );
 
-                    // bring rotation vector into ref frame
-                    linAlg::applyTransformationToPoint( mRefFrameMat, &normMousePtDirs, 1 );
-                    linAlg::normalize( normMousePtDirs );
+                    linAlg::vec4_t rotArcBallDeltaQuat{ normMousePtDirs[0], normMousePtDirs[1], normMousePtDirs[2], 1.0f + cosAngle };
+                    linAlg::normalize( rotArcBallDeltaQuat );
 
-                    linAlg::loadRotationAroundAxis( rotArcBallDeltaMat, normMousePtDirs, radMousePtDir );
-
-                #if 1
-                    linAlg::mat3x4_t pivotTranslationMatrix;
-                    linAlg::loadTranslationMatrix( pivotTranslationMatrix, linAlg::vec3_t{ -mRotationPivotPosArcSpaceWS[0], -mRotationPivotPosArcSpaceWS[1], -mRotationPivotPosArcSpaceWS[2] } );
-                    linAlg::mat3x4_t invPivotTranslationMatrix;
-                    linAlg::loadTranslationMatrix( invPivotTranslationMatrix, mRotationPivotPosArcSpaceWS );
-                    rotArcBallDeltaMat = invPivotTranslationMatrix * rotArcBallDeltaMat * pivotTranslationMatrix;
-                #endif
-
-                    linAlg::mat3x4_t tmpLastRotMat;
-                    linAlg::multMatrix( tmpLastRotMat, rotArcBallDeltaMat, mArcRotMat );
-                    mArcRotMat = tmpLastRotMat;
+                    rotateArcAroundPivot( rotArcBallDeltaQuat );
+                    ARCBALL_STAT_COUNT( mStats, ARC_ROTATIONS );
+                } else {
+                    ARCBALL_STAT_COUNT( mStats, ARC_DEAD_ZONE_SKIPS );
                 }
+            } else {
+                ARCBALL_STAT_COUNT( mStats, ARC_NO_MOTION_SKIPS );
             }
         }
 
@@ -306,40 +764,32 @@ void ArcBall::Controls::calcArcMat( const float camTiltRadAngle, const float rel
 
     } else { // Traditional Arcball - works, but doesn't spin more than 180° in any dir
 
-        static float fixX = 0.0f;
-        static float fixY = 0.0f;
+        bool currOrPrevRotChanged = false;
 
         if ( mLMBheldDown /* || relMouseDelta > mDeadZone */) {
             //printf( "LMB is down\n" );
             
-            fixX += mouse_dx;
-            fixY += mouse_dy;
-            ArcBall::Controls::mapScreenPosToArcBallPosNDC( mCurrMouseNDC, linAlg::vec2_t{ fixX, fixY } );
+            mFixX += mouse_dx;
+            mFixY += mouse_dy;
+            ArcBall::Controls::mapScreenPosToArcBallPosNDC( mCurrMouseNDC, linAlg::vec2_t{ mFixX, mFixY } );
 
             linAlg::normalize( mCurrMouseNDC );
 
-            linAlg::applyTransformationToPoint( mRefFrameMat, &mCurrMouseNDC, 1 );
+            mCurrMouseNDC = transformVector( mRefFrameMat, mCurrMouseNDC );
 
             linAlg::normalize( mCurrMouseNDC );
 
             float cosAngle = linAlg::dot( mStartMouseNDC, mCurrMouseNDC );
             if (cosAngle < 1.0f - std::numeric_limits<float>::epsilon() * 100.0f) {
-                const float cosMousePtDirs = linAlg::minimum( 0.9999999f, cosAngle ); // <= 1.0 so that arccos doesn't freak out
-                const float radMousePtDir = acosf( cosMousePtDirs ) * (mMaxTraditionalRotDeg * (1.0f / 180.0f));
-                linAlg::vec3_t normMousePtDirs;
-                linAlg::cross( normMousePtDirs, mStartMouseNDC, mCurrMouseNDC );
-                linAlg::normalize( normMousePtDirs );
-
-                // bring rotation vector into ref frame
-                linAlg::loadRotationAroundAxis( mCurrRotMat, normMousePtDirs, radMousePtDir );
-
-            #if 1
-                linAlg::mat3x4_t pivotTranslationMatrix;
-                linAlg::loadTranslationMatrix( pivotTranslationMatrix, linAlg::vec3_t{ -mRotationPivotPosArcSpaceWS[0], -mRotationPivotPosArcSpaceWS[1], -mRotationPivotPosArcSpaceWS[2] } );
-                linAlg::mat3x4_t invPivotTranslationMatrix;
-                linAlg::loadTranslationMatrix( invPivotTranslationMatrix, mRotationPivotPosArcSpaceWS );
-                mCurrRotMat = invPivotTranslationMatrix * mCurrRotMat * pivotTranslationMatrix;
-            #endif
+                currOrPrevRotChanged = true;
+                // angle gets scaled by (mMaxTraditionalRotDeg / 180) - for the default of 360° that is just squaring the quaternion
+                mCurrRot.quat = quatPow( quatFromTwoUnitVectors( mStartMouseNDC, mCurrMouseNDC ), mMaxTraditionalRotDeg * (1.0f / 180.0f) );
+
+                // rotate around pivot
+                mCurrRot.trans = mRotationPivotPosArcSpaceWS - quatRotate( mCurrRot.quat, mRotationPivotPosArcSpaceWS );
+                ARCBALL_STAT_COUNT( mStats, ARC_ROTATIONS );
+            } else {
+                ARCBALL_STAT_COUNT( mStats, ARC_NO_MOTION_SKIPS );
             }
         }
 
@@ -348,37 +798,47 @@ void ArcBall::Controls::calcArcMat( const float camTiltRadAngle, const float rel
 
             ArcBall::Controls::mapScreenPosToArcBallPosNDC( mStartMouseNDC, linAlg::vec2_t{ relMouseX, relMouseY} );
 
-            linAlg::applyTransformationToPoint( mRefFrameMat, &mStartMouseNDC, 1 );
+            mStartMouseNDC = transformVector( mRefFrameMat, mStartMouseNDC );
             linAlg::normalize( mStartMouseNDC );
 
-            fixX = relMouseX;
-            fixY = relMouseY;
+            mFixX = relMouseX;
+            mFixY = relMouseY;
                             
             mLMBheldDown = true;
         }
 
         if (mLMBheldDown && !LMBpressed && relMouseDelta <= mDeadZone) {
             //printf( "LMB released\n" );
+            currOrPrevRotChanged = true;
 
-            linAlg::mat3x4_t tmpLastRotMat;
-            linAlg::multMatrix( tmpLastRotMat, mCurrRotMat, mPrevRotMat );
-            mPrevRotMat = tmpLastRotMat;
-            linAlg::loadIdentityMatrix( mCurrRotMat );
+            mPrevRot.trans = quatRotate( mCurrRot.quat, mPrevRot.trans ) + mCurrRot.trans;
+            mPrevRot.quat = quatMul( mCurrRot.quat, mPrevRot.quat );
+            renormalizeAccumulatedQuat( mPrevRot.quat );
+            mCurrRot = RigidRot{ identityQuat, linAlg::vec3_t{ 0.0f, 0.0f, 0.0f } };
             mLMBheldDown = false;
 
-            fixX = 0.0f;
-            fixY = 0.0f;
+            mFixX = 0.0f;
+            mFixY = 0.0f;
         }
 
-        linAlg::multMatrix( mArcRotMat, mCurrRotMat, mPrevRotMat );
+        if (currOrPrevRotChanged) {
+            mArcRot.quat = quatMul( mCurrRot.quat, mPrevRot.quat );
+            linAlg::normalize( mArcRot.quat );
+            mArcRot.trans = quatRotate( mCurrRot.quat, mPrevRot.trans ) + mCurrRot.trans;
+            invalidateArcRotMats();
+        }
     }
 }
 
-void ArcBall::Controls::setViewMatrix( const linAlg::mat3x4_t& viewMatrix ) {
+void ArcBall::Controls::setViewMatrix( const linAlg::mat3x4_t& viewMatrixIn ) {
+    TraceRecorder::CallScope traceScope( mTraceRecorder );
+    if (TraceRecorder* trace = traceScope.get()) { trace->recordMat3x4( *this, eTraceRecord::SET_VIEW_MATRIX, viewMatrixIn ); }
 
+    const linAlg::mat3x4_t viewMatrix = viewMatrixIn; // may be getViewMatrix(), which resetTrafos() overwrites
     resetTrafos();
 
     mViewMat = viewMatrix;
+    mInvViewMatDirty = true;
 
     // extract only rotational part
     linAlg::mat3x4_t rotOnlyMat = viewMatrix;
@@ -391,32 +851,247 @@ void ArcBall::Controls::setViewMatrix( const linAlg::mat3x4_t& viewMatrix ) {
     linAlg::mat3_t invRotOnlyMat3;
     linAlg::transpose(invRotOnlyMat3, rotOnlyMat3);
 
-    mCurrRotMat = rotOnlyMat;
+    mCurrRot = RigidRot{ quatFromRotMat( rotOnlyMat ), linAlg::vec3_t{ 0.0f, 0.0f, 0.0f } };
+    if (!mInteractionModeDesc.fullCircle) {
+        mArcRot = mCurrRot;
+        invalidateArcRotMats();
+    }
 
     mPanVector = { viewMatrix[0][3], viewMatrix[1][3], viewMatrix[2][3] };
 }
 
+void ArcBall::Controls::setViewMatrix( const linAlg::mat3x4_t& viewMatrixIn, const linAlg::vec3_t& pivotWS, const float camTiltRadAngle, const float camDist ) {
+    TraceRecorder::CallScope traceScope( mTraceRecorder );
+    if (TraceRecorder* trace = traceScope.get()) { trace->recordSetViewMatrixAroundPivot( *this, viewMatrixIn, pivotWS, camTiltRadAngle, camDist ); }
+
+    const linAlg::mat3x4_t viewMatrix = viewMatrixIn; // see above
+    const std::array<double, 3> originWS = mOriginWS; // viewMatrix is relative to it
+    resetTrafos();
+    mOriginWS = originWS;
+
+    // with the pivot as ArcSpaceWS origin, viewMatrix = T(pan + {0,0,camDist}) * tiltRot * arcRot becomes
+    //   arcRot(x) = (tiltRot^(-1) * viewRot) * (x - pivotWS)  and  pan = viewMatrix * pivotWS - {0,0,camDist}
+    linAlg::mat3x4_t rotOnlyMat = viewMatrix;
+    rotOnlyMat[0][3] = 0.0f;
+    rotOnlyMat[1][3] = 0.0f;
+    rotOnlyMat[2][3] = 0.0f;
+    const float halfTilt = 0.5f * camTiltRadAngle;
+    const linAlg::vec4_t tiltQuat{ 0.0f, 0.0f, sinf( halfTilt ), cosf( halfTilt ) };
+
+    RigidRot rot;
+    rot.quat = quatMul( quatConjugate( tiltQuat ), quatFromRotMat( rotOnlyMat ) );
+    linAlg::normalize( rot.quat );
+    rot.trans = scaleVec( quatRotate( rot.quat, pivotWS ), -1.0f );
+    mArcRot = rot;
+    if (!mInteractionModeDesc.fullCircle) {
+        mPrevRot = rot; // finished drags
+    }
+    invalidateArcRotMats();
+
+    const linAlg::vec3_t pivotES = transformPoint( viewMatrix, pivotWS );
+    mPanVector = linAlg::vec3_t{ pivotES[0], pivotES[1], pivotES[2] - camDist };
+
+    calcViewWithoutArcMatFrameMatrices( camTiltRadAngle, linAlg::vec3_t{ 0.0f, 0.0f, 0.0f }, camDist );
+    mViewMatsNeedArcRot = true;
+    mInvViewMatDirty = true;
+}
+
 void ArcBall::Controls::setRefFrameMat( const linAlg::mat3_t& refFrameMat ) {
+    TraceRecorder::CallScope traceScope( mTraceRecorder );
+    if (TraceRecorder* trace = traceScope.get()) { trace->recordMat3( *this, eTraceRecord::SET_REF_FRAME_MAT, refFrameMat ); }
+
     mRefFrameMat = refFrameMat;
-    linAlg::orthogonalize( mRefFrameMat );
+    orthonormalize( mRefFrameMat );
+    mRefFrameTiltRadAngle = std::numeric_limits<float>::quiet_NaN(); // not one of ours anymore
+}
+
+static_assert( std::is_trivially_copyable_v<ArcBall::Controls::State>, "Controls::State has to stay a plain block of bytes" );
+
+void ArcBall::Controls::saveState( State& state ) const {
+    // field by field into the zeroed block - struct assignments may copy whatever is in the padding of the source
+    // (the sizes catch members added to the nested structs but not below)
+    static_assert( sizeof( RigidRot ) == 7 * sizeof( float ) && sizeof( InteractionModeDesc ) == 2 * sizeof( bool ) && sizeof( ViewMotion ) == 4 * sizeof( float ) );
+    memset( &state, 0, sizeof( state ) );
+    state.version = State::formatVersion;
+
+    state.interactionModeDesc.fullCircle = mInteractionModeDesc.fullCircle;
+    state.interactionModeDesc.smooth = mInteractionModeDesc.smooth;
+    state.mouseSensitivity = mMouseSensitivity;
+    state.rotDampingFactor = mRotDampingFactor;
+    state.panDampingFactor = mPanDampingFactor;
+    state.deadZone = mDeadZone;
+    state.maxTraditionalRotDeg = mMaxTraditionalRotDeg;
+    state.settleThreshold = mSettleThreshold;
+    state.renormThreshold = mRenormThreshold;
+    state.rebaseDist = mRebaseDist;
+    state.isLargeWorldMode = mIsLargeWorldMode;
+    state.isActive = mIsActive;
+
+    state.arcRot.quat = mArcRot.quat;
+    state.arcRot.trans = mArcRot.trans;
+    state.currRot.quat = mCurrRot.quat;
+    state.currRot.trans = mCurrRot.trans;
+    state.prevRot.quat = mPrevRot.quat;
+    state.prevRot.trans = mPrevRot.trans;
+    state.panVector = mPanVector;
+    state.rotationPivotPosArcSpaceWS = mRotationPivotPosArcSpaceWS;
+    state.originWS = mOriginWS;
+    state.refFrameMat = mRefFrameMat;
+    state.refFrameTiltRadAngle = mRefFrameTiltRadAngle;
+
+    // with the lazily pending arc rotation applied, so the pending flag doesn't have to be saved
+    state.tiltRotMat = mTiltRotMat;
+    state.viewTranslationMat = mViewTranslationMat;
+    state.viewRotMat = getViewRotMat();
+    state.viewMat = getViewMatrix();
+    state.viewMatsHaveArcRot = mViewMatsHaveArcRot;
+    state.viewInputsDirty = mViewInputsDirty;
+    state.viewTiltRadAngle = mViewTiltRadAngle;
+    state.viewCamDist = mViewCamDist;
+    state.viewRotationPivotPosArcSpaceWS = mViewRotationPivotPosArcSpaceWS;
+
+    state.rotVelocity = mRotVelocity;
+    state.dragRotVelocity = mDragRotVelocity;
+    state.timeSinceDragMotionSec = mTimeSinceDragMotionSec;
+    state.panVelocity = mPanVelocity;
+    state.inputRotVelocity = mInputRotVelocity;
+    state.inputPanVelocity = mInputPanVelocity;
+
+    state.motionViewQuat = mMotionViewQuat;
+    state.motionViewTrans = mMotionViewTrans;
+    state.viewMotion.hasViewChanged = mViewMotion.hasViewChanged;
+    state.viewMotion.isSettled = mViewMotion.isSettled;
+    state.viewMotion.rotRadAngle = mViewMotion.rotRadAngle;
+    state.viewMotion.eyeTranslation = mViewMotion.eyeTranslation;
+    state.viewMotion.pivotDepth = mViewMotion.pivotDepth;
+
+    state.startMouseNDC = mStartMouseNDC;
+    state.currMouseNDC = mCurrMouseNDC;
+    state.fixX = mFixX;
+    state.fixY = mFixY;
+    state.LMBheldDown = mLMBheldDown;
+}
+
+eRetVal ArcBall::Controls::restoreState( const State& state ) {
+    if (state.version != State::formatVersion) { return eRetVal::ERROR; }
+
+    TraceRecorder::CallScope traceScope( mTraceRecorder );
+    if (TraceRecorder* trace = traceScope.get()) { trace->recordState( *this, state ); }
+
+    mInteractionModeDesc = state.interactionModeDesc;
+    mMouseSensitivity = state.mouseSensitivity;
+    mRotDampingFactor = state.rotDampingFactor;
+    mPanDampingFactor = state.panDampingFactor;
+    setDeadZone( state.deadZone );
+    mMaxTraditionalRotDeg = state.maxTraditionalRotDeg;
+    mSettleThreshold = state.settleThreshold;
+    mRenormThreshold = state.renormThreshold;
+    mRebaseDist = state.rebaseDist;
+    mIsLargeWorldMode = state.isLargeWorldMode;
+    mIsActive = state.isActive;
+
+    mArcRot = state.arcRot;
+    mCurrRot = state.currRot;
+    mPrevRot = state.prevRot;
+    mPanVector = state.panVector;
+    mRotationPivotPosArcSpaceWS = state.rotationPivotPosArcSpaceWS;
+    mOriginWS = state.originWS;
+    mRefFrameMat = state.refFrameMat;
+    mRefFrameTiltRadAngle = state.refFrameTiltRadAngle;
+
+    mTiltRotMat = state.tiltRotMat;
+    mViewTranslationMat = state.viewTranslationMat;
+    mViewRotMat = state.viewRotMat;
+    mViewMat = state.viewMat;
+    mViewMatsNeedArcRot = false;
+    mViewMatsHaveArcRot = state.viewMatsHaveArcRot;
+    mViewInputsDirty = state.viewInputsDirty;
+    mViewTiltRadAngle = state.viewTiltRadAngle;
+    mViewCamDist = state.viewCamDist;
+    mViewRotationPivotPosArcSpaceWS = state.viewRotationPivotPosArcSpaceWS;
+    invalidateArcRotMats();
+    mInvViewMatDirty = true;
+    mInvViewWithoutArcMatDirty = true;
+
+    mRotVelocity = state.rotVelocity;
+    mDragRotVelocity = state.dragRotVelocity;
+    mTimeSinceDragMotionSec = state.timeSinceDragMotionSec;
+    mPanVelocity = state.panVelocity;
+    mInputRotVelocity = state.inputRotVelocity;
+    mInputPanVelocity = state.inputPanVelocity;
+
+    mMotionViewQuat = state.motionViewQuat;
+    mMotionViewTrans = state.motionViewTrans;
+    mViewMotion = state.viewMotion;
+
+    mStartMouseNDC = state.startMouseNDC;
+    mCurrMouseNDC = state.currMouseNDC;
+    mFixX = state.fixX;
+    mFixY = state.fixY;
+    mLMBheldDown = state.LMBheldDown;
+
+    return eRetVal::OK;
 }
 
 void ArcBall::Controls::resetTrafos() {
+    TraceRecorder::CallScope traceScope( mTraceRecorder );
+    if (TraceRecorder* trace = traceScope.get()) { trace->recordNoArgs( *this, eTraceRecord::RESET_TRAFOS ); }
     
+    mArcRot = RigidRot{ identityQuat, linAlg::vec3_t{ 0.0f, 0.0f, 0.0f } };
     linAlg::loadIdentityMatrix( mArcRotMat );
+    mArcRotMatDirty = false;
+    mInvArcRotMatDirty = true;
     linAlg::loadIdentityMatrix( mTiltRotMat );
 
     linAlg::loadIdentityMatrix( mViewRotMat );
     linAlg::loadIdentityMatrix( mViewTranslationMat );
     linAlg::loadIdentityMatrix( mViewMat );
+    mViewMatsNeedArcRot = false;
+    mViewMatsHaveArcRot = true;
+    mInvViewMatDirty = true;
+    mInvViewWithoutArcMatDirty = true;
+    mViewInputsDirty = true;
 
     mPanVector = { 0.0f, 0.0f, 0.0f };
     mRotationPivotPosArcSpaceWS = { 0.0f, 0.0f, 0.0f };
+    mOriginWS = { 0.0, 0.0, 0.0 };
+
+    mCurrRot = RigidRot{ identityQuat, linAlg::vec3_t{ 0.0f, 0.0f, 0.0f } };
+    mPrevRot = RigidRot{ identityQuat, linAlg::vec3_t{ 0.0f, 0.0f, 0.0f } };
 
-    linAlg::loadIdentityMatrix( mCurrRotMat );
-    linAlg::loadIdentityMatrix( mPrevRotMat );
+    mRotVelocity = linAlg::vec3_t{ 0.0f, 0.0f, 0.0f };
+    mDragRotVelocity = linAlg::vec3_t{ 0.0f, 0.0f, 0.0f };
+    mTimeSinceDragMotionSec = 0.0f;
+    mPanVelocity = linAlg::vec3_t{ 0.0f, 0.0f, 0.0f };
+    mInputRotVelocity = linAlg::vec3_t{ 0.0f, 0.0f, 0.0f };
+    mInputPanVelocity = linAlg::vec3_t{ 0.0f, 0.0f, 0.0f };
     linAlg::loadIdentityMatrix( mRefFrameMat );
+    mRefFrameTiltRadAngle = 0.0f; // identity is the roll frame of tilt 0
 
     mStartMouseNDC = linAlg::vec3_t{ 0.0f, 0.0f, 1.0f };
     mCurrMouseNDC  = linAlg::vec3_t{ 0.0f, 0.0f, 1.0f };
 }
+
+StatsSnapshot ArcBall::Controls::getStats() const {
+    StatsSnapshot snapshot;
+    memset( &snapshot, 0, sizeof( snapshot ) );
+
+#if defined( ARCBALL_INSTRUMENTATION )
+    snapshot.isEnabled = true;
+    memcpy( snapshot.counters, mStats.counters, sizeof( snapshot.counters ) );
+    memcpy( snapshot.timers, mStats.timers, sizeof( snapshot.timers ) );
+
+    snapshot.maxArcQuatNormError = mStats.maxArcQuatNormError;
+    snapshot.arcTranslationLength = sqrtf( linAlg::dot( mArcRot.trans, mArcRot.trans ) );
+    snapshot.panVectorLength = sqrtf( linAlg::dot( mPanVector, mPanVector ) );
+    snapshot.rotationPivotDistArcSpaceWS = sqrtf( linAlg::dot( mRotationPivotPosArcSpaceWS, mRotationPivotPosArcSpaceWS ) );
+#endif
+
+    return snapshot;
+}
+
+void ArcBall::Controls::resetStats() {
+#if defined( ARCBALL_INSTRUMENTATION )
+    mStats.reset();
+#endif
+}
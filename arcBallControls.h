@@ -22,12 +22,46 @@
 
 
 #include "eRetVal_ArcBall.h"
-#include "../math/linAlg.h" // TODO: can we make it work like this: "#include <linAlg.h>"
+#include "arcBallStats.h"
+// linAlg from the include path if there is one there (-I<path/to/linAlg>), so that the arc ball can be built on its own,
+// otherwise from the sibling "math" checkout
+#if defined( __has_include )
+    #if __has_include( <linAlg.h> )
+        #include <linAlg.h>
+    #else
+        #include "../math/linAlg.h"
+    #endif
+#else
+    #include "../math/linAlg.h"
+#endif
 
 #include <stdint.h>
+#include <math.h>
+#include <array>
+#include <span>
 
 namespace ArcBall {
+    struct ViewSnapshotChannel;
+    struct TraceRecorder;
+
+    // the spaces of the coord space explanation above - in large-world mode WS is relative to Controls::getOriginWS()
+    enum class eCoordSpace {
+        WS,
+        ARC_SPACE_WS,
+        ES, // eye space
+    };
+
+    // NOTE: a Controls instance is meant to be driven by one thread - to hand its matrices to other threads, use a ViewSnapshotChannel
     struct Controls {
+    private:
+        // rigid transform x' = quat * x * quat^(-1) + trans; the rotation about the pivot ends up in trans
+        // this is what we accumulate instead of mat3x4 products - quat gets renormalized whenever it drifted off (see setRenormThreshold())
+        struct RigidRot {
+            linAlg::vec4_t quat; // x, y, z, w
+            linAlg::vec3_t trans;
+        };
+
+    public:
 
         struct InteractionModeDesc {
             bool fullCircle;  // mouse may go off screen, arc ball will continue to rotate
@@ -49,6 +83,26 @@ namespace ArcBall {
                         //,const bool RMBpressed 
         );
 
+        // one sample of a (high polling rate) mouse, as delivered between two frames
+        struct MouseEvent {
+            double timeSec;      // monotonic, events of one batch must be sorted by it
+            float  relMouseX;    // same meaning as the corresponding update() arguments
+            float  relMouseY;
+            float  relMouse_dx;
+            float  relMouse_dy;
+            bool   LMBpressed;
+        };
+
+        // same pose as calling update() once per event (press/release edges inside the batch included), 
+        // but the view matrices are only built once; camPanDelta is applied once for the whole batch
+        // returns ERROR without changing anything if an event's timestamp goes backwards
+        eRetVal ingestEvents( const float deltaTimeSec,
+                              const std::span<const MouseEvent> events,
+                              const float camDist,
+                              const linAlg::vec3_t& camPanDelta,
+                              const float camTiltRadAngle
+        );
+
         // "view-matrix" part
         void calcViewWithoutArcMatFrameMatrices( const float camTiltRadAngle, const linAlg::vec3_t& camPanDelta, const float camDist );
 
@@ -56,15 +110,43 @@ namespace ArcBall {
         void calcArcMat( const float camTiltRadAngle, const float relMouseX, const float relMouseY, const float relative_mouse_dx, const float relative_mouse_dy, const bool LMBpressed 
         );
         
-        const linAlg::mat3x4_t& getArcRotMat() const { return mArcRotMat; } // model matrix part - can be thought of as rotated object
+        const linAlg::mat3x4_t& getArcRotMat() const { if (mArcRotMatDirty) { expandArcRotMat(); } return mArcRotMat; } // model matrix part - can be thought of as rotated object
         const linAlg::mat3x4_t& getTiltRotMat() const { return mTiltRotMat; }
-        const linAlg::mat3x4_t& getViewRotMat() const { return mViewRotMat; }
+        const linAlg::mat3x4_t& getViewRotMat() const { if (mViewMatsNeedArcRot) { applyArcRotToViewMats(); } return mViewRotMat; }
         const linAlg::mat3x4_t& getViewTranslationMat() const { return mViewTranslationMat; }
+        // camTiltRadAngle / camDist the view was last built with
+        float getViewTiltRadAngle() const { return mViewTiltRadAngle; }
+        float getViewCamDist() const { return mViewCamDist; }
         
-        const linAlg::mat3x4_t& getViewMatrix() const { return mViewMat; }
+        const linAlg::mat3x4_t& getViewMatrix() const { if (mViewMatsNeedArcRot) { applyArcRotToViewMats(); } return mViewMat; }
         void setViewMatrix( const linAlg::mat3x4_t& viewMatrix );
+        // seamless version: the next update() with camTiltRadAngle and camDist (and no mouse / pan input) yields viewMatrix again,
+        // from then on the arc ball rotates around pivotWS
+        void setViewMatrix( const linAlg::mat3x4_t& viewMatrix, const linAlg::vec3_t& pivotWS, const float camTiltRadAngle, const float camDist );
+
+        // rigid-body inverses (transpose + translation), cached until the matrix they belong to changes
+        const linAlg::mat3x4_t& getInvArcRotMat() const { if (mInvArcRotMatDirty) { expandInvArcRotMat(); } return mInvArcRotMat; } // ArcSpaceWS -> WS
+        const linAlg::mat3x4_t& getInvViewMatrix() const { if (mInvViewMatDirty) { expandInvViewMat(); } return mInvViewMat; } // eye space -> WS
+        const linAlg::mat3x4_t& getInvViewWithoutArcMat() const { if (mInvViewWithoutArcMatDirty) { expandInvViewWithoutArcMat(); } return mInvViewWithoutArcMat; } // eye space -> ArcSpaceWS
+
+        // matrix taking points from space "from" to space "to", straight from the cached matrices (and their inverses)
+        linAlg::mat3x4_t getCoordSpaceTransform( const eCoordSpace from, const eCoordSpace to ) const;
+
+        // bulk point transforms for overlays (labels, markers, point selections, ...) with the matrices of the last update()
+        // SIMD inner loops for vec3 arrays and SoA; numThreads == 0 uses all hardware threads, arrays below about 130k points stay on the calling thread
+        // out may be the same memory as in; ERROR if the sizes don't match
+        eRetVal transformPoints( const eCoordSpace from, const eCoordSpace to, const std::span<const linAlg::vec3_t> in, const std::span<linAlg::vec3_t> out, 
+                                 const uint32_t numThreads = 0 ) const;
+        // positions somewhere inside bigger structs, 3 floats every strideBytes - a convenience, not a bulk path: a plain per-point loop
+        // (SIMD measured no faster, see transformPointsStrided()), only the threading applies; stride 12 is the vec3 path
+        eRetVal transformPoints( const eCoordSpace from, const eCoordSpace to, const float* in, const size_t inStrideBytes, float* out, const size_t outStrideBytes, 
+                                 const size_t numPoints, const uint32_t numThreads = 0 ) const;
+        // structure of arrays
+        eRetVal transformPoints( const eCoordSpace from, const eCoordSpace to, 
+                                 const std::span<const float> inX, const std::span<const float> inY, const std::span<const float> inZ, 
+                                 const std::span<float> outX, const std::span<float> outY, const std::span<float> outZ, const uint32_t numThreads = 0 ) const;
 
-        void addPanDelta( const linAlg::vec3_t& delta ) { mPanVector = mPanVector + delta; }
+        void addPanDelta( const linAlg::vec3_t& delta );
         
 
         void setRefFrameMat( const linAlg::mat3_t& refFrameMat );
@@ -72,14 +154,16 @@ namespace ArcBall {
         void setRotationPivotWS( const linAlg::vec3_t& pivotWSIn );
         void setRotationPivotArcSpaceWS( const linAlg::vec3_t& pivotArcSpaceWS ); // Model-matrix part more stable, but less easy to use from the outside
 
-        linAlg::vec3_t getRotationPivotOffsetArcSpaceWS();
-        linAlg::vec3_t getRotationPivotOffsetWS();
+        linAlg::vec3_t getRotationPivotOffsetArcSpaceWS() const;
+        linAlg::vec3_t getRotationPivotOffsetWS() const;
 
         void seamlessSetRotationPivotWS( const linAlg::vec3_t& pivotWS, const float& camTiltRadAngle, const float& camDist );
         void seamlessSetRotationPivotArcSpaceWS( const linAlg::vec3_t& pivotArcSpaceWS, const float& camTiltRadAngle, const float& camDist );
         void commonSeamlessSetRotationPivotWS( const float& camTiltRadAngle, const float& camDist );
         //void seamlessSetRotationPivotWS( const linAlg::vec3_t& pivotWS, const float& camTiltRadAngle, const float& camDist );
 
+        // smooth mode: fraction of the fling / glide velocity lost per 1/60 sec - applied as exponential decay over deltaTimeSec, 
+        // so the motion doesn't depend on how often (or with which dt) update() is called
         void setRotDampingFactor( const float dampingFactor ) { mRotDampingFactor = dampingFactor; }
         float getRotDampingFactor() const { return mRotDampingFactor; }
 
@@ -87,47 +171,259 @@ namespace ArcBall {
         float getPanDampingFactor() const { return mPanDampingFactor; }
 
         void setMouseSensitivity( const float mouseSensitivity ) { mMouseSensitivity = mouseSensitivity; }
+        float getMouseSensitivity() const { return mMouseSensitivity; }
 
         void setInteractionMode( const InteractionModeDesc modeDesc ) { mInteractionModeDesc = modeDesc; }
         InteractionModeDesc getInteractionMode() const { return mInteractionModeDesc; }
 
         void setMaxTraditionalRotDeg( const float maxTraditionalRotDeg ) { mMaxTraditionalRotDeg = maxTraditionalRotDeg;  }
+        float getMaxTraditionalRotDeg() const { return mMaxTraditionalRotDeg; }
 
-        void setDeadZone( const float deadZone ) { mDeadZone = deadZone; }
+        void setDeadZone( const float deadZone ) { mDeadZone = deadZone; mCosDeadZone = cosf( deadZone ); }
         float getDeadZone() const { return mDeadZone; }
 
+        // large worlds: far from the origin every pivot re-set pushes mArcRot / mPanVector further out (see "float-wobble" above)
+        // with this on, the state is kept relative to the pivot - whenever the pivot or the arc translation get further than
+        // rebaseDist away, both WS and ArcSpaceWS origins are moved onto the pivot and the WS shift is accumulated in double
+        // all matrices and WS positions (pivots, picked points) are then relative to getOriginWS(), i.e. they map (posWS - getOriginWS())
+        // switching it off again keeps the current origin until resetTrafos()
+        void setLargeWorldMode( const bool isEnabled, const float rebaseDist = 256.0f ) { mIsLargeWorldMode = isEnabled; mRebaseDist = rebaseDist; }
+        bool getLargeWorldMode() const { return mIsLargeWorldMode; }
+        float getRebaseDist() const { return mRebaseDist; }
+        const std::array<double, 3>& getOriginWS() const { return mOriginWS; }
+
+        // latency hiding: the view expected tAheadSec after the last update() (e.g. at scan-out), without touching the state
+        // a drag / pan is extrapolated at the speed of the last update()'s input, inertia follows the smooth-mode damping;
+        // rotations go around the current pivot, tilt and camDist stay as they were
+        void predictViewMatrix( const float tAheadSec, linAlg::mat3x4_t& viewMatrix ) const;
+        // late latching: same, but input that came in since the last update() (lateDeltaTimeSec worth, events as for ingestEvents()) is applied
+        // first and tAheadSec counts from then - right before submitting a frame; the state is left alone, the next update() gets that input again
+        eRetVal latchViewMatrix( const float lateDeltaTimeSec, const std::span<const MouseEvent> lateEvents, const linAlg::vec3_t& lateCamPanDelta, 
+                                 const float tAheadSec, linAlg::mat3x4_t& viewMatrix ) const;
+
+        // what the last update() / ingestEvents() did to the view, for renderers that only draw on demand
+        struct ViewMotion {
+            bool  hasViewChanged; // view matrix differs from the one of the previous update()
+            bool  isSettled;      // no inertia left and the motion rate is at most the settle threshold - the view won't change without new input
+            float rotRadAngle;    // eye space rotation since the previous update() (arc rotation and tilt change)
+            float eyeTranslation; // eye space translation of the origin of the previous eye space (pan, camDist and pivot changes)
+            float pivotDepth;     // distance from the eye to the rotation pivot
+
+            // conservative bound on how far (in rad, as seen from the eye) a point at least depth away from the eye moved on screen
+            // multiply by focalLength / pixelSize for pixels; pivotDepth is a good depth for "the object"
+            float calcMaxAngularMotion( const float depth ) const {
+                const float pi = 3.14159265358979f;
+                const float transRadAngle = (eyeTranslation < depth) ? asinf( eyeTranslation / depth ) : pi;
+                return fminf( rotRadAngle + transRadAngle, pi );
+            }
+        };
+        const ViewMotion& getViewMotion() const { return mViewMotion; }
+
+        // motion rate ((rotRadAngle + eyeTranslation / pivotDepth) / deltaTimeSec) at or below which the view counts as settled;
+        // coasting inertia that gets that slow is stopped right away, so a settled view really stays put - something like 1e-3 rad/sec
+        // is invisible at usual resolutions; 0 (default) only settles once the inertia has died off by itself
+        void setSettleThreshold( const float radPerSec ) { mSettleThreshold = radPerSec; }
+        float getSettleThreshold() const { return mSettleThreshold; }
+
+        // numeric health of the accumulated arc rotation - always on, unlike getStats(); for alerting in long running (24/7) sessions
+        // mArcRotMat is expanded from a quaternion, so it is as far off from orthonormal as that quaternion is from unit length:
+        // R^T * R deviates from the identity by about 2 * normError, det( R ) from 1 by about 3 * normError
+        struct NumericHealth {
+            float    arcQuatNormError;    // |1 - |q|^2| of the last composition, before any correction
+            float    maxArcQuatNormError; // since the last resetNumericHealth()
+            uint64_t numCompositions;     // rotations accumulated into the arc rotation
+            uint64_t numCorrections;      // of these, the ones that needed a renormalization step
+        };
+        const NumericHealth& getNumericHealth() const { return mNumericHealth; }
+        void resetNumericHealth();
+
+        // accumulated rotations are only renormalized once |1 - |q|^2| exceeds this, with one Newton step for 1/|q| (error e -> ~0.75 e^2)
+        // instead of a full normalization after every composition - the renorm/* cases of arcBallBench: ~8.5 instead of ~22.6 ns per
+        // composition, with the default threshold ~6% of the compositions of a drag session get the step
+        void setRenormThreshold( const float normError ) { mRenormThreshold = normError; }
+        float getRenormThreshold() const { return mRenormThreshold; }
+
+        // complete state of the controller - transforms, settings, inertia and an in-flight drag - as one fixed-size, trivially copyable block,
+        // e.g. to restore a session on startup or to jump back to an earlier state without replaying anything
+        // not part of it: the attached snapshot channel / trace recorder, stats and numeric health
+        struct State {
+            static constexpr uint32_t formatVersion = 1;
+            uint32_t version;
+
+            InteractionModeDesc interactionModeDesc;
+            float mouseSensitivity;
+            float rotDampingFactor;
+            float panDampingFactor;
+            float deadZone;
+            float maxTraditionalRotDeg;
+            float settleThreshold;
+            float renormThreshold;
+            float rebaseDist;
+            bool  isLargeWorldMode;
+            bool  isActive;
+
+            RigidRot arcRot;
+            RigidRot currRot;
+            RigidRot prevRot;
+            linAlg::vec3_t panVector;
+            linAlg::vec3_t rotationPivotPosArcSpaceWS;
+            std::array<double, 3> originWS;
+            linAlg::mat3_t refFrameMat;
+            float refFrameTiltRadAngle;
+
+            // the view matrices as the last update() left them - setViewMatrix() may have put in anything
+            linAlg::mat3x4_t tiltRotMat;
+            linAlg::mat3x4_t viewTranslationMat;
+            linAlg::mat3x4_t viewRotMat;
+            linAlg::mat3x4_t viewMat;
+            bool viewMatsHaveArcRot;
+            bool viewInputsDirty;
+            float viewTiltRadAngle;
+            float viewCamDist;
+            linAlg::vec3_t viewRotationPivotPosArcSpaceWS;
+
+            linAlg::vec3_t rotVelocity;
+            linAlg::vec3_t dragRotVelocity;
+            float timeSinceDragMotionSec;
+            linAlg::vec3_t panVelocity;
+            linAlg::vec3_t inputRotVelocity;
+            linAlg::vec3_t inputPanVelocity;
+
+            linAlg::vec4_t motionViewQuat;
+            linAlg::vec3_t motionViewTrans;
+            ViewMotion viewMotion;
+
+            linAlg::vec3_t startMouseNDC;
+            linAlg::vec3_t currMouseNDC;
+            float fixX;
+            float fixY;
+            bool  LMBheldDown;
+        };
+        // O(1), just copies - unused padding bytes are zeroed, so equal states compare equal with memcmp()
+        void saveState( State& state ) const;
+        // the next update() continues exactly as it would have after saveState(); ERROR (and nothing changed) for other format versions
+        eRetVal restoreState( const State& state );
+
         void resetTrafos();
         void setActive( const bool isActive ) { mIsActive = isActive; }
 
+        // if set, every update() publishes the resulting matrices to the channel (see arcBallViewSnapshot.h)
+        // the channel has to outlive the Controls or be unset again with nullptr
+        void setSnapshotChannel( ViewSnapshotChannel* snapshotChannel ) { mSnapshotChannel = snapshotChannel; }
+
+        // if set, every call into the Controls gets appended to the recorder's trace (see arcBallTrace.h)
+        void setTraceRecorder( TraceRecorder* traceRecorder ) { mTraceRecorder = traceRecorder; }
+
+        // counters, latency histograms and state health of this instance (see arcBallStats.h) - all zero unless built with ARCBALL_INSTRUMENTATION
+        StatsSnapshot getStats() const;
+        void resetStats();
+
     private:
-        linAlg::mat3x4_t mArcRotMat;
+        void rotateArcAroundPivot( const linAlg::vec4_t& deltaQuat );
+        void renormalizeAccumulatedQuat( linAlg::vec4_t& quat );
+        void updateRotInertia( const float deltaTimeSec, const bool LMBwasHeldDown );
+        linAlg::vec3_t calcSmoothPanDelta( const float deltaTimeSec, const linAlg::vec3_t& camPanDelta );
+
+        RigidRot calcViewRigidRot( const RigidRot& arcRot, const linAlg::vec3_t& panVector ) const;
+
+        void rebaseOrigin();
+        void updateViewMotion( const float deltaTimeSec, const bool LMBwasHeldDown );
+        void finishUpdate( const float deltaTimeSec, const RigidRot& arcRotBefore, const bool LMBwasHeldDown, const float camDist, const linAlg::vec3_t& camPanDelta, const float camTiltRadAngle );
+        void loadViewMatsWithoutArcRot();
+        void invalidateArcRotMats();
+        void expandInvArcRotMat() const;
+        void expandInvViewMat() const;
+        void expandInvViewWithoutArcMat() const;
+
+        void calcRolledRefFrameMat( const float camTiltRadAngle );
+        void calcArcRot( const float relMouseX, const float relMouseY, const float relative_mouse_dx, const float relative_mouse_dy, const bool LMBpressed );
+
+        void expandArcRotMat() const;
+        void applyArcRotToViewMats() const;
+
+        RigidRot mArcRot;
+        mutable linAlg::mat3x4_t mArcRotMat; // expanded from mArcRot only when read
+        mutable bool mArcRotMatDirty;
+
         linAlg::mat3x4_t mTiltRotMat;
-        linAlg::mat3x4_t mViewRotMat;
+        mutable linAlg::mat3x4_t mViewRotMat;
         linAlg::mat3x4_t mViewTranslationMat;
-        linAlg::mat3x4_t mViewMat;
+        mutable linAlg::mat3x4_t mViewMat;
+        mutable bool mViewMatsNeedArcRot; // update() leaves mViewRotMat and mViewMat without the arc rotation until they are read
+        mutable bool mViewMatsHaveArcRot; // false after calcViewWithoutArcMatFrameMatrices() until the next update()
+
+        mutable linAlg::mat3x4_t mInvArcRotMat;
+        mutable linAlg::mat3x4_t mInvViewMat;
+        mutable linAlg::mat3x4_t mInvViewWithoutArcMat;
+        mutable bool mInvArcRotMatDirty;
+        mutable bool mInvViewMatDirty;
+        mutable bool mInvViewWithoutArcMatDirty;
+
+        // what the view-without-arc matrices were last built from - if none of it changes, update() doesn't rebuild them
+        float          mViewTiltRadAngle;
+        float          mViewCamDist;
+        linAlg::vec3_t mViewRotationPivotPosArcSpaceWS;
+        bool           mViewInputsDirty;
 
         linAlg::vec3_t   mPanVector;
         
         // only for clamp mouse interaction ("traditional" arc ball)    
-        linAlg::mat3x4_t mCurrRotMat;
-        linAlg::mat3x4_t mPrevRotMat;
+        RigidRot mCurrRot;
+        RigidRot mPrevRot;
 
         linAlg::mat3_t mRefFrameMat; // for camera rolling - without camera rolling, this may stay a unit matrix
+        float          mRefFrameTiltRadAngle; // tilt mRefFrameMat was built for, NaN if it was set from the outside
         linAlg::vec3_t mRotationPivotPosArcSpaceWS;
 
+        // large world mode
+        std::array<double, 3> mOriginWS;
+        float mRebaseDist;
+        bool  mIsLargeWorldMode;
+
+        // smooth mode inertia
+        linAlg::vec3_t mRotVelocity;     // ArcSpaceWS rotation axis * rad/sec, while coasting
+        linAlg::vec3_t mDragRotVelocity; // of the last drag step that moved
+        float          mTimeSinceDragMotionSec;
+        linAlg::vec3_t mPanVelocity;
+
+        // latency hiding - what the input of the last update() did, see predictViewMatrix()
+        linAlg::vec3_t mInputRotVelocity; // ArcSpaceWS rotation axis * rad/sec
+        linAlg::vec3_t mInputPanVelocity;
+
+        // on-demand rendering - the eye space transform of the previous update() as quat / translation
+        linAlg::vec4_t mMotionViewQuat;
+        linAlg::vec3_t mMotionViewTrans;
+        ViewMotion     mViewMotion;
+        float          mSettleThreshold;
+
         linAlg::vec3_t mStartMouseNDC;
         linAlg::vec3_t mCurrMouseNDC;
 
+        NumericHealth mNumericHealth;
+        float         mRenormThreshold;
+
         float mMouseSensitivity;
         float mRotDampingFactor;
         float mPanDampingFactor;
         float mDeadZone;
+        float mCosDeadZone; // so that we can test the arc angle against the dead zone without acos
 
         float mMaxTraditionalRotDeg; // 180.0f for traditional arcBall, 360.0f for one full rotation per mouse-drag (stronger movement)
 
         InteractionModeDesc mInteractionModeDesc;
+        // traditional arc ball: accumulated relative mouse pos of the current drag
+        float mFixX;
+        float mFixY;
+
         bool  mLMBheldDown;
         bool  mIsActive;
+
+        ViewSnapshotChannel* mSnapshotChannel;
+        TraceRecorder*       mTraceRecorder;
+
+    #if defined( ARCBALL_INSTRUMENTATION )
+        mutable stats::InstanceStats mStats; // mutable for the const latchViewMatrix()
+    #endif
     };
 }
 #endif // _ARCBALLCONTROLS_H_9ec4f00a_2117_4578_937e_9f4fb94dc759
@@ -0,0 +1,355 @@
+#include "arcBallControlsBatch.h"
+
+#include <limits>
+#include <math.h>
+
+#if defined( __AVX__ )
+    #include <immintrin.h>
+    #define ARCBALL_BATCH_AVX
+#elif defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+    #include <emmintrin.h>
+    #define ARCBALL_BATCH_SSE
+#endif
+
+using namespace ArcBall;
+
+namespace {
+
+    // thin lane wrappers so that the kernel below is written only once - Mask is the result of comparisons
+
+    struct LanesScalar {
+        static constexpr size_t width = 1;
+        using Mask = bool;
+        float v;
+
+        static LanesScalar load( const float* p ) { return { *p }; }
+        static LanesScalar set1( const float f ) { return { f }; }
+        void store( float* p ) const { *p = v; }
+
+        friend LanesScalar operator+( const LanesScalar a, const LanesScalar b ) { return { a.v + b.v }; }
+        friend LanesScalar operator-( const LanesScalar a, const LanesScalar b ) { return { a.v - b.v }; }
+        friend LanesScalar operator*( const LanesScalar a, const LanesScalar b ) { return { a.v * b.v }; }
+        friend LanesScalar operator/( const LanesScalar a, const LanesScalar b ) { return { a.v / b.v }; }
+        friend Mask operator<( const LanesScalar a, const LanesScalar b ) { return a.v < b.v; }
+        friend Mask operator<=( const LanesScalar a, const LanesScalar b ) { return a.v <= b.v; }
+        friend Mask operator>( const LanesScalar a, const LanesScalar b ) { return a.v > b.v; }
+        friend LanesScalar sqrt( const LanesScalar a ) { return { sqrtf( a.v ) }; }
+
+        static Mask maskAnd( const Mask a, const Mask b ) { return a && b; }
+        static Mask maskOr( const Mask a, const Mask b ) { return a || b; }
+        static LanesScalar select( const Mask m, const LanesScalar a, const LanesScalar b ) { return m ? a : b; }
+        static LanesScalar fromMask( const Mask m ) { return { m ? 1.0f : 0.0f }; }
+    };
+
+#if defined( ARCBALL_BATCH_AVX )
+    struct LanesAVX {
+        static constexpr size_t width = 8;
+        using Mask = __m256;
+        __m256 v;
+
+        static LanesAVX load( const float* p ) { return { _mm256_loadu_ps( p ) }; }
+        static LanesAVX set1( const float f ) { return { _mm256_set1_ps( f ) }; }
+        void store( float* p ) const { _mm256_storeu_ps( p, v ); }
+
+        friend LanesAVX operator+( const LanesAVX a, const LanesAVX b ) { return { _mm256_add_ps( a.v, b.v ) }; }
+        friend LanesAVX operator-( const LanesAVX a, const LanesAVX b ) { return { _mm256_sub_ps( a.v, b.v ) }; }
+        friend LanesAVX operator*( const LanesAVX a, const LanesAVX b ) { return { _mm256_mul_ps( a.v, b.v ) }; }
+        friend LanesAVX operator/( const LanesAVX a, const LanesAVX b ) { return { _mm256_div_ps( a.v, b.v ) }; }
+        friend Mask operator<( const LanesAVX a, const LanesAVX b ) { return _mm256_cmp_ps( a.v, b.v, _CMP_LT_OQ ); }
+        friend Mask operator<=( const LanesAVX a, const LanesAVX b ) { return _mm256_cmp_ps( a.v, b.v, _CMP_LE_OQ ); }
+        friend Mask operator>( const LanesAVX a, const LanesAVX b ) { return _mm256_cmp_ps( a.v, b.v, _CMP_GT_OQ ); }
+        friend LanesAVX sqrt( const LanesAVX a ) { return { _mm256_sqrt_ps( a.v ) }; }
+
+        static Mask maskAnd( const Mask a, const Mask b ) { return _mm256_and_ps( a, b ); }
+        static Mask maskOr( const Mask a, const Mask b ) { return _mm256_or_ps( a, b ); }
+        static LanesAVX select( const Mask m, const LanesAVX a, const LanesAVX b ) { return { _mm256_blendv_ps( b.v, a.v, m ) }; }
+        static LanesAVX fromMask( const Mask m ) { return { _mm256_and_ps( m, _mm256_set1_ps( 1.0f ) ) }; }
+    };
+    using LanesWide = LanesAVX;
+#elif defined( ARCBALL_BATCH_SSE )
+    struct LanesSSE {
+        static constexpr size_t width = 4;
+        using Mask = __m128;
+        __m128 v;
+
+        static LanesSSE load( const float* p ) { return { _mm_loadu_ps( p ) }; }
+        static LanesSSE set1( const float f ) { return { _mm_set1_ps( f ) }; }
+        void store( float* p ) const { _mm_storeu_ps( p, v ); }
+
+        friend LanesSSE operator+( const LanesSSE a, const LanesSSE b ) { return { _mm_add_ps( a.v, b.v ) }; }
+        friend LanesSSE operator-( const LanesSSE a, const LanesSSE b ) { return { _mm_sub_ps( a.v, b.v ) }; }
+        friend LanesSSE operator*( const LanesSSE a, const LanesSSE b ) { return { _mm_mul_ps( a.v, b.v ) }; }
+        friend LanesSSE operator/( const LanesSSE a, const LanesSSE b ) { return { _mm_div_ps( a.v, b.v ) }; }
+        friend Mask operator<( const LanesSSE a, const LanesSSE b ) { return _mm_cmplt_ps( a.v, b.v ); }
+        friend Mask operator<=( const LanesSSE a, const LanesSSE b ) { return _mm_cmple_ps( a.v, b.v ); }
+        friend Mask operator>( const LanesSSE a, const LanesSSE b ) { return _mm_cmpgt_ps( a.v, b.v ); }
+        friend LanesSSE sqrt( const LanesSSE a ) { return { _mm_sqrt_ps( a.v ) }; }
+
+        static Mask maskAnd( const Mask a, const Mask b ) { return _mm_and_ps( a, b ); }
+        static Mask maskOr( const Mask a, const Mask b ) { return _mm_or_ps( a, b ); }
+        static LanesSSE select( const Mask m, const LanesSSE a, const LanesSSE b ) { return { _mm_or_ps( _mm_and_ps( m, a.v ), _mm_andnot_ps( m, b.v ) ) }; }
+        static LanesSSE fromMask( const Mask m ) { return { _mm_and_ps( m, _mm_set1_ps( 1.0f ) ) }; }
+    };
+    using LanesWide = LanesSSE;
+#else
+    using LanesWide = LanesScalar;
+#endif
+
+    struct BatchPtrs {
+        float* arcQuat[4];
+        float* arcTrans[3];
+        const float* pivot[3];
+        float* pan[3];
+        float* LMBheldDown;
+        const float* cosTilt;
+        const float* sinTilt;
+        const float* LMBpressed;
+    };
+
+    struct BatchParams {
+        float panScale;
+        float deadZone;
+        float cosDeadZone;
+        float renormThreshold;
+    };
+
+    // x' = q * x * q^(-1), same as quatRotate() in arcBallControls.cpp
+    template<class L>
+    inline void quatRotateLanes( const L q[4], const L v[3], L out[3] ) {
+        const L two = L::set1( 2.0f );
+        const L t0 = two * (q[1] * v[2] - q[2] * v[1]);
+        const L t1 = two * (q[2] * v[0] - q[0] * v[2]);
+        const L t2 = two * (q[0] * v[1] - q[1] * v[0]);
+        out[0] = v[0] + q[3] * t0 + (q[1] * t2 - q[2] * t1);
+        out[1] = v[1] + q[3] * t1 + (q[2] * t0 - q[0] * t2);
+        out[2] = v[2] + q[3] * t2 + (q[0] * t1 - q[1] * t0);
+    }
+
+    // processes controllers [i, i + L::width)
+    template<class L>
+    inline void updateLanes( const BatchPtrs& s, const BatchParams& params, const ControlsBatch::Input& input, const size_t i, linAlg::mat3x4_t* viewMatrices ) {
+        using M = typename L::Mask;
+
+        const L zero = L::set1( 0.0f );
+        const L half = L::set1( 0.5f );
+        const L one = L::set1( 1.0f );
+        const L two = L::set1( 2.0f );
+
+        const L dx = L::load( input.relMouse_dx + i );
+        const L dy = L::load( input.relMouse_dy + i );
+        const M LMBheldDown = L::load( s.LMBheldDown + i ) > half;
+        const M LMBpressed = L::load( s.LMBpressed + i ) > half;
+
+        const L relMouseDelta = sqrt( dx * dx + dy * dy );
+        const M movedBeyondDeadZone = L::maskAnd( LMBheldDown, relMouseDelta > L::set1( params.deadZone ) );
+
+        // calcArcMat() - mapScreenPosToArcBallPosNDC( { 0.5f + dx, 0.5f + dy } ), start is always { 0, 0, 1 }
+        L ndcX = two * (half + dx) - one;
+        L ndcY = two - two * (half + dy) - one;
+        const L r2 = ndcX * ndcX + ndcY * ndcY;
+        const M insideSphere = r2 <= half;
+        L ndcZ = L::select( insideSphere, sqrt( one - L::select( insideSphere, r2, zero ) ), half / sqrt( L::select( insideSphere, one, r2 ) ) );
+        const L invNdcLen = one / sqrt( ndcX * ndcX + ndcY * ndcY + ndcZ * ndcZ );
+        ndcX = ndcX * invNdcLen;
+        ndcY = ndcY * invNdcLen;
+        ndcZ = ndcZ * invNdcLen;
+
+        const L cosAngle = ndcZ; // dot( { 0, 0, 1 }, ndc )
+        const M doRotate = L::maskAnd( LMBheldDown, L::maskAnd( cosAngle < L::set1( 1.0f - std::numeric_limits<float>::epsilon() ), cosAngle < L::set1( params.cosDeadZone ) ) );
+
+        const L cosTilt = L::load( s.cosTilt + i );
+        const L sinTilt = L::load( s.sinTilt + i );
+
+        // cross( { 0, 0, 1 }, ndc ) = { -y, x, 0 }, brought into the ref frame (transposed roll matrix)
+        const L axisX = zero - ndcY;
+        const L axisY = ndcX;
+        L deltaQuat[4] = { cosTilt * axisX + sinTilt * axisY, cosTilt * axisY - sinTilt * axisX, zero, one + cosAngle };
+        {
+            const L invLen = one / sqrt( deltaQuat[0] * deltaQuat[0] + deltaQuat[1] * deltaQuat[1] + deltaQuat[3] * deltaQuat[3] );
+            deltaQuat[0] = deltaQuat[0] * invLen;
+            deltaQuat[1] = deltaQuat[1] * invLen;
+            deltaQuat[3] = deltaQuat[3] * invLen;
+        }
+
+        L arcQuat[4] = { L::load( s.arcQuat[0] + i ), L::load( s.arcQuat[1] + i ), L::load( s.arcQuat[2] + i ), L::load( s.arcQuat[3] + i ) };
+        L arcTrans[3] = { L::load( s.arcTrans[0] + i ), L::load( s.arcTrans[1] + i ), L::load( s.arcTrans[2] + i ) };
+        const L pivot[3] = { L::load( s.pivot[0] + i ), L::load( s.pivot[1] + i ), L::load( s.pivot[2] + i ) };
+
+        {
+            const L* a = deltaQuat;
+            const L* b = arcQuat;
+            L newQuat[4] = {
+                a[3] * b[0] + a[0] * b[3] + a[1] * b[2] - a[2] * b[1],
+                a[3] * b[1] - a[0] * b[2] + a[1] * b[3] + a[2] * b[0],
+                a[3] * b[2] + a[0] * b[1] - a[1] * b[0] + a[2] * b[3],
+                a[3] * b[3] - a[0] * b[0] - a[1] * b[1] - a[2] * b[2] };
+            // same renormalization as Controls::renormalizeAccumulatedQuat(): one Newton step once |1 - |q|^2| exceeds the threshold -
+            // its full normalization for way-off quaternions can't trigger here, both factors are always unit length up to rounding
+            const L normError = one - (newQuat[0] * newQuat[0] + newQuat[1] * newQuat[1] + newQuat[2] * newQuat[2] + newQuat[3] * newQuat[3]);
+            const L absNormError = L::select( normError < zero, zero - normError, normError );
+            const L renormScale = L::select( absNormError > L::set1( params.renormThreshold ), one + half * normError, one );
+
+            const L transRelToPivot[3] = { arcTrans[0] - pivot[0], arcTrans[1] - pivot[1], arcTrans[2] - pivot[2] };
+            L newTrans[3];
+            quatRotateLanes( deltaQuat, transRelToPivot, newTrans );
+
+            for (int c = 0; c < 4; c++) {
+                arcQuat[c] = L::select( doRotate, newQuat[c] * renormScale, arcQuat[c] );
+            }
+            for (int c = 0; c < 3; c++) {
+                arcTrans[c] = L::select( doRotate, newTrans[c] + pivot[c], arcTrans[c] );
+                arcQuat[c].store( s.arcQuat[c] + i );
+                arcTrans[c].store( s.arcTrans[c] + i );
+            }
+            arcQuat[3].store( s.arcQuat[3] + i );
+        }
+
+        // LMB press / release - release only once the mouse has come to rest
+        L::fromMask( L::maskOr( LMBpressed, movedBeyondDeadZone ) ).store( s.LMBheldDown + i );
+
+        // calcViewWithoutArcMatFrameMatrices()
+        const L panScale = L::set1( params.panScale );
+        const L panX = L::load( s.pan[0] + i ) + L::load( input.camPanDeltaX + i ) * panScale;
+        const L panY = L::load( s.pan[1] + i ) + L::load( input.camPanDeltaY + i ) * panScale;
+        const L panZ = L::load( s.pan[2] + i );
+        panX.store( s.pan[0] + i );
+        panY.store( s.pan[1] + i );
+
+        // viewMat = viewTranslationMat * tiltRotMat(around pivot) * arcRotMat
+        const L& x = arcQuat[0];
+        const L& y = arcQuat[1];
+        const L& z = arcQuat[2];
+        const L& w = arcQuat[3];
+        const L arcRot[3][3] = {
+            { one - two * (y * y + z * z), two * (x * y - w * z), two * (x * z + w * y) },
+            { two * (x * y + w * z), one - two * (x * x + z * z), two * (y * z - w * x) },
+            { two * (x * z - w * y), two * (y * z + w * x), one - two * (x * x + y * y) } };
+
+        const L transRelToPivot[3] = { arcTrans[0] - pivot[0], arcTrans[1] - pivot[1], arcTrans[2] - pivot[2] };
+
+        L view[3][4];
+        for (int c = 0; c < 3; c++) {
+            view[0][c] = cosTilt * arcRot[0][c] - sinTilt * arcRot[1][c];
+            view[1][c] = sinTilt * arcRot[0][c] + cosTilt * arcRot[1][c];
+            view[2][c] = arcRot[2][c];
+        }
+        view[0][3] = cosTilt * transRelToPivot[0] - sinTilt * transRelToPivot[1] + pivot[0] + panX;
+        view[1][3] = sinTilt * transRelToPivot[0] + cosTilt * transRelToPivot[1] + pivot[1] + panY;
+        view[2][3] = transRelToPivot[2] + pivot[2] + L::load( input.camDist + i ) + panZ;
+
+        // SoA -> AoS
+        float lanes[3][4][L::width];
+        for (int r = 0; r < 3; r++) {
+            for (int c = 0; c < 4; c++) {
+                view[r][c].store( lanes[r][c] );
+            }
+        }
+        for (size_t l = 0; l < L::width; l++) {
+            linAlg::mat3x4_t& viewMat = viewMatrices[i + l];
+            for (int r = 0; r < 3; r++) {
+                viewMat[r] = linAlg::vec4_t{ lanes[r][0][l], lanes[r][1][l], lanes[r][2][l], lanes[r][3][l] };
+            }
+        }
+    }
+}
+
+ArcBall::ControlsBatch::ControlsBatch( const size_t numControls, const Controls::InteractionModeDesc modeDesc )
+    : mNumControls( numControls )
+    , mArcQuatX( numControls ), mArcQuatY( numControls ), mArcQuatZ( numControls ), mArcQuatW( numControls )
+    , mArcTransX( numControls ), mArcTransY( numControls ), mArcTransZ( numControls )
+    , mPivotX( numControls ), mPivotY( numControls ), mPivotZ( numControls )
+    , mPanX( numControls ), mPanY( numControls ), mPanZ( numControls )
+    , mLMBheldDown( numControls )
+    , mCosTilt( numControls ), mSinTilt( numControls )
+    , mLMBpressed( numControls )
+    , mPanDampingFactor( 1.0f ) {
+
+    setDeadZone( 0.001f );
+    setRenormThreshold( std::numeric_limits<float>::epsilon() * 4.0f );
+    setInteractionMode( modeDesc );
+
+    for (size_t i = 0; i < numControls; i++) {
+        resetTrafos( i );
+    }
+}
+
+eRetVal ArcBall::ControlsBatch::setInteractionMode( const Controls::InteractionModeDesc modeDesc ) {
+    mInteractionModeDesc = modeDesc;
+    return isSupportedMode( modeDesc ) ? eRetVal::OK : eRetVal::ERROR;
+}
+
+void ArcBall::ControlsBatch::setDeadZone( const float deadZone ) {
+    mDeadZone = deadZone;
+    mCosDeadZone = cosf( deadZone );
+}
+
+void ArcBall::ControlsBatch::setRotationPivotArcSpaceWS( const size_t idx, const linAlg::vec3_t& pivotArcSpaceWS ) {
+    mPivotX[idx] = pivotArcSpaceWS[0];
+    mPivotY[idx] = pivotArcSpaceWS[1];
+    mPivotZ[idx] = pivotArcSpaceWS[2];
+}
+
+linAlg::vec3_t ArcBall::ControlsBatch::getRotationPivotOffsetArcSpaceWS( const size_t idx ) const {
+    return linAlg::vec3_t{ mPivotX[idx], mPivotY[idx], mPivotZ[idx] };
+}
+
+void ArcBall::ControlsBatch::getArcRotMat( const size_t idx, linAlg::mat3x4_t& arcRotMat ) const {
+    const float x = mArcQuatX[idx], y = mArcQuatY[idx], z = mArcQuatZ[idx], w = mArcQuatW[idx];
+    arcRotMat[0] = linAlg::vec4_t{ 1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y - w * z), 2.0f * (x * z + w * y), mArcTransX[idx] };
+    arcRotMat[1] = linAlg::vec4_t{ 2.0f * (x * y + w * z), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z - w * x), mArcTransY[idx] };
+    arcRotMat[2] = linAlg::vec4_t{ 2.0f * (x * z - w * y), 2.0f * (y * z + w * x), 1.0f - 2.0f * (x * x + y * y), mArcTransZ[idx] };
+}
+
+void ArcBall::ControlsBatch::resetTrafos( const size_t idx ) {
+    mArcQuatX[idx] = 0.0f;
+    mArcQuatY[idx] = 0.0f;
+    mArcQuatZ[idx] = 0.0f;
+    mArcQuatW[idx] = 1.0f;
+    mArcTransX[idx] = 0.0f;
+    mArcTransY[idx] = 0.0f;
+    mArcTransZ[idx] = 0.0f;
+    mPivotX[idx] = 0.0f;
+    mPivotY[idx] = 0.0f;
+    mPivotZ[idx] = 0.0f;
+    mPanX[idx] = 0.0f;
+    mPanY[idx] = 0.0f;
+    mPanZ[idx] = 0.0f;
+    mLMBheldDown[idx] = 0.0f;
+}
+
+eRetVal ArcBall::ControlsBatch::update( const Input& input, linAlg::mat3x4_t* viewMatrices ) {
+    if (!isSupportedMode( mInteractionModeDesc )) { return eRetVal::ERROR; }
+
+    // trig and the byte -> lane mask conversion are done up front, the kernel itself is branch-free
+    for (size_t i = 0; i < mNumControls; i++) {
+        mCosTilt[i] = cosf( input.camTiltRadAngle[i] );
+        mSinTilt[i] = sinf( input.camTiltRadAngle[i] );
+        mLMBpressed[i] = input.LMBpressed[i] ? 1.0f : 0.0f;
+    }
+
+    const BatchPtrs ptrs{
+        { mArcQuatX.data(), mArcQuatY.data(), mArcQuatZ.data(), mArcQuatW.data() },
+        { mArcTransX.data(), mArcTransY.data(), mArcTransZ.data() },
+        { mPivotX.data(), mPivotY.data(), mPivotZ.data() },
+        { mPanX.data(), mPanY.data(), mPanZ.data() },
+        mLMBheldDown.data(),
+        mCosTilt.data(),
+        mSinTilt.data(),
+        mLMBpressed.data() };
+
+    const BatchParams params{
+        1.0f / mPanDampingFactor,
+        mDeadZone,
+        mCosDeadZone,
+        mRenormThreshold };
+
+    size_t i = 0;
+    for (; i + LanesWide::width <= mNumControls; i += LanesWide::width) {
+        updateLanes<LanesWide>( ptrs, params, input, i, viewMatrices );
+    }
+    for (; i < mNumControls; i++) {
+        updateLanes<LanesScalar>( ptrs, params, input, i, viewMatrices );
+    }
+
+    return eRetVal::OK;
+}
@@ -0,0 +1,88 @@
+#ifndef _ARCBALLCONTROLSBATCH_H_6b0e3d52_8c1f_4a7e_b2d9_51f4c0a9e713
+#define _ARCBALLCONTROLSBATCH_H_6b0e3d52_8c1f_4a7e_b2d9_51f4c0a9e713
+
+// structure-of-arrays twin of ArcBall::Controls for driving lots of arc balls (viewports, remote sessions) with one call
+// update() runs calcArcMat + calcViewWithoutArcMatFrameMatrices for all controllers at once, SSE or AVX wide depending
+// on what the compiler targets (-msse2 / -mavx), with a scalar fallback for the tail and for other architectures
+//
+// the results match ArcBall::Controls::update() within float tolerance; the accumulated rotations get renormalized the same way too,
+// one Newton step whenever |1 - |q|^2| exceeds getRenormThreshold() (see Controls::setRenormThreshold())
+// only the fullCircle, non-smooth interaction mode is supported - the traditional one keeps per-drag start positions that don't 
+// vectorize well, and the smooth one adds time-based inertia which the batch doesn't simulate
+// note that Controls defaults to fullCircle + smooth: Controls to compare against need setInteractionMode( { .fullCircle = true, .smooth = false } ),
+// and a batch set up with any other mode (constructor or setInteractionMode()) returns ERROR from update() without computing anything
+
+#include "eRetVal_ArcBall.h"
+#include "arcBallControls.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace ArcBall {
+    struct ControlsBatch {
+
+        // one entry per controller, every array holds getNumControls() elements
+        struct Input {
+            const float* relMouse_dx;
+            const float* relMouse_dy;
+            const float* camDist;
+            const float* camPanDeltaX;
+            const float* camPanDeltaY;
+            const float* camTiltRadAngle;
+            const uint8_t* LMBpressed;
+        };
+
+        static bool isSupportedMode( const Controls::InteractionModeDesc modeDesc ) { return modeDesc.fullCircle && !modeDesc.smooth; }
+
+        explicit ControlsBatch( const size_t numControls, const Controls::InteractionModeDesc modeDesc = Controls::InteractionModeDesc{ .fullCircle = true, .smooth = false } );
+
+        // viewMatrices must have room for getNumControls() matrices; same conventions as Controls::getViewMatrix()
+        // ERROR (and viewMatrices untouched) if the interaction mode isn't supported
+        eRetVal update( const Input& input, linAlg::mat3x4_t* viewMatrices );
+
+        size_t getNumControls() const { return mNumControls; }
+
+        eRetVal setInteractionMode( const Controls::InteractionModeDesc modeDesc ); // ERROR unless isSupportedMode( modeDesc ), update() fails until it is
+        Controls::InteractionModeDesc getInteractionMode() const { return mInteractionModeDesc; }
+
+        void setPanDampingFactor( const float dampingFactor ) { mPanDampingFactor = dampingFactor; }
+        float getPanDampingFactor() const { return mPanDampingFactor; }
+
+        void setDeadZone( const float deadZone );
+        float getDeadZone() const { return mDeadZone; }
+
+        void setRenormThreshold( const float normError ) { mRenormThreshold = normError; }
+        float getRenormThreshold() const { return mRenormThreshold; }
+
+        void setRotationPivotArcSpaceWS( const size_t idx, const linAlg::vec3_t& pivotArcSpaceWS );
+        linAlg::vec3_t getRotationPivotOffsetArcSpaceWS( const size_t idx ) const;
+
+        void getArcRotMat( const size_t idx, linAlg::mat3x4_t& arcRotMat ) const;
+
+        void resetTrafos( const size_t idx );
+
+    private:
+        size_t mNumControls;
+
+        // arc rotation as unit quaternion + translation, same as Controls keeps it
+        std::vector<float> mArcQuatX, mArcQuatY, mArcQuatZ, mArcQuatW;
+        std::vector<float> mArcTransX, mArcTransY, mArcTransZ;
+
+        std::vector<float> mPivotX, mPivotY, mPivotZ; // mRotationPivotPosArcSpaceWS
+        std::vector<float> mPanX, mPanY, mPanZ;
+        std::vector<float> mLMBheldDown; // 0.0f or 1.0f so that it can be loaded as a lane mask
+
+        // per-update scratch
+        std::vector<float> mCosTilt, mSinTilt;
+        std::vector<float> mLMBpressed;
+
+        float mPanDampingFactor;
+        float mDeadZone;
+        float mCosDeadZone;
+        float mRenormThreshold;
+
+        Controls::InteractionModeDesc mInteractionModeDesc;
+    };
+}
+#endif // _ARCBALLCONTROLSBATCH_H_6b0e3d52_8c1f_4a7e_b2d9_51f4c0a9e713
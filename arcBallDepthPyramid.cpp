@@ -0,0 +1,314 @@
+#include "arcBallDepthPyramid.h"
+#include "arcBallParallel.h"
+#include "arcBallMath.h"
+
+#include <math.h>
+#include <algorithm>
+#include <limits>
+
+using namespace ArcBall;
+
+namespace {
+    static constexpr size_t minRowsPerThread = 64;
+    static constexpr float backgroundDepth = std::numeric_limits<float>::infinity();
+
+    struct QueryNode {
+        uint32_t level;
+        uint32_t x;
+        uint32_t y;
+    };
+}
+
+float ArcBall::DepthPyramid::loadDepth( const float* depthImage, const uint32_t x, const uint32_t y ) const {
+    const float depth = depthImage[size_t{ y } * mDesc.rowStride + x];
+    const bool isValid = isfinite( depth ) && depth < mDesc.invalidDepth && (mDesc.encoding != eDepthEncoding::LINEAR_EYE_DEPTH || depth > 0.0f);
+    return isValid ? depth : backgroundDepth;
+}
+
+float ArcBall::DepthPyramid::getMaxDepth( const uint32_t level, const uint32_t x, const uint32_t y ) const {
+    if (level > 0) { return mLevels[level].maxDepth[size_t{ y } * mLevels[level].width + x]; }
+    const float depth = getMinDepth( 0, x, y );
+    return (depth == backgroundDepth) ? -backgroundDepth : depth;
+}
+
+void ArcBall::DepthPyramid::reduceRows( const uint32_t level, const uint32_t firstRow, const uint32_t endRow, const uint32_t firstCol, const uint32_t endCol ) {
+    const Level& src = mLevels[level - 1];
+    Level& dst = mLevels[level];
+    const bool srcHasMax = level > 1;
+
+    for (uint32_t y = firstRow; y < endRow; y++) {
+        const uint32_t srcY0 = 2 * y;
+        const uint32_t srcY1 = std::min( srcY0 + 1, src.height - 1 );
+        for (uint32_t x = firstCol; x < endCol; x++) {
+            const uint32_t srcX0 = 2 * x;
+            const uint32_t srcX1 = std::min( srcX0 + 1, src.width - 1 );
+            const size_t idx00 = size_t{ srcY0 } * src.width + srcX0;
+            const size_t idx01 = size_t{ srcY0 } * src.width + srcX1;
+            const size_t idx10 = size_t{ srcY1 } * src.width + srcX0;
+            const size_t idx11 = size_t{ srcY1 } * src.width + srcX1;
+
+            const size_t dstIdx = size_t{ y } * dst.width + x;
+            dst.minDepth[dstIdx] = std::min( std::min( src.minDepth[idx00], src.minDepth[idx01] ), std::min( src.minDepth[idx10], src.minDepth[idx11] ) );
+            if (srcHasMax) {
+                dst.maxDepth[dstIdx] = std::max( std::max( src.maxDepth[idx00], src.maxDepth[idx01] ), std::max( src.maxDepth[idx10], src.maxDepth[idx11] ) );
+            } else {
+                // level 0 keeps background as +inf only, it must not win the max
+                float maxDepth = -backgroundDepth;
+                for (const size_t idx : { idx00, idx01, idx10, idx11 }) {
+                    if (src.minDepth[idx] != backgroundDepth) { maxDepth = std::max( maxDepth, src.minDepth[idx] ); }
+                }
+                dst.maxDepth[dstIdx] = maxDepth;
+            }
+        }
+    }
+}
+
+eRetVal ArcBall::DepthPyramid::build( const float* depthImage, const DepthImageDesc& desc, const uint32_t numThreads ) {
+    mLevels.clear();
+    if (depthImage == nullptr || desc.width == 0 || desc.height == 0 || (desc.rowStride != 0 && desc.rowStride < desc.width)) { return eRetVal::ERROR; }
+
+    mDesc = desc;
+    if (mDesc.rowStride == 0) { mDesc.rowStride = mDesc.width; }
+
+    uint32_t width = mDesc.width;
+    uint32_t height = mDesc.height;
+    for (;;) {
+        Level level;
+        level.width = width;
+        level.height = height;
+        level.minDepth.resize( size_t{ width } * height );
+        if (!mLevels.empty()) { level.maxDepth.resize( size_t{ width } * height ); }
+        mLevels.push_back( std::move( level ) );
+        if (width == 1 && height == 1) { break; }
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+    }
+
+    Level& level0 = mLevels[0];
+    parallelForRanges( level0.height, numThreads, minRowsPerThread, [&]( const size_t firstRow, const size_t numRows ) {
+        for (uint32_t y = static_cast<uint32_t>( firstRow ); y < firstRow + numRows; y++) {
+            float* const dstRow = level0.minDepth.data() + size_t{ y } * level0.width;
+            for (uint32_t x = 0; x < level0.width; x++) {
+                dstRow[x] = loadDepth( depthImage, x, y );
+            }
+        }
+    } );
+
+    for (uint32_t l = 1; l < getNumLevels(); l++) {
+        parallelForRanges( mLevels[l].height, numThreads, minRowsPerThread, [&]( const size_t firstRow, const size_t numRows ) {
+            reduceRows( l, static_cast<uint32_t>( firstRow ), static_cast<uint32_t>( firstRow + numRows ), 0, mLevels[l].width );
+        } );
+    }
+
+    return eRetVal::OK;
+}
+
+eRetVal ArcBall::DepthPyramid::updateRegion( const float* depthImage, const uint32_t x, const uint32_t y, const uint32_t width, const uint32_t height ) {
+    if (mLevels.empty() || depthImage == nullptr) { return eRetVal::ERROR; }
+    if (x >= mDesc.width || y >= mDesc.height || width > mDesc.width - x || height > mDesc.height - y) { return eRetVal::ERROR; }
+    if (width == 0 || height == 0) { return eRetVal::OK; }
+
+    Level& level0 = mLevels[0];
+    for (uint32_t row = y; row < y + height; row++) {
+        for (uint32_t col = x; col < x + width; col++) {
+            level0.minDepth[size_t{ row } * level0.width + col] = loadDepth( depthImage, col, row );
+        }
+    }
+
+    // inclusive texel range of the dirty region, halved level by level
+    uint32_t firstCol = x;
+    uint32_t lastCol = x + width - 1;
+    uint32_t firstRow = y;
+    uint32_t lastRow = y + height - 1;
+    for (uint32_t l = 1; l < getNumLevels(); l++) {
+        firstCol /= 2;
+        lastCol /= 2;
+        firstRow /= 2;
+        lastRow /= 2;
+        reduceRows( l, firstRow, lastRow + 1, firstCol, lastCol + 1 );
+    }
+
+    return eRetVal::OK;
+}
+
+bool ArcBall::DepthPyramid::findArgMin( uint32_t level, uint32_t x, uint32_t y, DepthSample& sample ) const {
+    // the min of a block came from one of its children, follow it down
+    const float depth = getMinDepth( level, x, y );
+    while (level > 0) {
+        level--;
+        const Level& children = mLevels[level];
+        const uint32_t childX0 = 2 * x;
+        const uint32_t childY0 = 2 * y;
+        bool hasFoundChild = false;
+        for (uint32_t cy = childY0; cy < std::min( childY0 + 2, children.height ) && !hasFoundChild; cy++) {
+            for (uint32_t cx = childX0; cx < std::min( childX0 + 2, children.width ) && !hasFoundChild; cx++) {
+                if (getMinDepth( level, cx, cy ) == depth) {
+                    x = cx;
+                    y = cy;
+                    hasFoundChild = true;
+                }
+            }
+        }
+        if (!hasFoundChild) { return false; }
+    }
+
+    sample.x = x;
+    sample.y = y;
+    sample.depth = depth;
+    return true;
+}
+
+bool ArcBall::DepthPyramid::findDepth( const linAlg::vec2_t& relMousePos, const float radiusPixels, const eDepthQuery query, DepthSample& sample ) const {
+    if (mLevels.empty()) { return false; }
+
+    // cursor in pixel coordinates of the image, pixel centers sit at +0.5
+    const float imageWidth = static_cast<float>( mDesc.width );
+    const float imageHeight = static_cast<float>( mDesc.height );
+    const float cursorX = relMousePos[0] * imageWidth;
+    const float cursorY = (mDesc.isBottomUp ? 1.0f - relMousePos[1] : relMousePos[1]) * imageHeight;
+    const float radius = std::max( radiusPixels, 0.0f );
+    const float radius2 = radius * radius;
+
+    // pixels whose centers can be within the radius
+    const float minX = ceilf( cursorX - radius - 0.5f );
+    const float maxX = floorf( cursorX + radius - 0.5f );
+    const float minY = ceilf( cursorY - radius - 0.5f );
+    const float maxY = floorf( cursorY + radius - 0.5f );
+    if (maxX < 0.0f || maxY < 0.0f || minX > imageWidth - 1.0f || minY > imageHeight - 1.0f || minX > maxX || minY > maxY) { return false; }
+    const uint32_t pixelX0 = static_cast<uint32_t>( std::max( minX, 0.0f ) );
+    const uint32_t pixelX1 = static_cast<uint32_t>( std::min( maxX, imageWidth - 1.0f ) );
+    const uint32_t pixelY0 = static_cast<uint32_t>( std::max( minY, 0.0f ) );
+    const uint32_t pixelY1 = static_cast<uint32_t>( std::min( maxY, imageHeight - 1.0f ) );
+
+    // start with blocks about the size of the search disc, a handful of them covers it
+    uint32_t startLevel = 0;
+    while (startLevel + 1 < getNumLevels() && static_cast<float>( 1u << startLevel ) < 2.0f * radius) { startLevel++; }
+
+    QueryNode stack[256];
+    uint32_t stackSize = 0;
+    for (uint32_t by = pixelY0 >> startLevel; by <= (pixelY1 >> startLevel); by++) {
+        for (uint32_t bx = pixelX0 >> startLevel; bx <= (pixelX1 >> startLevel); bx++) {
+            stack[stackSize++] = QueryNode{ startLevel, bx, by };
+        }
+    }
+
+    const bool isNearestDepth = (query == eDepthQuery::NEAREST_DEPTH);
+    float bestDepth = backgroundDepth;
+    float bestDist2 = std::numeric_limits<float>::max();
+    QueryNode bestNode{ 0, 0, 0 };
+    bool hasFound = false;
+
+    while (stackSize > 0) {
+        const QueryNode node = stack[--stackSize];
+        const float nodeMinDepth = getMinDepth( node.level, node.x, node.y );
+        if (nodeMinDepth == backgroundDepth) { continue; }
+        if (isNearestDepth && nodeMinDepth >= bestDepth) { continue; }
+
+        // closest and farthest pixel center of the block
+        const float x0 = static_cast<float>( node.x << node.level ) + 0.5f;
+        const float x1 = static_cast<float>( std::min( (node.x + 1) << node.level, mDesc.width ) - 1 ) + 0.5f;
+        const float y0 = static_cast<float>( node.y << node.level ) + 0.5f;
+        const float y1 = static_cast<float>( std::min( (node.y + 1) << node.level, mDesc.height ) - 1 ) + 0.5f;
+        const float nearDx = std::max( std::max( x0 - cursorX, cursorX - x1 ), 0.0f );
+        const float nearDy = std::max( std::max( y0 - cursorY, cursorY - y1 ), 0.0f );
+        const float nearDist2 = nearDx * nearDx + nearDy * nearDy;
+        if (nearDist2 > radius2) { continue; }
+
+        if (isNearestDepth) {
+            const float farDx = std::max( fabsf( cursorX - x0 ), fabsf( cursorX - x1 ) );
+            const float farDy = std::max( fabsf( cursorY - y0 ), fabsf( cursorY - y1 ) );
+            if (farDx * farDx + farDy * farDy <= radius2) {
+                // whole block inside the disc, its min is the answer for all of it
+                bestDepth = nodeMinDepth;
+                bestNode = node;
+                hasFound = true;
+                continue;
+            }
+        } else {
+            if (nearDist2 >= bestDist2) { continue; }
+            if (node.level == 0) {
+                bestDist2 = nearDist2;
+                bestNode = node;
+                hasFound = true;
+                continue;
+            }
+        }
+
+        // children, the most promising one ends up on top of the stack
+        QueryNode children[4];
+        float childKeys[4];
+        uint32_t numChildren = 0;
+        const Level& childLevel = mLevels[node.level - 1];
+        for (uint32_t cy = 2 * node.y; cy < std::min( 2 * node.y + 2, childLevel.height ); cy++) {
+            for (uint32_t cx = 2 * node.x; cx < std::min( 2 * node.x + 2, childLevel.width ); cx++) {
+                children[numChildren] = QueryNode{ node.level - 1, cx, cy };
+                if (isNearestDepth) {
+                    childKeys[numChildren] = getMinDepth( node.level - 1, cx, cy );
+                } else {
+                    const float childCenterX = (static_cast<float>( cx ) + 0.5f) * static_cast<float>( 1u << (node.level - 1) );
+                    const float childCenterY = (static_cast<float>( cy ) + 0.5f) * static_cast<float>( 1u << (node.level - 1) );
+                    childKeys[numChildren] = (childCenterX - cursorX) * (childCenterX - cursorX) + (childCenterY - cursorY) * (childCenterY - cursorY);
+                }
+                numChildren++;
+            }
+        }
+        for (uint32_t i = 1; i < numChildren; i++) {
+            for (uint32_t j = i; j > 0 && childKeys[j - 1] < childKeys[j]; j--) {
+                std::swap( childKeys[j - 1], childKeys[j] );
+                std::swap( children[j - 1], children[j] );
+            }
+        }
+        for (uint32_t i = 0; i < numChildren; i++) {
+            stack[stackSize++] = children[i];
+        }
+    }
+
+    if (!hasFound) { return false; }
+    if (isNearestDepth) { return findArgMin( bestNode.level, bestNode.x, bestNode.y, sample ); }
+
+    sample.x = bestNode.x;
+    sample.y = bestNode.y;
+    sample.depth = getMinDepth( 0, bestNode.x, bestNode.y );
+    return true;
+}
+
+bool ArcBall::DepthPyramid::unprojectToWS( const Controls& controls, const PickProjection& projection, const DepthSample& sample, linAlg::vec3_t& posWS ) const {
+    if (mLevels.empty() || !(sample.depth < backgroundDepth)) { return false; }
+
+    const float n = mDesc.nearPlane;
+    const float f = mDesc.farPlane;
+    const bool isPerspective = projection.fovYRadAngle > 0.0f;
+    float eyeZ;
+    if (mDesc.encoding == eDepthEncoding::LINEAR_EYE_DEPTH) {
+        eyeZ = -sample.depth;
+    } else if (isPerspective) {
+        const float ndcZ = 2.0f * sample.depth - 1.0f;
+        eyeZ = 2.0f * f * n / ((f - n) * ndcZ - (f + n));
+    } else {
+        eyeZ = -(n + sample.depth * (f - n));
+    }
+
+    // pixel center, same NDC mapping as calcPickRayWS()
+    const float relX = (static_cast<float>( sample.x ) + 0.5f) / static_cast<float>( mDesc.width );
+    const float relY = (static_cast<float>( sample.y ) + 0.5f) / static_cast<float>( mDesc.height );
+    const float ndcX = 2.0f * relX - 1.0f;
+    const float ndcY = mDesc.isBottomUp ? 2.0f * relY - 1.0f : 1.0f - 2.0f * relY;
+
+    linAlg::vec3_t posES;
+    if (isPerspective) {
+        const float tanHalfFovY = tanf( 0.5f * projection.fovYRadAngle );
+        posES = linAlg::vec3_t{ ndcX * tanHalfFovY * projection.aspectRatio * -eyeZ, ndcY * tanHalfFovY * -eyeZ, eyeZ };
+    } else {
+        posES = linAlg::vec3_t{ ndcX * projection.orthoHalfHeight * projection.aspectRatio, ndcY * projection.orthoHalfHeight, eyeZ };
+    }
+
+    posWS = transformPoint( controls.getInvViewMatrix(), posES );
+    return true;
+}
+
+bool ArcBall::DepthPyramid::pickPivotWS( const Controls& controls, const PickProjection& projection, const linAlg::vec2_t& relMousePos, const float radiusPixels,
+                                         const eDepthQuery query, linAlg::vec3_t& pivotWS ) const {
+    DepthSample sample;
+    if (!findDepth( relMousePos, radiusPixels, query, sample )) { return false; }
+    return unprojectToWS( controls, projection, sample, pivotWS );
+}
@@ -0,0 +1,93 @@
+#ifndef _ARCBALLDEPTHPYRAMID_H_e2c58f17_0b9a_4d63_a4f1_6d83c72e90b5
+#define _ARCBALLDEPTHPYRAMID_H_e2c58f17_0b9a_4d63_a4f1_6d83c72e90b5
+
+// pivot picking from a read-back depth buffer, for when there is no mesh to build a PickingBVH over (point clouds, volumes, ...)
+//
+// a min/max pyramid over the depth image answers "which pixel near the cursor has a valid depth" without scanning the whole
+// neighbourhood: blocks that are entirely background, too far from the cursor or can't beat the best candidate are skipped, and
+// blocks entirely inside the search radius are answered from their min value directly
+// the pixel found gets unprojected through the current matrices of a Controls instance into a pivot for seamlessSetRotationPivotWS()
+//
+// depth values grow with the distance to the eye; background / cleared pixels (>= invalidDepth, or not finite) never get picked
+
+#include "eRetVal_ArcBall.h"
+#include "arcBallControls.h"
+#include "arcBallPicking.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace ArcBall {
+
+    enum class eDepthEncoding {
+        WINDOW_DEPTH,     // [0, 1] depth buffer values of a standard OpenGL style projection with nearPlane / farPlane
+        LINEAR_EYE_DEPTH, // distance along the view direction (-z in eye space)
+    };
+
+    enum class eDepthQuery {
+        NEAREST_DEPTH,     // the valid pixel within the radius which is closest to the eye
+        CLOSEST_TO_CURSOR, // the valid pixel within the radius which is closest to the cursor
+    };
+
+    struct DepthImageDesc {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t rowStride = 0; // in floats, 0 means width
+        bool isBottomUp = true; // first row is the bottom of the viewport, as glReadPixels() delivers it
+        eDepthEncoding encoding = eDepthEncoding::WINDOW_DEPTH;
+        float nearPlane = 0.1f;  // WINDOW_DEPTH
+        float farPlane = 1000.0f; // WINDOW_DEPTH
+        float invalidDepth = 1.0f; // values >= invalidDepth are background
+    };
+
+    struct DepthSample {
+        uint32_t x; // pixel in the depth image
+        uint32_t y;
+        float    depth;
+    };
+
+    struct DepthPyramid {
+
+        // numThreads == 0 uses all hardware threads
+        eRetVal build( const float* depthImage, const DepthImageDesc& desc, const uint32_t numThreads = 0 );
+
+        // re-reads the rectangle [x, x + width) x [y, y + height) from depthImage (same layout as for build()) and refreshes
+        // the pyramid levels above it - for viewers that only re-render dirty tiles
+        eRetVal updateRegion( const float* depthImage, const uint32_t x, const uint32_t y, const uint32_t width, const uint32_t height );
+
+        // relMousePos as for Controls::update(); pixels count if their centers are within radiusPixels of the cursor
+        bool findDepth( const linAlg::vec2_t& relMousePos, const float radiusPixels, const eDepthQuery query, DepthSample& sample ) const;
+
+        // sample through the projection and Controls::getInvViewMatrix() into WS; false for background samples
+        bool unprojectToWS( const Controls& controls, const PickProjection& projection, const DepthSample& sample, linAlg::vec3_t& posWS ) const;
+
+        // findDepth() + unprojectToWS()
+        bool pickPivotWS( const Controls& controls, const PickProjection& projection, const linAlg::vec2_t& relMousePos, const float radiusPixels,
+                          const eDepthQuery query, linAlg::vec3_t& pivotWS ) const;
+
+        const DepthImageDesc& getDesc() const { return mDesc; }
+        uint32_t getNumLevels() const { return static_cast<uint32_t>( mLevels.size() ); }
+        uint32_t getLevelWidth( const uint32_t level ) const { return mLevels[level].width; }
+        uint32_t getLevelHeight( const uint32_t level ) const { return mLevels[level].height; }
+        // background is +inf for the min, -inf for the max
+        float getMinDepth( const uint32_t level, const uint32_t x, const uint32_t y ) const { return mLevels[level].minDepth[size_t{ y } * mLevels[level].width + x]; }
+        float getMaxDepth( const uint32_t level, const uint32_t x, const uint32_t y ) const;
+
+    private:
+        struct Level {
+            uint32_t width;
+            uint32_t height;
+            std::vector<float> minDepth;
+            std::vector<float> maxDepth; // empty for level 0, where min and max are the same
+        };
+
+        float loadDepth( const float* depthImage, const uint32_t x, const uint32_t y ) const;
+        void reduceRows( const uint32_t level, const uint32_t firstRow, const uint32_t endRow, const uint32_t firstCol, const uint32_t endCol );
+        bool findArgMin( uint32_t level, uint32_t x, uint32_t y, DepthSample& sample ) const;
+
+        DepthImageDesc     mDesc;
+        std::vector<Level> mLevels; // 0 is the full resolution image, every level halves it (rounding up) down to 1 x 1
+    };
+}
+#endif // _ARCBALLDEPTHPYRAMID_H_e2c58f17_0b9a_4d63_a4f1_6d83c72e90b5
@@ -0,0 +1,207 @@
+#include "arcBallOrbitSweep.h"
+#include "arcBallParallel.h"
+
+#include <math.h>
+#include <array>
+#include <atomic>
+
+using namespace ArcBall;
+
+namespace {
+    static constexpr size_t minViewsPerThread = 4096;
+    static constexpr uint32_t maxSubdivisions = 14;
+    static constexpr float pi = 3.14159265358979323846f;
+
+    // icosahedron with edge length 2, vertices ( 0, +-1, +-phi ) and cyclic permutations
+    static constexpr float phi = 1.61803398874989484820f;
+    static constexpr std::array<linAlg::vec3_t, 12> icoVertices{ {
+        { -1.0f,  phi, 0.0f }, { 1.0f,  phi, 0.0f }, { -1.0f, -phi, 0.0f }, { 1.0f, -phi, 0.0f },
+        { 0.0f, -1.0f,  phi }, { 0.0f, 1.0f,  phi }, { 0.0f, -1.0f, -phi }, { 0.0f, 1.0f, -phi },
+        {  phi, 0.0f, -1.0f }, {  phi, 0.0f, 1.0f }, { -phi, 0.0f, -1.0f }, { -phi, 0.0f, 1.0f } } };
+
+    static constexpr std::array<std::array<uint8_t, 3>, 20> icoFaces{ {
+        { 0, 11, 5 }, { 0, 5, 1 }, { 0, 1, 7 }, { 0, 7, 10 }, { 0, 10, 11 },
+        { 1, 5, 9 }, { 5, 11, 4 }, { 11, 10, 2 }, { 10, 7, 6 }, { 7, 1, 8 },
+        { 3, 9, 4 }, { 3, 4, 2 }, { 3, 2, 6 }, { 3, 6, 8 }, { 3, 8, 9 },
+        { 4, 9, 5 }, { 2, 4, 11 }, { 6, 2, 10 }, { 8, 6, 7 }, { 9, 8, 1 } } };
+
+    // the 30 edges in order of first appearance in icoFaces
+    static constexpr std::array<std::array<uint8_t, 2>, 30> icoEdges = []() {
+        std::array<std::array<uint8_t, 2>, 30> edges{};
+        size_t numEdges = 0;
+        for (const auto& face : icoFaces) {
+            for (size_t i = 0; i < 3; i++) {
+                const uint8_t a = face[i];
+                const uint8_t b = face[(i + 1) % 3];
+                bool isKnown = false;
+                for (size_t e = 0; e < numEdges; e++) {
+                    isKnown = isKnown || (edges[e][0] == a && edges[e][1] == b) || (edges[e][0] == b && edges[e][1] == a);
+                }
+                if (!isKnown) { edges[numEdges++] = { a, b }; }
+            }
+        }
+        return edges;
+    }();
+
+    // orthonormal pattern frame
+    struct Frame {
+        linAlg::vec3_t right;
+        linAlg::vec3_t up;
+        linAlg::vec3_t front;
+    };
+
+    bool calcFrame( const OrbitSweepDesc& desc, Frame& frame ) {
+        frame.up = desc.upWS;
+        if (linAlg::dot( frame.up, frame.up ) < 1e-12f) { return false; }
+        linAlg::normalize( frame.up );
+
+        const float frontUp = linAlg::dot( desc.frontWS, frame.up );
+        frame.front = linAlg::vec3_t{ desc.frontWS[0] - frontUp * frame.up[0], desc.frontWS[1] - frontUp * frame.up[1], desc.frontWS[2] - frontUp * frame.up[2] };
+        if (linAlg::dot( frame.front, frame.front ) < 1e-12f) { return false; }
+        linAlg::normalize( frame.front );
+
+        linAlg::cross( frame.right, frame.up, frame.front );
+        return true;
+    }
+
+    linAlg::vec3_t frameToWS( const Frame& frame, const float x, const float y, const float z ) {
+        return linAlg::vec3_t{
+            x * frame.right[0] + y * frame.up[0] + z * frame.front[0],
+            x * frame.right[1] + y * frame.up[1] + z * frame.front[1],
+            x * frame.right[2] + y * frame.up[2] + z * frame.front[2] };
+    }
+
+    // point viewIdx of the geodesic grid with the given frequency (edge subdivisions), not normalized
+    linAlg::vec3_t calcIcosphereDir( const size_t viewIdx, const size_t frequency ) {
+        if (viewIdx < icoVertices.size()) { return icoVertices[viewIdx]; }
+
+        const size_t numPerEdge = frequency - 1;
+        size_t idx = viewIdx - icoVertices.size();
+        if (idx < icoEdges.size() * numPerEdge) {
+            const auto& edge = icoEdges[idx / numPerEdge];
+            const float t = static_cast<float>( idx % numPerEdge + 1 ) / static_cast<float>( frequency );
+            const linAlg::vec3_t& a = icoVertices[edge[0]];
+            const linAlg::vec3_t& b = icoVertices[edge[1]];
+            return linAlg::vec3_t{ a[0] + t * (b[0] - a[0]), a[1] + t * (b[1] - a[1]), a[2] + t * (b[2] - a[2]) };
+        }
+        idx -= icoEdges.size() * numPerEdge;
+
+        // face interior: barycentric ( i, j, frequency - i - j ), all >= 1, enumerated in rows of length 1, 2, 3, ...
+        const size_t numPerFace = (frequency - 1) * (frequency - 2) / 2;
+        const auto& face = icoFaces[idx / numPerFace];
+        const size_t r = idx % numPerFace;
+        size_t row = static_cast<size_t>( (sqrt( 8.0 * static_cast<double>( r ) + 1.0 ) - 1.0) * 0.5 );
+        while (row * (row + 1) / 2 > r) { row--; }
+        while ((row + 1) * (row + 2) / 2 <= r) { row++; }
+        const size_t col = r - row * (row + 1) / 2;
+
+        const float wa = static_cast<float>( 1 + col );
+        const float wb = static_cast<float>( 1 + row - col );
+        const float wc = static_cast<float>( frequency - 2 - row );
+        const linAlg::vec3_t& a = icoVertices[face[0]];
+        const linAlg::vec3_t& b = icoVertices[face[1]];
+        const linAlg::vec3_t& c = icoVertices[face[2]];
+        return linAlg::vec3_t{ wa * a[0] + wb * b[0] + wc * c[0], wa * a[1] + wb * b[1] + wc * c[1], wa * a[2] + wb * b[2] + wc * c[2] };
+    }
+
+    // direction from the pivot towards the eye, normalized; false if it is degenerate
+    bool calcViewDir( const OrbitSweepDesc& desc, const Frame& frame, const size_t viewIdx, linAlg::vec3_t& dirWS ) {
+        switch (desc.pattern) {
+        case eOrbitPattern::TURNTABLE: {
+            const float azimuth = 2.0f * pi * static_cast<float>( viewIdx ) / static_cast<float>( desc.numViews );
+            const float cosElevation = cosf( desc.elevationRadAngle );
+            dirWS = frameToWS( frame, cosElevation * sinf( azimuth ), sinf( desc.elevationRadAngle ), cosElevation * cosf( azimuth ) );
+        } break;
+        case eOrbitPattern::FIBONACCI_SPHERE: {
+            // golden angle spiral from top to bottom, even area per point
+            const float goldenAngle = pi * (3.0f - sqrtf( 5.0f ));
+            const float y = 1.0f - 2.0f * (static_cast<float>( viewIdx ) + 0.5f) / static_cast<float>( desc.numViews );
+            const float radius = sqrtf( fmaxf( 0.0f, 1.0f - y * y ) );
+            const float azimuth = goldenAngle * static_cast<float>( viewIdx );
+            dirWS = frameToWS( frame, radius * sinf( azimuth ), y, radius * cosf( azimuth ) );
+        } break;
+        case eOrbitPattern::ICOSPHERE: {
+            const linAlg::vec3_t p = calcIcosphereDir( viewIdx, size_t{ 1 } << desc.subdivisions );
+            dirWS = frameToWS( frame, p[0], p[1], p[2] );
+        } break;
+        case eOrbitPattern::DIRECTIONS: {
+            dirWS = desc.directionsWS[viewIdx];
+        } break;
+        default:
+            return false;
+        }
+
+        if (linAlg::dot( dirWS, dirWS ) < 1e-12f) { return false; }
+        linAlg::normalize( dirWS );
+        return true;
+    }
+
+    void calcView( const OrbitSweepDesc& desc, const Frame& frame, const linAlg::vec3_t& dirWS, linAlg::mat3x4_t& viewMatrix ) {
+        // the eye sits at pivot + |camDist| * dirWS, eye space z points along dirWS for the usual negative camDist
+        const float zSign = (desc.camDist > 0.0f) ? -1.0f : 1.0f;
+        const linAlg::vec3_t zAxis{ zSign * dirWS[0], zSign * dirWS[1], zSign * dirWS[2] };
+
+        // screen up follows frame.up; looking straight down / up it follows the direction the turntable came from
+        linAlg::vec3_t xAxis;
+        linAlg::cross( xAxis, frame.up, zAxis );
+        if (linAlg::dot( xAxis, xAxis ) < 1e-8f) {
+            const float frontSign = (linAlg::dot( dirWS, frame.up ) > 0.0f) ? -1.0f : 1.0f;
+            const linAlg::vec3_t refUp{ frontSign * frame.front[0], frontSign * frame.front[1], frontSign * frame.front[2] };
+            linAlg::cross( xAxis, refUp, zAxis );
+        }
+        linAlg::normalize( xAxis );
+        linAlg::vec3_t yAxis;
+        linAlg::cross( yAxis, zAxis, xAxis );
+
+        // rotZ(tilt) * lookRot, lookRot has the eye axes as rows
+        const float cosTilt = cosf( desc.camTiltRadAngle );
+        const float sinTilt = sinf( desc.camTiltRadAngle );
+        const linAlg::vec3_t row0{ cosTilt * xAxis[0] - sinTilt * yAxis[0], cosTilt * xAxis[1] - sinTilt * yAxis[1], cosTilt * xAxis[2] - sinTilt * yAxis[2] };
+        const linAlg::vec3_t row1{ sinTilt * xAxis[0] + cosTilt * yAxis[0], sinTilt * xAxis[1] + cosTilt * yAxis[1], sinTilt * xAxis[2] + cosTilt * yAxis[2] };
+
+        const linAlg::vec3_t& p = desc.pivotWS;
+        viewMatrix[0] = linAlg::vec4_t{ row0[0], row0[1], row0[2], -linAlg::dot( row0, p ) };
+        viewMatrix[1] = linAlg::vec4_t{ row1[0], row1[1], row1[2], -linAlg::dot( row1, p ) };
+        viewMatrix[2] = linAlg::vec4_t{ zAxis[0], zAxis[1], zAxis[2], desc.camDist - linAlg::dot( zAxis, p ) };
+    }
+}
+
+size_t ArcBall::getOrbitSweepNumViews( const OrbitSweepDesc& desc ) {
+    switch (desc.pattern) {
+    case eOrbitPattern::TURNTABLE:
+    case eOrbitPattern::FIBONACCI_SPHERE:
+        return desc.numViews;
+    case eOrbitPattern::ICOSPHERE:
+        return (desc.subdivisions <= maxSubdivisions) ? 10 * (size_t{ 1 } << (2 * desc.subdivisions)) + 2 : 0;
+    case eOrbitPattern::DIRECTIONS:
+        return (desc.directionsWS != nullptr) ? desc.numViews : 0;
+    }
+    return 0;
+}
+
+eRetVal ArcBall::calcOrbitSweepView( const OrbitSweepDesc& desc, const size_t viewIdx, linAlg::mat3x4_t& viewMatrix ) {
+    return generateOrbitSweep( desc, viewIdx, 1, &viewMatrix, 1 );
+}
+
+eRetVal ArcBall::generateOrbitSweep( const OrbitSweepDesc& desc, const size_t firstView, const size_t numViews, linAlg::mat3x4_t* viewMatrices, const uint32_t numThreads ) {
+    const size_t numSweepViews = getOrbitSweepNumViews( desc );
+    if (firstView > numSweepViews || numViews > numSweepViews - firstView) { return eRetVal::ERROR; }
+
+    Frame frame;
+    if (!calcFrame( desc, frame )) { return eRetVal::ERROR; }
+
+    std::atomic<bool> hasDegenerateDir{ false };
+    parallelForRanges( numViews, numThreads, minViewsPerThread, [&]( const size_t start, const size_t count ) {
+        for (size_t i = start; i < start + count; i++) {
+            linAlg::vec3_t dirWS{ 0.0f, 0.0f, 0.0f };
+            if (!calcViewDir( desc, frame, firstView + i, dirWS )) {
+                hasDegenerateDir.store( true, std::memory_order_relaxed );
+                dirWS = frame.front;
+            }
+            calcView( desc, frame, dirWS, viewMatrices[i] );
+        }
+    } );
+
+    // zero-length user directions still get a (front) view, so that the output is fully written
+    return hasDegenerateDir.load( std::memory_order_relaxed ) ? eRetVal::ERROR : eRetVal::OK;
+}
@@ -0,0 +1,53 @@
+#ifndef _ARCBALLORBITSWEEP_H_b5f2079c_6e31_4a8d_93c4_1f8d2e6a0b57
+#define _ARCBALLORBITSWEEP_H_b5f2079c_6e31_4a8d_93c4_1f8d2e6a0b57
+
+// headless orbit sweeps for thumbnail / multi-view dataset generation - no Controls instance, no synthetic mouse input
+//
+// every view looks at pivotWS from a direction of the chosen pattern, same conventions as Controls::getViewMatrix():
+//   view = mViewTranslationMat * mTiltRotMat * mArcRotMat = T({0,0,camDist}) * rotZ(camTiltRadAngle) * lookRot * T(-pivotWS)
+// i.e. the pivot ends up at { 0, 0, camDist } in eye space, like it does for Controls without panning
+//
+// the patterns live in the frame { right, up, front } = { up x front, up, front }, with the default up { 0, 1, 0 } that is the world frame;
+// front is the direction of the first turntable view and the default Controls view (unit arc rotation)
+// views are generated by index, so a farm can split a sweep into ranges; nothing gets allocated per view
+
+#include "eRetVal_ArcBall.h"
+#include "arcBallControls.h"
+
+#include <stdint.h>
+#include <stddef.h>
+
+namespace ArcBall {
+
+    enum class eOrbitPattern {
+        TURNTABLE,        // numViews evenly spaced around up, at elevationRadAngle above the horizon
+        FIBONACCI_SPHERE, // numViews (almost) evenly spread over the whole sphere
+        ICOSPHERE,        // vertices of an icosahedron whose faces are split into 4^subdivisions triangles, 10 * 4^subdivisions + 2 views
+        DIRECTIONS,       // numViews caller-supplied world-space directions from the pivot towards the eye, need not be normalized
+    };
+
+    struct OrbitSweepDesc {
+        linAlg::vec3_t pivotWS{ 0.0f, 0.0f, 0.0f };
+        float camDist = -5.0f; // same as for Controls::update()
+        float camTiltRadAngle = 0.0f;
+        linAlg::vec3_t upWS{ 0.0f, 1.0f, 0.0f };
+        linAlg::vec3_t frontWS{ 0.0f, 0.0f, 1.0f }; // gets orthogonalized against upWS, ERROR if parallel to it
+
+        eOrbitPattern pattern = eOrbitPattern::TURNTABLE;
+        uint32_t numViews = 0;              // TURNTABLE, FIBONACCI_SPHERE, DIRECTIONS
+        float elevationRadAngle = 0.0f;     // TURNTABLE
+        uint32_t subdivisions = 0;          // ICOSPHERE, at most 14
+        const linAlg::vec3_t* directionsWS = nullptr; // DIRECTIONS
+    };
+
+    // 0 for invalid descriptions
+    size_t getOrbitSweepNumViews( const OrbitSweepDesc& desc );
+
+    // one view, ERROR if viewIdx is out of range
+    eRetVal calcOrbitSweepView( const OrbitSweepDesc& desc, const size_t viewIdx, linAlg::mat3x4_t& viewMatrix );
+
+    // views [firstView, firstView + numViews) into viewMatrices, which must have room for numViews matrices
+    // numThreads == 0 uses all hardware threads; ERROR if the range doesn't fit the sweep
+    eRetVal generateOrbitSweep( const OrbitSweepDesc& desc, const size_t firstView, const size_t numViews, linAlg::mat3x4_t* viewMatrices, const uint32_t numThreads = 0 );
+}
+#endif // _ARCBALLORBITSWEEP_H_b5f2079c_6e31_4a8d_93c4_1f8d2e6a0b57
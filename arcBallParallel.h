@@ -0,0 +1,45 @@
+#ifndef _ARCBALLPARALLEL_H_4e7b2c90_1d6a_4f35_b8c3_a09e51d27f64
+#define _ARCBALLPARALLEL_H_4e7b2c90_1d6a_4f35_b8c3_a09e51d27f64
+
+// splits [0, numItems) into contiguous chunks, one per thread, the calling thread takes the last one
+// numThreads == 0 uses all hardware threads; no thread gets less than minItemsPerThread items, so small jobs stay on the calling thread
+//
+// the threads are spawned per call, no pool: creating + joining one costs ~15 us (transform/parallelForRanges/* in arcBallBench),
+// so callers pick minItemsPerThread for chunks of >= ~150 us of work, where that's noise - measured per item, single-threaded:
+// transformPoints() 1.1 ns, CameraPath::evaluateBatch() 140 ns, generateOrbitSweep() 55 ns, DepthPyramid::build() ~6 us per 1920 pixel row
+
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace ArcBall {
+
+    template<class rangeFunc_t> // void( size_t start, size_t count )
+    void parallelForRanges( const size_t numItems, const uint32_t numThreads, const size_t minItemsPerThread, const rangeFunc_t& rangeFunc ) {
+        size_t numChunks = (numThreads == 0) ? std::max( std::thread::hardware_concurrency(), 1u ) : numThreads;
+        numChunks = std::min( numChunks, (numItems + minItemsPerThread - 1) / minItemsPerThread );
+
+        if (numChunks <= 1) {
+            if (numItems > 0) { rangeFunc( size_t{ 0 }, numItems ); }
+            return;
+        }
+
+        std::vector<std::thread> threads;
+        threads.reserve( numChunks - 1 );
+        const size_t chunkSize = (numItems + numChunks - 1) / numChunks;
+        for (size_t start = 0; start < numItems; start += chunkSize) {
+            const size_t count = std::min( chunkSize, numItems - start );
+            if (start + count < numItems) {
+                threads.emplace_back( [&rangeFunc, start, count]() { rangeFunc( start, count ); } );
+            } else {
+                rangeFunc( start, count );
+            }
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+}
+#endif // _ARCBALLPARALLEL_H_4e7b2c90_1d6a_4f35_b8c3_a09e51d27f64
@@ -0,0 +1,395 @@
+#include "arcBallPicking.h"
+#include "arcBallParallel.h"
+#include "arcBallMath.h"
+
+#include <math.h>
+#include <algorithm>
+#include <atomic>
+
+using namespace ArcBall;
+
+namespace {
+    static constexpr uint32_t numBins = 16;
+    static constexpr uint32_t maxLeafSize = 8; // bigger leaves get split even if SAH says otherwise
+    static constexpr uint32_t maxDepth = 60; // keeps the traversal stack bounded, deeper nodes become leaves
+    static constexpr uint32_t traversalStackSize = maxDepth + 4;
+    static constexpr size_t minTrianglesPerThread = 64 * 1024;
+
+    struct Aabb {
+        linAlg::vec3_t min{ FLT_MAX, FLT_MAX, FLT_MAX };
+        linAlg::vec3_t max{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+        void grow( const linAlg::vec3_t& p ) {
+            for (int i = 0; i < 3; i++) {
+                min[i] = std::min( min[i], p[i] );
+                max[i] = std::max( max[i], p[i] );
+            }
+        }
+        void grow( const Aabb& other ) {
+            for (int i = 0; i < 3; i++) {
+                min[i] = std::min( min[i], other.min[i] );
+                max[i] = std::max( max[i], other.max[i] );
+            }
+        }
+        float calcHalfArea() const {
+            const float dx = max[0] - min[0];
+            const float dy = max[1] - min[1];
+            const float dz = max[2] - min[2];
+            return dx * dy + dy * dz + dz * dx;
+        }
+    };
+
+    // the center of the triangle bounds serves as centroid
+    float calcCentroid( const Aabb& bounds, const int axis ) {
+        return 0.5f * (bounds.min[axis] + bounds.max[axis]);
+    }
+
+    linAlg::vec3_t loadVertex( const float* positions, const uint32_t idx ) {
+        const float* p = positions + 3 * size_t{ idx };
+        return linAlg::vec3_t{ p[0], p[1], p[2] };
+    }
+
+    // entry distance of the ray into the box, FLT_MAX if it misses or only gets there after tMax
+    float intersectAabb( const linAlg::vec3_t& boundsMin, const linAlg::vec3_t& boundsMax, const linAlg::vec3_t& origin, const linAlg::vec3_t& invDir, const float tMax ) {
+        float tEnter = 0.0f;
+        float tExit = tMax;
+        for (int i = 0; i < 3; i++) {
+            const float t0 = (boundsMin[i] - origin[i]) * invDir[i];
+            const float t1 = (boundsMax[i] - origin[i]) * invDir[i];
+            tEnter = std::max( tEnter, std::min( t0, t1 ) );
+            tExit = std::min( tExit, std::max( t0, t1 ) );
+        }
+        return (tEnter <= tExit) ? tEnter : FLT_MAX;
+    }
+}
+
+// triangle bounds travel with the index while partitioning, so that the build walks memory linearly
+struct ArcBall::PickingBVH::BuildRef {
+    Aabb     bounds;
+    uint32_t triIdx;
+};
+
+// subtree which gets built by a worker thread into its own node array, and is moved into place afterwards
+struct ArcBall::PickingBVH::SubtreeJob {
+    uint32_t nodeIdx;
+    uint32_t first;
+    uint32_t count;
+    uint32_t depth;
+    std::vector<Node> nodes;
+};
+
+ArcBall::PickingBVH::PickingBVH()
+    : mPositions( nullptr )
+    , mIndices( nullptr ) {
+}
+
+void ArcBall::PickingBVH::clear() {
+    mNodes.clear();
+    mTriIndices.clear();
+    mPositions = nullptr;
+    mIndices = nullptr;
+}
+
+void ArcBall::PickingBVH::buildSubtree( BuildRef* const refs, std::vector<Node>& nodes, const uint32_t rootIdx, const uint32_t rootFirst, const uint32_t rootCount, const uint32_t rootDepth,
+                                        std::vector<SubtreeJob>* jobs, const uint32_t jobThreshold ) {
+    struct StackEntry {
+        uint32_t nodeIdx;
+        uint32_t first;
+        uint32_t count;
+        uint32_t depth;
+    };
+    std::vector<StackEntry> stack;
+    stack.push_back( StackEntry{ rootIdx, rootFirst, rootCount, rootDepth } );
+
+    while (!stack.empty()) {
+        const StackEntry entry = stack.back();
+        stack.pop_back();
+        BuildRef* const nodeRefs = refs + entry.first;
+
+        Aabb bounds;
+        Aabb centroidBounds;
+        for (uint32_t i = 0; i < entry.count; i++) {
+            const Aabb& triBounds = nodeRefs[i].bounds;
+            bounds.grow( triBounds );
+            centroidBounds.grow( linAlg::vec3_t{ calcCentroid( triBounds, 0 ), calcCentroid( triBounds, 1 ), calcCentroid( triBounds, 2 ) } );
+        }
+
+        // leaf unless it gets split below
+        Node& node = nodes[entry.nodeIdx];
+        node.boundsMin = bounds.min;
+        node.boundsMax = bounds.max;
+        node.leftOrFirst = entry.first;
+        node.numTriangles = entry.count;
+
+        if (entry.count <= 1 || entry.depth >= maxDepth) { continue; }
+        if (jobs != nullptr && entry.count <= jobThreshold) {
+            jobs->push_back( SubtreeJob{ entry.nodeIdx, entry.first, entry.count, entry.depth, {} } );
+            continue;
+        }
+
+        // binned SAH over all three axes in one pass
+        struct Bin {
+            Aabb bounds;
+            uint32_t count = 0;
+        };
+        // small nodes don't need more bins than triangles, this keeps the per-node cost down near the leaves
+        const uint32_t numNodeBins = std::min( numBins, entry.count );
+        Bin bins[3][numBins];
+        float binScale[3];
+        for (int axis = 0; axis < 3; axis++) {
+            const float extent = centroidBounds.max[axis] - centroidBounds.min[axis];
+            binScale[axis] = (extent > 0.0f) ? static_cast<float>( numNodeBins ) / extent : 0.0f;
+        }
+        auto calcBin = [&]( const Aabb& triBounds, const int axis ) {
+            const uint32_t bin = static_cast<uint32_t>( (calcCentroid( triBounds, axis ) - centroidBounds.min[axis]) * binScale[axis] );
+            return std::min( bin, numNodeBins - 1 );
+        };
+        for (uint32_t i = 0; i < entry.count; i++) {
+            const Aabb& triBounds = nodeRefs[i].bounds;
+            for (int axis = 0; axis < 3; axis++) {
+                Bin& bin = bins[axis][calcBin( triBounds, axis )];
+                bin.bounds.grow( triBounds );
+                bin.count++;
+            }
+        }
+
+        float bestCost = FLT_MAX;
+        int bestAxis = -1;
+        uint32_t bestSplitBin = 0;
+        for (int axis = 0; axis < 3; axis++) {
+            if (binScale[axis] == 0.0f) { continue; }
+
+            // left sweep stores area * count for splits after bin i, the right sweep adds its part
+            float leftCosts[numBins - 1];
+            Aabb leftBounds;
+            uint32_t leftCount = 0;
+            for (uint32_t i = 0; i < numNodeBins - 1; i++) {
+                leftBounds.grow( bins[axis][i].bounds );
+                leftCount += bins[axis][i].count;
+                leftCosts[i] = (leftCount > 0) ? leftBounds.calcHalfArea() * static_cast<float>( leftCount ) : -1.0f;
+            }
+            Aabb rightBounds;
+            uint32_t rightCount = 0;
+            for (uint32_t i = numNodeBins - 1; i > 0; i--) {
+                rightBounds.grow( bins[axis][i].bounds );
+                rightCount += bins[axis][i].count;
+                if (rightCount == 0 || leftCosts[i - 1] < 0.0f) { continue; }
+                const float cost = leftCosts[i - 1] + rightBounds.calcHalfArea() * static_cast<float>( rightCount );
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplitBin = i;
+                }
+            }
+        }
+
+        uint32_t numLeft = 0;
+        if (bestAxis >= 0) {
+            // cost model: traversal 1, triangle test 1
+            const float splitCost = 1.0f + bestCost / bounds.calcHalfArea();
+            if (entry.count <= maxLeafSize && splitCost >= static_cast<float>( entry.count )) { continue; }
+
+            BuildRef* const mid = std::partition( nodeRefs, nodeRefs + entry.count, [&]( const BuildRef& ref ) {
+                return calcBin( ref.bounds, bestAxis ) < bestSplitBin; } );
+            numLeft = static_cast<uint32_t>( mid - nodeRefs );
+        } else {
+            // all centroids in one spot, SAH can't help
+            if (entry.count <= maxLeafSize) { continue; }
+            numLeft = entry.count / 2;
+        }
+
+        const uint32_t leftIdx = static_cast<uint32_t>( nodes.size() );
+        nodes[entry.nodeIdx].leftOrFirst = leftIdx;
+        nodes[entry.nodeIdx].numTriangles = 0;
+        nodes.resize( nodes.size() + 2 );
+
+        stack.push_back( StackEntry{ leftIdx + 1, entry.first + numLeft, entry.count - numLeft, entry.depth + 1 } );
+        stack.push_back( StackEntry{ leftIdx, entry.first, numLeft, entry.depth + 1 } );
+    }
+}
+
+eRetVal ArcBall::PickingBVH::build( const float* positions, const size_t numVertices, const uint32_t* indices, const size_t numTriangles, const uint32_t numThreads ) {
+    clear();
+    if (numTriangles == 0 || numTriangles >= UINT32_MAX / 2 || positions == nullptr || indices == nullptr) { return eRetVal::ERROR; }
+
+    const uint32_t numWorkers = (numThreads == 0) ? std::max( std::thread::hardware_concurrency(), 1u ) : numThreads;
+
+    std::vector<BuildRef> refs( numTriangles );
+    std::atomic<bool> hasBadIndex{ false };
+    parallelForRanges( numTriangles, numWorkers, minTrianglesPerThread, [&]( const size_t start, const size_t count ) {
+        for (size_t t = start; t < start + count; t++) {
+            const uint32_t* tri = indices + 3 * t;
+            if (tri[0] >= numVertices || tri[1] >= numVertices || tri[2] >= numVertices) {
+                hasBadIndex.store( true, std::memory_order_relaxed );
+                continue;
+            }
+            Aabb bounds;
+            for (int i = 0; i < 3; i++) {
+                bounds.grow( loadVertex( positions, tri[i] ) );
+            }
+            refs[t] = BuildRef{ bounds, static_cast<uint32_t>( t ) };
+        }
+    } );
+    if (hasBadIndex.load( std::memory_order_relaxed )) {
+        clear();
+        return eRetVal::ERROR;
+    }
+
+    mNodes.reserve( numTriangles / 2 + 1 );
+    mNodes.resize( 1 );
+
+    if (numWorkers <= 1 || numTriangles < 2 * minTrianglesPerThread) {
+        buildSubtree( refs.data(), mNodes, 0, 0, static_cast<uint32_t>( numTriangles ), 0, nullptr, 0 );
+    } else {
+        // the top of the tree on this thread, until the subtrees are small enough to keep all workers busy
+        std::vector<SubtreeJob> jobs;
+        const uint32_t jobThreshold = static_cast<uint32_t>( std::max( numTriangles / (8 * size_t{ numWorkers }), minTrianglesPerThread ) );
+        buildSubtree( refs.data(), mNodes, 0, 0, static_cast<uint32_t>( numTriangles ), 0, &jobs, jobThreshold );
+
+        // biggest first, workers grab the next one as they become free
+        std::sort( jobs.begin(), jobs.end(), []( const SubtreeJob& a, const SubtreeJob& b ) { return a.count > b.count; } );
+        std::atomic<size_t> nextJob{ 0 };
+        parallelForRanges( numWorkers, numWorkers, 1, [&]( const size_t, const size_t ) {
+            for (size_t j = nextJob.fetch_add( 1 ); j < jobs.size(); j = nextJob.fetch_add( 1 )) {
+                SubtreeJob& job = jobs[j];
+                job.nodes.reserve( job.count / 2 + 1 );
+                job.nodes.resize( 1 );
+                buildSubtree( refs.data(), job.nodes, 0, job.first, job.count, job.depth, nullptr, 0 );
+            }
+        } );
+
+        // the job's root replaces the placeholder node, the rest gets appended - local index i > 0 ends up at base + i - 1
+        for (SubtreeJob& job : jobs) {
+            const uint32_t base = static_cast<uint32_t>( mNodes.size() );
+            for (Node& node : job.nodes) {
+                if (node.numTriangles == 0) { node.leftOrFirst = node.leftOrFirst - 1 + base; }
+            }
+            mNodes[job.nodeIdx] = job.nodes[0];
+            mNodes.insert( mNodes.end(), job.nodes.begin() + 1, job.nodes.end() );
+        }
+    }
+    mNodes.shrink_to_fit();
+
+    mTriIndices.resize( numTriangles );
+    for (size_t i = 0; i < numTriangles; i++) {
+        mTriIndices[i] = refs[i].triIdx;
+    }
+
+    mPositions = positions;
+    mIndices = indices;
+    return eRetVal::OK;
+}
+
+bool ArcBall::PickingBVH::intersect( const PickRay& rayWS, PickHit& hit, const float maxDist ) const {
+    if (mNodes.empty()) { return false; }
+
+    const linAlg::vec3_t& origin = rayWS.origin;
+    const linAlg::vec3_t& dir = rayWS.dir;
+    linAlg::vec3_t invDir;
+    for (int i = 0; i < 3; i++) {
+        // avoid 0 * inf for rays which start exactly on a slab
+        const float d = (fabsf( dir[i] ) > 1e-20f) ? dir[i] : copysignf( 1e-20f, dir[i] );
+        invDir[i] = 1.0f / d;
+    }
+
+    float tBest = maxDist;
+    uint32_t bestTriIdx = UINT32_MAX;
+    float bestU = 0.0f;
+    float bestV = 0.0f;
+
+    uint32_t stack[traversalStackSize];
+    uint32_t stackSize = 0;
+    if (intersectAabb( mNodes[0].boundsMin, mNodes[0].boundsMax, origin, invDir, tBest ) == FLT_MAX) { return false; }
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0) {
+        const Node& node = mNodes[stack[--stackSize]];
+
+        if (node.numTriangles > 0) {
+            for (uint32_t i = node.leftOrFirst; i < node.leftOrFirst + node.numTriangles; i++) {
+                // Moeller-Trumbore, both faces
+                const uint32_t triIdx = mTriIndices[i];
+                const uint32_t* tri = mIndices + 3 * size_t{ triIdx };
+                const linAlg::vec3_t v0 = loadVertex( mPositions, tri[0] );
+                const linAlg::vec3_t e1 = loadVertex( mPositions, tri[1] ) - v0;
+                const linAlg::vec3_t e2 = loadVertex( mPositions, tri[2] ) - v0;
+
+                linAlg::vec3_t p;
+                linAlg::cross( p, dir, e2 );
+                const float det = linAlg::dot( e1, p );
+                if (fabsf( det ) < 1e-20f) { continue; }
+                const float invDet = 1.0f / det;
+
+                const linAlg::vec3_t s = origin - v0;
+                const float u = linAlg::dot( s, p ) * invDet;
+                if (u < 0.0f || u > 1.0f) { continue; }
+
+                linAlg::vec3_t q;
+                linAlg::cross( q, s, e1 );
+                const float v = linAlg::dot( dir, q ) * invDet;
+                if (v < 0.0f || u + v > 1.0f) { continue; }
+
+                const float t = linAlg::dot( e2, q ) * invDet;
+                if (t >= 0.0f && t < tBest) {
+                    tBest = t;
+                    bestTriIdx = triIdx;
+                    bestU = u;
+                    bestV = v;
+                }
+            }
+            continue;
+        }
+
+        // nearer child gets visited first, so that tBest shrinks early
+        const Node& left = mNodes[node.leftOrFirst];
+        const Node& right = mNodes[node.leftOrFirst + 1];
+        const float tLeft = intersectAabb( left.boundsMin, left.boundsMax, origin, invDir, tBest );
+        const float tRight = intersectAabb( right.boundsMin, right.boundsMax, origin, invDir, tBest );
+        const bool isLeftNearer = tLeft <= tRight;
+        const float tNear = isLeftNearer ? tLeft : tRight;
+        const float tFar = isLeftNearer ? tRight : tLeft;
+        if (tFar != FLT_MAX) { stack[stackSize++] = isLeftNearer ? node.leftOrFirst + 1 : node.leftOrFirst; }
+        if (tNear != FLT_MAX) { stack[stackSize++] = isLeftNearer ? node.leftOrFirst : node.leftOrFirst + 1; }
+    }
+
+    if (bestTriIdx == UINT32_MAX) { return false; }
+
+    hit.distance = tBest;
+    hit.triangleIdx = bestTriIdx;
+    hit.baryU = bestU;
+    hit.baryV = bestV;
+    hit.posWS = linAlg::vec3_t{ origin[0] + tBest * dir[0], origin[1] + tBest * dir[1], origin[2] + tBest * dir[2] };
+    return true;
+}
+
+PickRay ArcBall::calcPickRayWS( const Controls& controls, const linAlg::vec2_t& relMousePos, const PickProjection& projection ) {
+    // same NDC mapping as Controls::mapScreenPosToArcBallPosNDC()
+    const float ndcX = 2.0f * relMousePos[0] - 1.0f;
+    const float ndcY = 1.0f - 2.0f * relMousePos[1];
+
+    linAlg::vec3_t originES{ 0.0f, 0.0f, 0.0f };
+    linAlg::vec3_t dirES{ 0.0f, 0.0f, -1.0f };
+    if (projection.fovYRadAngle > 0.0f) {
+        const float tanHalfFovY = tanf( 0.5f * projection.fovYRadAngle );
+        dirES = linAlg::vec3_t{ ndcX * tanHalfFovY * projection.aspectRatio, ndcY * tanHalfFovY, -1.0f };
+        linAlg::normalize( dirES );
+    } else {
+        originES = linAlg::vec3_t{ ndcX * projection.orthoHalfHeight * projection.aspectRatio, ndcY * projection.orthoHalfHeight, 0.0f };
+    }
+
+    const linAlg::mat3x4_t& invViewMat = controls.getInvViewMatrix();
+    PickRay rayWS;
+    rayWS.origin = transformPoint( invViewMat, originES );
+    for (int r = 0; r < 3; r++) {
+        rayWS.dir[r] = invViewMat[r][0] * dirES[0] + invViewMat[r][1] * dirES[1] + invViewMat[r][2] * dirES[2];
+    }
+    linAlg::normalize( rayWS.dir );
+    return rayWS;
+}
+
+bool ArcBall::PickingBVH::pick( const Controls& controls, const linAlg::vec2_t& relMousePos, const PickProjection& projection, PickHit& hit ) const {
+    if (!intersect( calcPickRayWS( controls, relMousePos, projection ), hit )) { return false; }
+
+    hit.posArcSpaceWS = transformPoint( controls.getArcRotMat(), hit.posWS );
+    return true;
+}
@@ -0,0 +1,86 @@
+#ifndef _ARCBALLPICKING_H_73d0a6b1_c9e4_4f2a_8b57_06e3f19d8a2c
+#define _ARCBALLPICKING_H_73d0a6b1_c9e4_4f2a_8b57_06e3f19d8a2c
+
+// pivot-under-cursor picking: a SAH BVH over an indexed triangle mesh, and rays from the mouse position through the current matrices
+// of a Controls instance; the nearest hit comes back in WS and in ArcSpaceWS, ready for
+// Controls::seamlessSetRotationPivotWS() / seamlessSetRotationPivotArcSpaceWS()
+//
+//    hit = {};
+//    if (bvh.pick( controls, relMousePos, projection, hit )) { controls.seamlessSetRotationPivotWS( hit.posWS, camTiltRadAngle, camDist ); }
+//
+// mesh positions are in WS - in large-world mode relative to Controls::getOriginWS(), just like the positions handed to the GPU
+// the BVH references the mesh arrays instead of copying them, they have to stay alive and unchanged as long as the BVH is used
+// the picking/* cases of arcBallBench time build() and pick() on terrain meshes - here 0.65 / 0.75 / 0.9 us per triangle for a
+// single-threaded build and 0.65 / 0.75 / 1.5 us per pick at 32k / 512k / 10M triangles (a 10M build: ~9 s on one thread, ~1 GB peak)
+
+#include "eRetVal_ArcBall.h"
+#include "arcBallControls.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <float.h>
+#include <vector>
+
+namespace ArcBall {
+
+    // how the application projects eye space - needed to turn mouse positions into rays
+    struct PickProjection {
+        float fovYRadAngle = 0.0f;    // > 0: perspective, the eye looks down -z
+        float aspectRatio = 1.0f;     // viewport width / height
+        float orthoHalfHeight = 1.0f; // fovYRadAngle == 0: orthographic, half of the visible height in eye space
+    };
+
+    struct PickRay {
+        linAlg::vec3_t origin;
+        linAlg::vec3_t dir; // normalized
+    };
+
+    struct PickHit {
+        linAlg::vec3_t posWS;
+        linAlg::vec3_t posArcSpaceWS;
+        float          distance; // along the ray
+        uint32_t       triangleIdx;
+        float          baryU; // hit = (1 - u - v) * v0 + u * v1 + v * v2
+        float          baryV;
+    };
+
+    // relMousePos as for Controls::update(): [0, 1] across the viewport, y pointing down
+    PickRay calcPickRayWS( const Controls& controls, const linAlg::vec2_t& relMousePos, const PickProjection& projection );
+
+    struct PickingBVH {
+        PickingBVH();
+
+        // positions: numVertices * { x, y, z }, indices: numTriangles * { i0, i1, i2 }
+        // ERROR for out-of-range indices; large meshes are built on numThreads threads (0: all hardware threads)
+        eRetVal build( const float* positions, const size_t numVertices, const uint32_t* indices, const size_t numTriangles, const uint32_t numThreads = 0 );
+        void clear();
+
+        // nearest hit closer than maxDist, both faces count; hit.posArcSpaceWS is left alone
+        bool intersect( const PickRay& rayWS, PickHit& hit, const float maxDist = FLT_MAX ) const;
+
+        bool pick( const Controls& controls, const linAlg::vec2_t& relMousePos, const PickProjection& projection, PickHit& hit ) const;
+
+        size_t getNumNodes() const { return mNodes.size(); }
+        size_t getNumTriangles() const { return mTriIndices.size(); }
+
+    private:
+        // 32 bytes; children of inner nodes are next to each other
+        struct Node {
+            linAlg::vec3_t boundsMin;
+            uint32_t       leftOrFirst; // inner node: left child, right child is leftOrFirst + 1; leaf: first entry in mTriIndices
+            linAlg::vec3_t boundsMax;
+            uint32_t       numTriangles; // 0 for inner nodes
+        };
+
+        struct BuildRef;
+        struct SubtreeJob;
+        static void buildSubtree( BuildRef* const refs, std::vector<Node>& nodes, const uint32_t rootIdx, const uint32_t first, const uint32_t count, const uint32_t depth,
+                                  std::vector<SubtreeJob>* jobs, const uint32_t jobThreshold );
+
+        std::vector<Node>     mNodes;
+        std::vector<uint32_t> mTriIndices; // triangles in leaf order
+        const float*    mPositions;
+        const uint32_t* mIndices;
+    };
+}
+#endif // _ARCBALLPICKING_H_73d0a6b1_c9e4_4f2a_8b57_06e3f19d8a2c
@@ -0,0 +1,285 @@
+#ifndef _ARCBALLQUAT_H_2c8f4e71_a05d_4b3e_9d62_e17b5a93c0f4
+#define _ARCBALLQUAT_H_2c8f4e71_a05d_4b3e_9d62_e17b5a93c0f4
+
+// quaternion helpers (and the bits of arc ball / inertia math around them) shared by the arc ball sources
+// quaternions are linAlg::vec4_t stored as { x, y, z, w }, rotations are unit quaternions
+// what BasicControls needs is templated on the scalar type; with float these go through linAlg, so Controls and
+// BasicControls<Mode, float> run the very same operations
+
+#include "arcBallControls.h"
+
+#include <stdint.h>
+#include <math.h>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+namespace ArcBall {
+
+    template<class Scalar>
+    inline constexpr Scalar practicallyZeroOf = std::numeric_limits<Scalar>::epsilon() * Scalar( 10 );
+
+    // the damping factors are the fraction of velocity lost per frame at this rate, whatever the actual frame rate is
+    template<class Scalar>
+    inline constexpr Scalar dampingReferenceFrameRate = Scalar( 60 );
+    // a drag that was held still for longer than this before LMB release doesn't fling
+    template<class Scalar>
+    inline constexpr Scalar flingTimeoutSec = Scalar( 0.1 );
+    // below this the inertia is stopped for good (and doesn't crawl along in denormals)
+    template<class Scalar>
+    inline constexpr Scalar minInertiaVelocity = Scalar( 1.0e-4 );
+
+    template<class Scalar>
+    inline constexpr std::array<Scalar, 4> identityQuatOf{ Scalar( 0 ), Scalar( 0 ), Scalar( 0 ), Scalar( 1 ) };
+    inline constexpr linAlg::vec4_t identityQuat = identityQuatOf<float>;
+
+    template<class Scalar, size_t N>
+    inline Scalar dotVec( const std::array<Scalar, N>& a, const std::array<Scalar, N>& b ) {
+        if constexpr (std::is_same_v<Scalar, float>) {
+            return linAlg::dot( a, b );
+        } else {
+            Scalar result = Scalar( 0 );
+            for (size_t i = 0; i < N; i++) { result += a[i] * b[i]; }
+            return result;
+        }
+    }
+
+    template<class Scalar, size_t N>
+    inline void normalizeVec( std::array<Scalar, N>& v ) {
+        if constexpr (std::is_same_v<Scalar, float>) {
+            linAlg::normalize( v );
+        } else {
+            const Scalar len = std::sqrt( dotVec( v, v ) );
+            if (len > Scalar( 0 )) { for (Scalar& c : v) { c /= len; } }
+        }
+    }
+
+    template<class Scalar>
+    inline std::array<Scalar, 3> crossVec( const std::array<Scalar, 3>& a, const std::array<Scalar, 3>& b ) {
+        if constexpr (std::is_same_v<Scalar, float>) {
+            linAlg::vec3_t result;
+            linAlg::cross( result, a, b );
+            return result;
+        } else {
+            return std::array<Scalar, 3>{ a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0] };
+        }
+    }
+
+    template<class Scalar>
+    inline std::array<Scalar, 3> addVec( const std::array<Scalar, 3>& a, const std::array<Scalar, 3>& b ) {
+        return std::array<Scalar, 3>{ a[0] + b[0], a[1] + b[1], a[2] + b[2] };
+    }
+
+    template<class Scalar>
+    inline std::array<Scalar, 3> subVec( const std::array<Scalar, 3>& a, const std::array<Scalar, 3>& b ) {
+        return std::array<Scalar, 3>{ a[0] - b[0], a[1] - b[1], a[2] - b[2] };
+    }
+
+    template<class Scalar>
+    inline std::array<Scalar, 3> scaleVec( const std::array<Scalar, 3>& v, const Scalar s ) {
+        return std::array<Scalar, 3>{ v[0] * s, v[1] * s, v[2] * s };
+    }
+
+    template<class Scalar>
+    inline std::array<Scalar, 4> quatMul( const std::array<Scalar, 4>& a, const std::array<Scalar, 4>& b ) {
+        return std::array<Scalar, 4>{
+            a[3] * b[0] + a[0] * b[3] + a[1] * b[2] - a[2] * b[1],
+            a[3] * b[1] - a[0] * b[2] + a[1] * b[3] + a[2] * b[0],
+            a[3] * b[2] + a[0] * b[1] - a[1] * b[0] + a[2] * b[3],
+            a[3] * b[3] - a[0] * b[0] - a[1] * b[1] - a[2] * b[2] };
+    }
+
+    template<class Scalar>
+    inline std::array<Scalar, 4> quatConjugate( const std::array<Scalar, 4>& q ) {
+        return std::array<Scalar, 4>{ -q[0], -q[1], -q[2], q[3] };
+    }
+
+    template<class Scalar>
+    inline std::array<Scalar, 3> quatRotate( const std::array<Scalar, 4>& q, const std::array<Scalar, 3>& v ) {
+        // v' = v + 2w (q.xyz x v) + 2 q.xyz x (q.xyz x v)
+        const std::array<Scalar, 3> qv{ q[0], q[1], q[2] };
+        const std::array<Scalar, 3> t = scaleVec( crossVec( qv, v ), Scalar( 2 ) );
+        const std::array<Scalar, 3> qvXt = crossVec( qv, t );
+        return std::array<Scalar, 3>{ v[0] + q[3] * t[0] + qvXt[0], v[1] + q[3] * t[1] + qvXt[1], v[2] + q[3] * t[2] + qvXt[2] };
+    }
+
+    // rotation taking unit vector "from" to unit vector "to" - half-angle trick, no trig needed
+    template<class Scalar>
+    inline std::array<Scalar, 4> quatFromTwoUnitVectors( const std::array<Scalar, 3>& from, const std::array<Scalar, 3>& to ) {
+        const std::array<Scalar, 3> axis = crossVec( from, to );
+        std::array<Scalar, 4> q{ axis[0], axis[1], axis[2], Scalar( 1 ) + dotVec( from, to ) };
+        if (q[3] <= practicallyZeroOf<Scalar>) { // (almost) opposite vectors - any axis perpendicular to "from" does the job
+            q = (std::abs( from[0] ) > std::abs( from[2] )) ? std::array<Scalar, 4>{ -from[1], from[0], Scalar( 0 ), Scalar( 0 ) }
+                                                            : std::array<Scalar, 4>{ Scalar( 0 ), -from[2], from[1], Scalar( 0 ) };
+        }
+        normalizeVec( q );
+        return q;
+    }
+
+    // q^exponent, only needed for the traditional arc ball if the max rotation is neither 180 nor 360 degrees
+    template<class Scalar>
+    inline std::array<Scalar, 4> quatPow( const std::array<Scalar, 4>& q, const Scalar exponent ) {
+        if (exponent == Scalar( 1 )) { return q; }
+        if (exponent == Scalar( 2 )) { return quatMul( q, q ); }
+        const Scalar sinHalfAngle = std::sqrt( q[0] * q[0] + q[1] * q[1] + q[2] * q[2] );
+        if (sinHalfAngle <= practicallyZeroOf<Scalar>) { return q; }
+        const Scalar halfAngle = std::atan2( sinHalfAngle, q[3] ) * exponent;
+        const Scalar s = std::sin( halfAngle ) / sinHalfAngle;
+        return std::array<Scalar, 4>{ q[0] * s, q[1] * s, q[2] * s, std::cos( halfAngle ) };
+    }
+
+    // the product of two unit quaternions is off by a few ulps - these only add up (as a random walk) over many compositions,
+    // so correcting them once |1 - |q|^2| exceeds threshold is enough; the error estimate is a single dot product
+    // returns |1 - |q|^2| from before the correction
+    template<class Scalar>
+    inline Scalar renormalizeQuat( std::array<Scalar, 4>& quat, const Scalar threshold ) {
+        const Scalar normError = Scalar( 1 ) - dotVec( quat, quat );
+        const Scalar absNormError = std::abs( normError );
+        if (!(absNormError > threshold)) { return absNormError; }
+
+        if (absNormError > Scalar( 1.0e-2 )) { // way off (a scaled matrix set as view, ...) - outside of where the Newton step converges quickly
+            normalizeVec( quat );
+            return absNormError;
+        }
+
+        // one Newton step for 1/sqrt(|q|^2) starting at 1
+        const Scalar s = Scalar( 1 ) + Scalar( 0.5 ) * normError;
+        quat = std::array<Scalar, 4>{ quat[0] * s, quat[1] * s, quat[2] * s, quat[3] * s };
+        return absNormError;
+    }
+
+    // angular velocity (axis * rad/sec) of the rotation from quatBefore to quatAfter, zero if they (practically) coincide
+    template<class Scalar>
+    inline std::array<Scalar, 3> calcStepRotVelocity( const std::array<Scalar, 4>& quatAfter, const std::array<Scalar, 4>& quatBefore, const Scalar deltaTimeSec ) {
+        std::array<Scalar, 4> stepQuat = quatMul( quatAfter, quatConjugate( quatBefore ) );
+        if (stepQuat[3] < Scalar( 0 )) { stepQuat = std::array<Scalar, 4>{ -stepQuat[0], -stepQuat[1], -stepQuat[2], -stepQuat[3] }; }
+        const Scalar sinHalfAngle = std::sqrt( stepQuat[0] * stepQuat[0] + stepQuat[1] * stepQuat[1] + stepQuat[2] * stepQuat[2] );
+        if (sinHalfAngle <= practicallyZeroOf<Scalar>) { return std::array<Scalar, 3>{ Scalar( 0 ), Scalar( 0 ), Scalar( 0 ) }; }
+        const Scalar radPerSec = Scalar( 2 ) * std::atan2( sinHalfAngle, stepQuat[3] ) / deltaTimeSec;
+        return scaleVec( std::array<Scalar, 3>{ stepQuat[0], stepQuat[1], stepQuat[2] }, radPerSec / sinHalfAngle );
+    }
+
+    // velocity v decaying as v(t) = v0 * e^(-rate * t): returns the distance covered during dt and decays v0 in place
+    // exact for any dt, so one step of dt gives the same result as n steps of dt/n
+    template<class Scalar>
+    inline Scalar integrateExpDecay( Scalar& velocity, const Scalar dampingFactor, const Scalar dt ) {
+        if (dampingFactor >= Scalar( 1 )) {
+            velocity = Scalar( 0 );
+            return Scalar( 0 );
+        }
+        const Scalar rate = -std::log( Scalar( 1 ) - dampingFactor ) * dampingReferenceFrameRate<Scalar>;
+        const Scalar decay = std::exp( -rate * dt );
+        const Scalar dist = (rate > practicallyZeroOf<Scalar>) ? velocity * (Scalar( 1 ) - decay) / rate : velocity * dt;
+        velocity *= decay;
+        return dist;
+    }
+
+    // relative screen position to a point on the arc ball, see Controls::mapScreenPosToArcBallPosNDC()
+    template<class Scalar>
+    inline std::array<Scalar, 3> screenPosToArcBallPosNDC( const Scalar relScreenX, const Scalar relScreenY ) {
+        // map cursor pos to NDC and project to unit sphere for z coordinate
+        std::array<Scalar, 3> ndc{ (Scalar( 2 ) * relScreenX) - Scalar( 1 ), Scalar( 2 ) - (Scalar( 2 ) * relScreenY) - Scalar( 1 ), Scalar( 0 ) };
+
+        const Scalar x2 = ndc[0] * ndc[0];
+        const Scalar y2 = ndc[1] * ndc[1];
+
+        // http://courses.cms.caltech.edu/cs171/assignments/hw3/hw3-notes/notes-hw3.html
+        //ndc[2] = (x2 + y2 <= 1) ? sqrt( 1 - x2 - y2 ) : 0;
+        // https://www.xarg.org/2021/07/trackball-rotation-using-quaternions/
+        ndc[2] = (x2 + y2 <= Scalar( 0.5 )) ? std::sqrt( Scalar( 1 ) - x2 - y2 ) : Scalar( 0.5 ) / (std::sqrt( x2 + y2 ));
+
+        normalizeVec( ndc );
+        return ndc;
+    }
+
+    // rotation by radAngle around the unit vector axis
+    inline linAlg::vec4_t quatFromAxisAngle( const linAlg::vec3_t& axis, const float radAngle ) {
+        const float halfAngle = 0.5f * radAngle;
+        const float sinHalfAngle = sinf( halfAngle );
+        return linAlg::vec4_t{ axis[0] * sinHalfAngle, axis[1] * sinHalfAngle, axis[2] * sinHalfAngle, cosf( halfAngle ) };
+    }
+
+    // rotation part of m, which has to be orthonormal
+    inline linAlg::vec4_t quatFromRotMat( const linAlg::mat3x4_t& m ) {
+        linAlg::vec4_t q;
+        const float trace = m[0][0] + m[1][1] + m[2][2];
+        if (trace > 0.0f) {
+            const float s = 0.5f / sqrtf( trace + 1.0f );
+            q = { (m[2][1] - m[1][2]) * s, (m[0][2] - m[2][0]) * s, (m[1][0] - m[0][1]) * s, 0.25f / s };
+        } else if (m[0][0] > m[1][1] && m[0][0] > m[2][2]) {
+            const float s = 2.0f * sqrtf( 1.0f + m[0][0] - m[1][1] - m[2][2] );
+            q = { 0.25f * s, (m[0][1] + m[1][0]) / s, (m[0][2] + m[2][0]) / s, (m[2][1] - m[1][2]) / s };
+        } else if (m[1][1] > m[2][2]) {
+            const float s = 2.0f * sqrtf( 1.0f + m[1][1] - m[0][0] - m[2][2] );
+            q = { (m[0][1] + m[1][0]) / s, 0.25f * s, (m[1][2] + m[2][1]) / s, (m[0][2] - m[2][0]) / s };
+        } else {
+            const float s = 2.0f * sqrtf( 1.0f + m[2][2] - m[0][0] - m[1][1] );
+            q = { (m[0][2] + m[2][0]) / s, (m[1][2] + m[2][1]) / s, 0.25f * s, (m[1][0] - m[0][1]) / s };
+        }
+        linAlg::normalize( q );
+        return q;
+    }
+
+    // "smallest three" compression: q and -q are the same rotation, so the largest component can be made positive and dropped,
+    // the other three are within +-1/sqrt(2) and get stored as signed 20 bit integers (~3e-6 rad); returns the index of the dropped one
+    inline constexpr float smallestThreeScale = 524287.0f * 1.41421356f;
+
+    inline uint8_t quatToSmallestThree( const linAlg::vec4_t& q, std::array<int32_t, 3>& comps ) {
+        uint8_t largestIdx = 0;
+        for (uint8_t i = 1; i < 4; i++) {
+            if (fabsf( q[i] ) > fabsf( q[largestIdx] )) { largestIdx = i; }
+        }
+        const float scale = (q[largestIdx] < 0.0f) ? -smallestThreeScale : smallestThreeScale;
+        for (uint8_t i = 0, j = 0; i < 4; i++) {
+            if (i == largestIdx) { continue; }
+            comps[j++] = static_cast<int32_t>( lrintf( q[i] * scale ) );
+        }
+        return largestIdx;
+    }
+
+    inline linAlg::vec4_t quatFromSmallestThree( const uint8_t largestIdx, const std::array<int32_t, 3>& comps ) {
+        linAlg::vec4_t q;
+        float sumSq = 0.0f;
+        for (uint8_t i = 0, j = 0; i < 4; i++) {
+            if (i == largestIdx) { continue; }
+            q[i] = static_cast<float>( comps[j++] ) / smallestThreeScale;
+            sumSq += q[i] * q[i];
+        }
+        q[largestIdx] = sqrtf( fmaxf( 1.0f - sumSq, 0.0f ) );
+        linAlg::normalize( q );
+        return q;
+    }
+
+    // m = [ rot(q) | t ]
+    template<class Scalar>
+    inline void loadRotTransMatrix( std::array<std::array<Scalar, 4>, 3>& m, const std::array<Scalar, 4>& q, const std::array<Scalar, 3>& t ) {
+        const Scalar xx = q[0] * q[0], yy = q[1] * q[1], zz = q[2] * q[2];
+        const Scalar xy = q[0] * q[1], xz = q[0] * q[2], yz = q[1] * q[2];
+        const Scalar wx = q[3] * q[0], wy = q[3] * q[1], wz = q[3] * q[2];
+        m[0] = std::array<Scalar, 4>{ Scalar( 1 ) - Scalar( 2 ) * (yy + zz), Scalar( 2 ) * (xy - wz), Scalar( 2 ) * (xz + wy), t[0] };
+        m[1] = std::array<Scalar, 4>{ Scalar( 2 ) * (xy + wz), Scalar( 1 ) - Scalar( 2 ) * (xx + zz), Scalar( 2 ) * (yz - wx), t[1] };
+        m[2] = std::array<Scalar, 4>{ Scalar( 2 ) * (xz - wy), Scalar( 2 ) * (yz + wx), Scalar( 1 ) - Scalar( 2 ) * (xx + yy), t[2] };
+    }
+
+    // shortest-arc spherical interpolation, falls back to nlerp for (almost) identical rotations
+    inline linAlg::vec4_t quatSlerp( const linAlg::vec4_t& a, const linAlg::vec4_t& bIn, const float t ) {
+        float cosAngle = a[0] * bIn[0] + a[1] * bIn[1] + a[2] * bIn[2] + a[3] * bIn[3];
+        const float sign = (cosAngle < 0.0f) ? -1.0f : 1.0f;
+        cosAngle *= sign;
+        const linAlg::vec4_t b{ bIn[0] * sign, bIn[1] * sign, bIn[2] * sign, bIn[3] * sign };
+
+        float wa = 1.0f - t;
+        float wb = t;
+        if (cosAngle < 0.9995f) {
+            const float angle = acosf( cosAngle );
+            const float invSin = 1.0f / sinf( angle );
+            wa = sinf( wa * angle ) * invSin;
+            wb = sinf( wb * angle ) * invSin;
+        }
+        linAlg::vec4_t q{ wa * a[0] + wb * b[0], wa * a[1] + wb * b[1], wa * a[2] + wb * b[2], wa * a[3] + wb * b[3] };
+        linAlg::normalize( q );
+        return q;
+    }
+}
+#endif // _ARCBALLQUAT_H_2c8f4e71_a05d_4b3e_9d62_e17b5a93c0f4
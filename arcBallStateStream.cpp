@@ -0,0 +1,231 @@
+#include "arcBallStateStream.h"
+#include "arcBallQuat.h"
+
+#include <string.h>
+#include <math.h>
+
+using namespace ArcBall;
+
+namespace {
+    static constexpr uint8_t noState = 0xFF;
+
+    static constexpr uint8_t flagBit( const eStateStreamFlag flag ) { return static_cast<uint8_t>( flag ); }
+
+    static constexpr uint8_t allFieldsFlags = flagBit( eStateStreamFlag::ROTATION ) | flagBit( eStateStreamFlag::PIVOT ) | flagBit( eStateStreamFlag::PAN ) |
+                                              flagBit( eStateStreamFlag::CAM_DIST ) | flagBit( eStateStreamFlag::TILT ) | flagBit( eStateStreamFlag::ORIGIN );
+
+    static int64_t quantize( const float value, const float step ) {
+        return llrint( static_cast<double>( value ) / static_cast<double>( step ) );
+    }
+
+    static float dequantize( const int64_t value, const float step ) {
+        return static_cast<float>( static_cast<double>( value ) * static_cast<double>( step ) );
+    }
+
+    static void putVarint( std::vector<uint8_t>& packet, uint64_t value ) {
+        while (value >= 0x80u) {
+            packet.push_back( static_cast<uint8_t>( value | 0x80u ) );
+            value >>= 7;
+        }
+        packet.push_back( static_cast<uint8_t>( value ) );
+    }
+
+    static void putZigzag( std::vector<uint8_t>& packet, const int64_t value ) {
+        putVarint( packet, (static_cast<uint64_t>( value ) << 1) ^ static_cast<uint64_t>( value >> 63 ) );
+    }
+
+    template<class T>
+    static void putRaw( std::vector<uint8_t>& packet, const T& value ) {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>( &value );
+        packet.insert( packet.end(), bytes, bytes + sizeof( T ) );
+    }
+
+    struct Cursor {
+        const uint8_t* p;
+        const uint8_t* end;
+
+        template<class T>
+        bool getRaw( T& value ) {
+            if (static_cast<size_t>( end - p ) < sizeof( T )) { return false; }
+            memcpy( &value, p, sizeof( T ) );
+            p += sizeof( T );
+            return true;
+        }
+        bool getVarint( uint64_t& value ) {
+            value = 0;
+            for (uint32_t shift = 0; shift < 64; shift += 7) {
+                if (p == end) { return false; }
+                const uint8_t byte = *p++;
+                value |= static_cast<uint64_t>( byte & 0x7Fu ) << shift;
+                if ((byte & 0x80u) == 0) { return true; }
+            }
+            return false;
+        }
+        bool getZigzag( int64_t& value ) {
+            uint64_t zigzag;
+            if (!getVarint( zigzag )) { return false; }
+            value = static_cast<int64_t>( (zigzag >> 1) ^ (~(zigzag & 1u) + 1u) );
+            return true;
+        }
+    };
+}
+
+ArcBall::StateStreamEncoder::StateStreamEncoder( const StateStreamQuantization& quantization, const uint32_t keyframeInterval )
+    : mQuantization( quantization )
+    , mKeyframeInterval( keyframeInterval )
+    , mSequence( 0 )
+    , mNumPacketsSinceKeyframe( 0 )
+    , mNeedsKeyframe( true ) {
+
+    memset( &mState, 0, sizeof( mState ) );
+    mState.rotLargestIdx = noState;
+}
+
+void ArcBall::StateStreamEncoder::encode( const Controls& controls, std::vector<uint8_t>& packet ) {
+    const CameraKeyframe keyframe = CameraPath::captureKeyframe( 0.0, controls );
+
+    StreamState state;
+    state.rotLargestIdx = quatToSmallestThree( keyframe.arcQuat, state.rot );
+    for (int i = 0; i < 3; i++) {
+        state.pivotWS[i] = quantize( keyframe.pivotWS[i], mQuantization.positionStep );
+        state.panVector[i] = quantize( keyframe.panVector[i], mQuantization.positionStep );
+    }
+    state.camDist = quantize( keyframe.camDist, mQuantization.positionStep );
+    state.camTiltRadAngle = quantize( keyframe.camTiltRadAngle, mQuantization.angleStep );
+    state.originWS = controls.getOriginWS();
+
+    const bool isKeyframe = mNeedsKeyframe || mNumPacketsSinceKeyframe + 1 >= mKeyframeInterval;
+    const StreamState& base = mState;
+
+    uint8_t flags = 0;
+    if (isKeyframe) {
+        flags = flagBit( eStateStreamFlag::KEYFRAME ) | allFieldsFlags;
+    } else {
+        if (state.rotLargestIdx != base.rotLargestIdx || state.rot != base.rot) { flags |= flagBit( eStateStreamFlag::ROTATION ); }
+        if (state.pivotWS != base.pivotWS) { flags |= flagBit( eStateStreamFlag::PIVOT ); }
+        if (state.panVector != base.panVector) { flags |= flagBit( eStateStreamFlag::PAN ); }
+        if (state.camDist != base.camDist) { flags |= flagBit( eStateStreamFlag::CAM_DIST ); }
+        if (state.camTiltRadAngle != base.camTiltRadAngle) { flags |= flagBit( eStateStreamFlag::TILT ); }
+        if (state.originWS != base.originWS) { flags |= flagBit( eStateStreamFlag::ORIGIN ); }
+    }
+
+    mSequence++;
+
+    packet.clear();
+    packet.push_back( flags );
+    putVarint( packet, mSequence );
+    if (isKeyframe) {
+        putRaw( packet, mQuantization.positionStep );
+        putRaw( packet, mQuantization.angleStep );
+    }
+    if (flags & flagBit( eStateStreamFlag::ORIGIN )) {
+        for (const double coord : state.originWS) { putRaw( packet, coord ); }
+    }
+    if (flags & flagBit( eStateStreamFlag::ROTATION )) {
+        // the components are only comparable to the previous ones if the same one got dropped
+        const bool isRotDelta = !isKeyframe && state.rotLargestIdx == base.rotLargestIdx;
+        packet.push_back( state.rotLargestIdx );
+        for (int i = 0; i < 3; i++) { putZigzag( packet, int64_t{ state.rot[i] } - (isRotDelta ? base.rot[i] : 0) ); }
+    }
+    if (flags & flagBit( eStateStreamFlag::PIVOT )) {
+        for (int i = 0; i < 3; i++) { putZigzag( packet, state.pivotWS[i] - (isKeyframe ? 0 : base.pivotWS[i]) ); }
+    }
+    if (flags & flagBit( eStateStreamFlag::PAN )) {
+        for (int i = 0; i < 3; i++) { putZigzag( packet, state.panVector[i] - (isKeyframe ? 0 : base.panVector[i]) ); }
+    }
+    if (flags & flagBit( eStateStreamFlag::CAM_DIST )) { putZigzag( packet, state.camDist - (isKeyframe ? 0 : base.camDist) ); }
+    if (flags & flagBit( eStateStreamFlag::TILT )) { putZigzag( packet, state.camTiltRadAngle - (isKeyframe ? 0 : base.camTiltRadAngle) ); }
+
+    mState = state;
+    mNumPacketsSinceKeyframe = isKeyframe ? 0 : mNumPacketsSinceKeyframe + 1;
+    mNeedsKeyframe = false;
+}
+
+ArcBall::StateStreamDecoder::StateStreamDecoder()
+    : mSequence( 0 )
+    , mNeedsKeyframe( true ) {
+
+    memset( &mState, 0, sizeof( mState ) );
+    mState.rotLargestIdx = noState;
+    memset( &mKeyframe, 0, sizeof( mKeyframe ) );
+}
+
+eRetVal ArcBall::StateStreamDecoder::decode( const std::span<const uint8_t> packet ) {
+    Cursor cursor{ packet.data(), packet.data() + packet.size() };
+
+    uint8_t flags;
+    uint64_t sequence;
+    if (!cursor.getRaw( flags ) || !cursor.getVarint( sequence )) { return eRetVal::ERROR; }
+
+    const bool isKeyframe = (flags & flagBit( eStateStreamFlag::KEYFRAME )) != 0;
+    if (!isKeyframe && (mNeedsKeyframe || sequence != uint64_t{ mSequence } + 1)) {
+        mNeedsKeyframe = true;
+        return eRetVal::ERROR;
+    }
+
+    // decode into copies, a truncated packet must not leave a half-updated state behind
+    StateStreamQuantization quantization = mQuantization;
+    StreamState state = mState;
+    if (isKeyframe) {
+        if (!cursor.getRaw( quantization.positionStep ) || !cursor.getRaw( quantization.angleStep )) { return eRetVal::ERROR; }
+        if (!(quantization.positionStep > 0.0f) || !(quantization.angleStep > 0.0f)) { return eRetVal::ERROR; }
+        if ((flags & allFieldsFlags) != allFieldsFlags) { return eRetVal::ERROR; }
+    }
+    if (flags & flagBit( eStateStreamFlag::ORIGIN )) {
+        for (double& coord : state.originWS) {
+            if (!cursor.getRaw( coord )) { return eRetVal::ERROR; }
+        }
+    }
+    if (flags & flagBit( eStateStreamFlag::ROTATION )) {
+        uint8_t largestIdx;
+        if (!cursor.getRaw( largestIdx ) || largestIdx > 3) { return eRetVal::ERROR; }
+        const bool isRotDelta = !isKeyframe && largestIdx == state.rotLargestIdx;
+        for (int i = 0; i < 3; i++) {
+            int64_t value;
+            if (!cursor.getZigzag( value )) { return eRetVal::ERROR; }
+            state.rot[i] = static_cast<int32_t>( value + (isRotDelta ? state.rot[i] : 0) );
+        }
+        state.rotLargestIdx = largestIdx;
+    }
+    const auto getField = [&]( int64_t& field ) {
+        int64_t value;
+        if (!cursor.getZigzag( value )) { return false; }
+        field = value + (isKeyframe ? 0 : field);
+        return true;
+    };
+    if (flags & flagBit( eStateStreamFlag::PIVOT )) {
+        if (!getField( state.pivotWS[0] ) || !getField( state.pivotWS[1] ) || !getField( state.pivotWS[2] )) { return eRetVal::ERROR; }
+    }
+    if (flags & flagBit( eStateStreamFlag::PAN )) {
+        if (!getField( state.panVector[0] ) || !getField( state.panVector[1] ) || !getField( state.panVector[2] )) { return eRetVal::ERROR; }
+    }
+    if (flags & flagBit( eStateStreamFlag::CAM_DIST )) {
+        if (!getField( state.camDist )) { return eRetVal::ERROR; }
+    }
+    if (flags & flagBit( eStateStreamFlag::TILT )) {
+        if (!getField( state.camTiltRadAngle )) { return eRetVal::ERROR; }
+    }
+    if (cursor.p != cursor.end) { return eRetVal::ERROR; }
+
+    mQuantization = quantization;
+    mState = state;
+    mSequence = static_cast<uint32_t>( sequence );
+    mNeedsKeyframe = false;
+
+    mKeyframe.timeSec = 0.0;
+    mKeyframe.arcQuat = quatFromSmallestThree( mState.rotLargestIdx, mState.rot );
+    for (int i = 0; i < 3; i++) {
+        mKeyframe.pivotWS[i] = dequantize( mState.pivotWS[i], mQuantization.positionStep );
+        mKeyframe.panVector[i] = dequantize( mState.panVector[i], mQuantization.positionStep );
+    }
+    mKeyframe.camDist = dequantize( mState.camDist, mQuantization.positionStep );
+    mKeyframe.camTiltRadAngle = dequantize( mState.camTiltRadAngle, mQuantization.angleStep );
+
+    return eRetVal::OK;
+}
+
+eRetVal ArcBall::StateStreamDecoder::apply( Controls& controls ) const {
+    if (!hasState()) { return eRetVal::ERROR; }
+    CameraPath::applyKeyframe( controls, mKeyframe );
+    return eRetVal::OK;
+}
@@ -0,0 +1,115 @@
+#ifndef _ARCBALLSTATESTREAM_H_b71e4c09_5a3d_4f82_9c16_e08d2a7f35c4
+#define _ARCBALLSTATESTREAM_H_b71e4c09_5a3d_4f82_9c16_e08d2a7f35c4
+
+// compact binary stream of the view of one ArcBall::Controls (the presenter) for any number of mirroring followers
+//
+// the state is the one of a CameraKeyframe (arc rotation, pivot, pan, tilt, distance - see arcBallCameraPath.h) plus the large-world origin,
+// quantized to integers: the rotation as "smallest three" quaternion (arcBallQuat.h), positions and distance in
+// multiples of positionStep, the tilt in multiples of angleStep
+// every packet is a keyframe (all fields absolute) or a delta against the packet before it (only the changed fields, as varints) -
+// since both ends work on the same integers and followers rebuild their Controls from them from scratch, nothing drifts, however long the session
+//
+// packets have to arrive in order (TCP, in-process queues, ...); a decoder that missed a packet rejects deltas until the next keyframe,
+// which the encoder sends every keyframeInterval packets, or right away after requestKeyframe()
+// the stream/* cases of arcBallBench time encode(), decode() and apply() per packet over a scripted session and report its packet
+// sizes - about 10 bytes per packet on average (keyframes ~58), ~600 bytes/s at 60 Hz
+//
+// packet layout (little endian):
+//   uint8 flags (eStateStreamFlag), varint sequence
+//   keyframes: float positionStep, float angleStep
+//   if ORIGIN: double originWS[3]
+//   if ROTATION: uint8 index of the dropped (largest) component, 3 zigzag varints - deltas if the index is the one of the previous packet
+//   if PIVOT / PAN: 3 zigzag varints each, if CAM_DIST / TILT: 1 zigzag varint each - deltas unless the packet is a keyframe
+
+#include "eRetVal_ArcBall.h"
+#include "arcBallControls.h"
+#include "arcBallCameraPath.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <array>
+#include <span>
+#include <vector>
+
+namespace ArcBall {
+
+    enum class eStateStreamFlag : uint8_t {
+        KEYFRAME = 1u << 0,
+        ROTATION = 1u << 1,
+        PIVOT    = 1u << 2,
+        PAN      = 1u << 3,
+        CAM_DIST = 1u << 4,
+        TILT     = 1u << 5,
+        ORIGIN   = 1u << 6,
+    };
+
+    struct StateStreamQuantization {
+        float positionStep = 1.0f / 8192.0f; // pivot, pan and camDist, in WS units
+        float angleStep = 1.0e-5f;           // tilt, in rad
+    };
+
+    // how far the elements of a follower's view matrix can be off the presenter's, however long the session: half a step on each of pan,
+    // distance and pivot, plus the rotation error (~3e-6 rad from the smallest three and half an angleStep of tilt, with room for float
+    // rounding) acting on positions up to viewScale away - the pivot's distance from the origin plus the camera distance
+    inline float calcStateStreamTolerance( const StateStreamQuantization& quantization, const float viewScale ) {
+        return 2.0f * quantization.positionStep + (4.0e-6f + quantization.angleStep) * viewScale;
+    }
+
+    // the quantized state both ends agree on
+    struct StreamState {
+        uint8_t  rotLargestIdx; // 0xFF: no state yet
+        std::array<int32_t, 3> rot;
+        std::array<int64_t, 3> pivotWS;
+        std::array<int64_t, 3> panVector;
+        int64_t  camDist;
+        int64_t  camTiltRadAngle;
+        std::array<double, 3> originWS;
+    };
+
+    struct StateStreamEncoder {
+        explicit StateStreamEncoder( const StateStreamQuantization& quantization = {}, const uint32_t keyframeInterval = 120 );
+
+        // replaces packet with the current view of controls (tilt and distance of its last update()), a few bytes unless it is a keyframe
+        void encode( const Controls& controls, std::vector<uint8_t>& packet );
+        // the next packet will be a keyframe - e.g. when a follower joins or reports a gap
+        void requestKeyframe() { mNeedsKeyframe = true; }
+
+        uint32_t getSequence() const { return mSequence; } // of the last packet
+        const StateStreamQuantization& getQuantization() const { return mQuantization; }
+
+    private:
+        StateStreamQuantization mQuantization;
+        uint32_t    mKeyframeInterval;
+        uint32_t    mSequence;
+        uint32_t    mNumPacketsSinceKeyframe;
+        bool        mNeedsKeyframe;
+        StreamState mState; // of the last packet
+    };
+
+    struct StateStreamDecoder {
+        StateStreamDecoder();
+
+        // ERROR for malformed packets and for deltas that don't follow the last decoded packet; the decoded state stays as it was then,
+        // and needsKeyframe() tells that only a keyframe can continue the stream
+        eRetVal decode( const std::span<const uint8_t> packet );
+
+        // puts controls into the decoded view (CameraPath::applyKeyframe()) - the next update() with the decoded tilt and distance
+        // yields that view, and rotates around the decoded pivot; ERROR if nothing has been decoded yet
+        // the view is relative to getOriginWS(), the origin of controls itself is left alone
+        eRetVal apply( Controls& controls ) const;
+
+        bool hasState() const { return mState.rotLargestIdx != 0xFF; }
+        bool needsKeyframe() const { return mNeedsKeyframe; }
+        uint32_t getSequence() const { return mSequence; } // of the last decoded packet
+        const CameraKeyframe& getKeyframe() const { return mKeyframe; } // timeSec is 0
+        const std::array<double, 3>& getOriginWS() const { return mState.originWS; }
+
+    private:
+        StateStreamQuantization mQuantization;
+        uint32_t       mSequence;
+        bool           mNeedsKeyframe;
+        StreamState    mState;
+        CameraKeyframe mKeyframe; // dequantized mState
+    };
+}
+#endif // _ARCBALLSTATESTREAM_H_b71e4c09_5a3d_4f82_9c16_e08d2a7f35c4
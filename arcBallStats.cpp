@@ -0,0 +1,120 @@
+#include "arcBallStats.h"
+
+#include <string.h>
+#include <bit>
+
+using namespace ArcBall;
+
+namespace {
+    static constexpr uint32_t numCounters = static_cast<uint32_t>( eStatCounter::NUM_COUNTERS );
+    static constexpr uint32_t numTimers = static_cast<uint32_t>( eStatTimer::NUM_TIMERS );
+
+    struct GlobalHistogram {
+        std::atomic<uint64_t> buckets[LatencyHistogram::numBuckets];
+        std::atomic<uint64_t> numSamples;
+        std::atomic<uint64_t> totalNs;
+        std::atomic<uint64_t> maxNs;
+    };
+
+    // zero-initialized as a static
+    struct GlobalStats {
+        std::atomic<uint64_t> counters[numCounters];
+        GlobalHistogram timers[numTimers];
+    };
+
+    static GlobalStats globalStats;
+}
+
+uint64_t ArcBall::LatencyHistogram::getPercentileNs( const double percentile ) const {
+    if (numSamples == 0) { return 0; }
+
+    const uint64_t rank = static_cast<uint64_t>( percentile * static_cast<double>( numSamples - 1 ) ) + 1;
+    uint64_t numSeen = 0;
+    for (uint32_t i = 0; i < numBuckets; i++) {
+        numSeen += buckets[i];
+        if (numSeen >= rank) {
+            const uint64_t bucketEnd = (uint64_t{ 1 } << (i + 1)) - 1;
+            return (bucketEnd < maxNs) ? bucketEnd : maxNs;
+        }
+    }
+    return maxNs;
+}
+
+StatsSnapshot ArcBall::getGlobalStats() {
+    StatsSnapshot snapshot;
+    memset( &snapshot, 0, sizeof( snapshot ) );
+
+#if defined( ARCBALL_INSTRUMENTATION )
+    snapshot.isEnabled = true;
+    for (uint32_t i = 0; i < numCounters; i++) {
+        snapshot.counters[i] = globalStats.counters[i].load( std::memory_order_relaxed );
+    }
+    for (uint32_t t = 0; t < numTimers; t++) {
+        const GlobalHistogram& src = globalStats.timers[t];
+        LatencyHistogram& dst = snapshot.timers[t];
+        for (uint32_t b = 0; b < LatencyHistogram::numBuckets; b++) {
+            dst.buckets[b] = src.buckets[b].load( std::memory_order_relaxed );
+        }
+        dst.numSamples = src.numSamples.load( std::memory_order_relaxed );
+        dst.totalNs = src.totalNs.load( std::memory_order_relaxed );
+        dst.maxNs = src.maxNs.load( std::memory_order_relaxed );
+    }
+#endif
+
+    return snapshot;
+}
+
+void ArcBall::resetGlobalStats() {
+    for (auto& counter : globalStats.counters) {
+        counter.store( 0, std::memory_order_relaxed );
+    }
+    for (auto& timer : globalStats.timers) {
+        for (auto& bucket : timer.buckets) {
+            bucket.store( 0, std::memory_order_relaxed );
+        }
+        timer.numSamples.store( 0, std::memory_order_relaxed );
+        timer.totalNs.store( 0, std::memory_order_relaxed );
+        timer.maxNs.store( 0, std::memory_order_relaxed );
+    }
+}
+
+#if defined( ARCBALL_INSTRUMENTATION )
+namespace {
+    static uint32_t calcBucket( const uint64_t ns ) {
+        const uint32_t bucket = (ns == 0) ? 0 : static_cast<uint32_t>( std::bit_width( ns ) ) - 1;
+        return (bucket < LatencyHistogram::numBuckets) ? bucket : LatencyHistogram::numBuckets - 1;
+    }
+}
+
+void ArcBall::stats::InstanceStats::reset() {
+    memset( counters, 0, sizeof( counters ) );
+    memset( timers, 0, sizeof( timers ) );
+    maxArcQuatNormError = 0.0f;
+}
+
+void ArcBall::stats::count( InstanceStats& instanceStats, const eStatCounter counter ) {
+    if (instanceStats.isSuspended) { return; }
+    const uint32_t idx = static_cast<uint32_t>( counter );
+    instanceStats.counters[idx]++;
+    globalStats.counters[idx].fetch_add( 1, std::memory_order_relaxed );
+}
+
+void ArcBall::stats::addTime( InstanceStats& instanceStats, const eStatTimer timer, const uint64_t ns ) {
+    if (instanceStats.isSuspended) { return; }
+    const uint32_t idx = static_cast<uint32_t>( timer );
+    const uint32_t bucket = calcBucket( ns );
+
+    LatencyHistogram& histogram = instanceStats.timers[idx];
+    histogram.buckets[bucket]++;
+    histogram.numSamples++;
+    histogram.totalNs += ns;
+    if (ns > histogram.maxNs) { histogram.maxNs = ns; }
+
+    GlobalHistogram& globalHistogram = globalStats.timers[idx];
+    globalHistogram.buckets[bucket].fetch_add( 1, std::memory_order_relaxed );
+    globalHistogram.numSamples.fetch_add( 1, std::memory_order_relaxed );
+    globalHistogram.totalNs.fetch_add( ns, std::memory_order_relaxed );
+    uint64_t prevMaxNs = globalHistogram.maxNs.load( std::memory_order_relaxed );
+    while (ns > prevMaxNs && !globalHistogram.maxNs.compare_exchange_weak( prevMaxNs, ns, std::memory_order_relaxed )) {}
+}
+#endif
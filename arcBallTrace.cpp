@@ -0,0 +1,471 @@
+#include "arcBallTrace.h"
+
+#include <string.h>
+#include <math.h>
+
+#if defined( __unix__ ) || defined( __APPLE__ )
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #define ARCBALL_TRACE_MMAP
+#endif
+
+using namespace ArcBall;
+
+namespace {
+    static constexpr char traceMagic[4] = { 'A', 'B', 'T', 'R' };
+    static constexpr size_t traceHeaderSize = sizeof( traceMagic ) + 2 * sizeof( uint32_t );
+    static constexpr size_t recordHeaderSize = sizeof( uint8_t ) + sizeof( uint32_t );
+    static constexpr size_t flushThreshold = 1 << 20;
+
+    // MouseEvent without the struct padding
+    static constexpr uint32_t mouseEventSize = sizeof( double ) + 4 * sizeof( float ) + sizeof( uint8_t );
+
+    struct Cursor {
+        const uint8_t* p;
+        const uint8_t* end;
+
+        template<class T>
+        bool get( T& value ) {
+            if (remaining() < sizeof( T )) { return false; }
+            memcpy( &value, p, sizeof( T ) );
+            p += sizeof( T );
+            return true;
+        }
+        size_t remaining() const { return static_cast<size_t>( end - p ); }
+        bool get( bool& value ) {
+            uint8_t byte;
+            if (!get( byte )) { return false; }
+            value = (byte != 0);
+            return true;
+        }
+    };
+}
+
+ArcBall::TraceRecorder::TraceRecorder()
+    : mFile( nullptr )
+    , mHasConfig( false )
+    , mRecordViewMatrices( false )
+    , mWriteFailed( false )
+    , mCallDepth( 0 ) {
+}
+
+ArcBall::TraceRecorder::~TraceRecorder() {
+    close();
+}
+
+eRetVal ArcBall::TraceRecorder::open( const char* filePath, const bool recordViewMatrices ) {
+    close();
+
+    mFile = fopen( filePath, "wb" );
+    if (mFile == nullptr) { return eRetVal::ERROR; }
+
+    mRecordViewMatrices = recordViewMatrices;
+    mHasConfig = false;
+    mWriteFailed = false;
+    mBuffer.clear();
+    mBuffer.reserve( flushThreshold + 4096 );
+
+    for (const char c : traceMagic) { put( c ); }
+    put( version );
+    put( recordViewMatrices ? flagViewMatrices : 0u );
+
+    return eRetVal::OK;
+}
+
+eRetVal ArcBall::TraceRecorder::close() {
+    if (mFile == nullptr) { return eRetVal::OK; }
+
+    const bool writeOk = (fwrite( mBuffer.data(), 1, mBuffer.size(), mFile ) == mBuffer.size());
+    mBuffer.clear();
+    const bool closeOk = (fclose( mFile ) == 0);
+    mFile = nullptr;
+
+    return (writeOk && closeOk && !mWriteFailed) ? eRetVal::OK : eRetVal::ERROR;
+}
+
+template<class T>
+void ArcBall::TraceRecorder::put( const T& value ) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>( &value );
+    mBuffer.insert( mBuffer.end(), bytes, bytes + sizeof( T ) );
+}
+
+void ArcBall::TraceRecorder::flushIfFull() {
+    if (mBuffer.size() < flushThreshold) { return; }
+    // recording goes on (calls into Controls can't fail because of the trace), close() reports it
+    if (fwrite( mBuffer.data(), 1, mBuffer.size(), mFile ) != mBuffer.size()) { mWriteFailed = true; }
+    mBuffer.clear();
+}
+
+void ArcBall::TraceRecorder::beginRecord( const Controls& controls, const eTraceRecord type, const uint32_t payloadSize ) {
+    flushIfFull();
+
+    const Controls::InteractionModeDesc modeDesc = controls.getInteractionMode();
+    const Config config{
+        static_cast<uint8_t>( modeDesc.fullCircle ),
+        static_cast<uint8_t>( modeDesc.smooth ),
+        controls.getRotDampingFactor(),
+        controls.getPanDampingFactor(),
+        controls.getMouseSensitivity(),
+        controls.getMaxTraditionalRotDeg(),
+        controls.getDeadZone(),
+        controls.getRebaseDist(),
+        static_cast<uint8_t>( controls.getLargeWorldMode() ),
+        controls.getSettleThreshold(),
+        controls.getRenormThreshold() };
+
+    if (!mHasConfig || !(config == mLastConfig)) {
+        put( static_cast<uint8_t>( eTraceRecord::CONFIG ) );
+        put( static_cast<uint32_t>( 3 * sizeof( uint8_t ) + 8 * sizeof( float ) ) );
+        put( config.fullCircle );
+        put( config.smooth );
+        put( config.rotDampingFactor );
+        put( config.panDampingFactor );
+        put( config.mouseSensitivity );
+        put( config.maxTraditionalRotDeg );
+        put( config.deadZone );
+        put( config.rebaseDist );
+        put( config.largeWorldMode );
+        put( config.settleThreshold );
+        put( config.renormThreshold );
+        mLastConfig = config;
+        mHasConfig = true;
+    }
+
+    put( static_cast<uint8_t>( type ) );
+    put( payloadSize );
+}
+
+void ArcBall::TraceRecorder::recordUpdate( const Controls& controls, const float deltaTimeSec, const float relMouseX, const float relMouseY, const float relMouse_dx, const float relMouse_dy, const float camDist, const linAlg::vec3_t& camPanDelta, const float camTiltRadAngle, const bool LMBpressed ) {
+    beginRecord( controls, eTraceRecord::UPDATE, 10 * sizeof( float ) + sizeof( uint8_t ) );
+    put( deltaTimeSec );
+    put( relMouseX );
+    put( relMouseY );
+    put( relMouse_dx );
+    put( relMouse_dy );
+    put( camDist );
+    put( camPanDelta );
+    put( camTiltRadAngle );
+    put( static_cast<uint8_t>( LMBpressed ) );
+}
+
+void ArcBall::TraceRecorder::recordIngestEvents( const Controls& controls, const float deltaTimeSec, const std::span<const Controls::MouseEvent> events, const float camDist, const linAlg::vec3_t& camPanDelta, const float camTiltRadAngle ) {
+    beginRecord( controls, eTraceRecord::INGEST_EVENTS, 6 * sizeof( float ) + sizeof( uint32_t ) + static_cast<uint32_t>( events.size() ) * mouseEventSize );
+    put( deltaTimeSec );
+    put( camDist );
+    put( camPanDelta );
+    put( camTiltRadAngle );
+    put( static_cast<uint32_t>( events.size() ) );
+    for (const auto& event : events) {
+        put( event.timeSec );
+        put( event.relMouseX );
+        put( event.relMouseY );
+        put( event.relMouse_dx );
+        put( event.relMouse_dy );
+        put( static_cast<uint8_t>( event.LMBpressed ) );
+    }
+}
+
+void ArcBall::TraceRecorder::recordViewMatrix( const linAlg::mat3x4_t& viewMatrix ) {
+    if (!mRecordViewMatrices) { return; }
+    put( static_cast<uint8_t>( eTraceRecord::VIEW_MATRIX ) );
+    put( static_cast<uint32_t>( sizeof( linAlg::mat3x4_t ) ) );
+    put( viewMatrix );
+}
+
+void ArcBall::TraceRecorder::recordMat3x4( const Controls& controls, const eTraceRecord type, const linAlg::mat3x4_t& mat ) {
+    beginRecord( controls, type, sizeof( linAlg::mat3x4_t ) );
+    put( mat );
+}
+
+void ArcBall::TraceRecorder::recordMat3( const Controls& controls, const eTraceRecord type, const linAlg::mat3_t& mat ) {
+    beginRecord( controls, type, sizeof( linAlg::mat3_t ) );
+    put( mat );
+}
+
+void ArcBall::TraceRecorder::recordVec3( const Controls& controls, const eTraceRecord type, const linAlg::vec3_t& vec ) {
+    beginRecord( controls, type, sizeof( linAlg::vec3_t ) );
+    put( vec );
+}
+
+void ArcBall::TraceRecorder::recordPivot( const Controls& controls, const eTraceRecord type, const linAlg::vec3_t& pivot, const float camTiltRadAngle, const float camDist ) {
+    beginRecord( controls, type, sizeof( linAlg::vec3_t ) + 2 * sizeof( float ) );
+    put( pivot );
+    put( camTiltRadAngle );
+    put( camDist );
+}
+
+void ArcBall::TraceRecorder::recordCalcViewWithoutArcMatFrameMatrices( const Controls& controls, const float camTiltRadAngle, const linAlg::vec3_t& camPanDelta, const float camDist ) {
+    beginRecord( controls, eTraceRecord::CALC_VIEW_WITHOUT_ARC_MAT_FRAME_MATRICES, 5 * sizeof( float ) );
+    put( camTiltRadAngle );
+    put( camPanDelta );
+    put( camDist );
+}
+
+void ArcBall::TraceRecorder::recordCalcArcMat( const Controls& controls, const float camTiltRadAngle, const float relMouseX, const float relMouseY, const float relMouse_dx, const float relMouse_dy, const bool LMBpressed ) {
+    beginRecord( controls, eTraceRecord::CALC_ARC_MAT, 5 * sizeof( float ) + sizeof( uint8_t ) );
+    put( camTiltRadAngle );
+    put( relMouseX );
+    put( relMouseY );
+    put( relMouse_dx );
+    put( relMouse_dy );
+    put( static_cast<uint8_t>( LMBpressed ) );
+}
+
+void ArcBall::TraceRecorder::recordSetViewMatrixAroundPivot( const Controls& controls, const linAlg::mat3x4_t& viewMatrix, const linAlg::vec3_t& pivotWS, const float camTiltRadAngle, const float camDist ) {
+    beginRecord( controls, eTraceRecord::SET_VIEW_MATRIX_AROUND_PIVOT, sizeof( linAlg::mat3x4_t ) + sizeof( linAlg::vec3_t ) + 2 * sizeof( float ) );
+    put( viewMatrix );
+    put( pivotWS );
+    put( camTiltRadAngle );
+    put( camDist );
+}
+
+void ArcBall::TraceRecorder::recordState( const Controls& controls, const Controls::State& state ) {
+    // as raw bytes - traces are only replayed with the build (and thereby the State layout) they were recorded with
+    beginRecord( controls, eTraceRecord::RESTORE_STATE, sizeof( Controls::State ) );
+    put( state );
+}
+
+void ArcBall::TraceRecorder::recordNoArgs( const Controls& controls, const eTraceRecord type ) {
+    beginRecord( controls, type, 0 );
+}
+
+
+ArcBall::TraceReplayer::TraceReplayer()
+    : mData( nullptr )
+    , mSize( 0 )
+    , mIsMapped( false ) {
+}
+
+ArcBall::TraceReplayer::~TraceReplayer() {
+    close();
+}
+
+eRetVal ArcBall::TraceReplayer::open( const char* filePath ) {
+    close();
+
+#if defined( ARCBALL_TRACE_MMAP )
+    const int fd = ::open( filePath, O_RDONLY );
+    if (fd < 0) { return eRetVal::ERROR; }
+    struct stat fileStat;
+    if (fstat( fd, &fileStat ) != 0 || fileStat.st_size <= 0) {
+        ::close( fd );
+        return eRetVal::ERROR;
+    }
+    void* mapped = mmap( nullptr, static_cast<size_t>( fileStat.st_size ), PROT_READ, MAP_PRIVATE, fd, 0 );
+    ::close( fd );
+    if (mapped == MAP_FAILED) { return eRetVal::ERROR; }
+    madvise( mapped, static_cast<size_t>( fileStat.st_size ), MADV_SEQUENTIAL );
+
+    mData = static_cast<const uint8_t*>( mapped );
+    mSize = static_cast<size_t>( fileStat.st_size );
+    mIsMapped = true;
+#else
+    FILE* file = fopen( filePath, "rb" );
+    if (file == nullptr) { return eRetVal::ERROR; }
+    fseek( file, 0, SEEK_END );
+    const long fileSize = ftell( file );
+    fseek( file, 0, SEEK_SET );
+    if (fileSize <= 0) {
+        fclose( file );
+        return eRetVal::ERROR;
+    }
+    mFileContents.resize( static_cast<size_t>( fileSize ) );
+    const bool readOk = (fread( mFileContents.data(), 1, mFileContents.size(), file ) == mFileContents.size());
+    fclose( file );
+    if (!readOk) {
+        mFileContents.clear();
+        return eRetVal::ERROR;
+    }
+    mData = mFileContents.data();
+    mSize = mFileContents.size();
+#endif
+
+    if (mSize < traceHeaderSize || memcmp( mData, traceMagic, sizeof( traceMagic ) ) != 0) {
+        close();
+        return eRetVal::ERROR;
+    }
+    uint32_t fileVersion;
+    memcpy( &fileVersion, mData + sizeof( traceMagic ), sizeof( fileVersion ) );
+    if (fileVersion != TraceRecorder::version) {
+        close();
+        return eRetVal::ERROR;
+    }
+
+    return eRetVal::OK;
+}
+
+void ArcBall::TraceReplayer::close() {
+#if defined( ARCBALL_TRACE_MMAP )
+    if (mIsMapped) {
+        munmap( const_cast<uint8_t*>( mData ), mSize );
+    }
+#endif
+    mFileContents.clear();
+    mData = nullptr;
+    mSize = 0;
+    mIsMapped = false;
+}
+
+eRetVal ArcBall::TraceReplayer::replay( Controls& controls, const bool checkViewMatrices, const float tolerance, TraceReplayStats& stats ) const {
+    stats = TraceReplayStats{ 0, 0, 0.0f, UINT64_MAX };
+    if (mData == nullptr) { return eRetVal::ERROR; }
+
+    Cursor cursor{ mData + traceHeaderSize, mData + mSize };
+    std::vector<Controls::MouseEvent> events;
+
+    while (cursor.p < cursor.end) {
+        uint8_t type;
+        uint32_t payloadSize;
+        if (!cursor.get( type ) || !cursor.get( payloadSize )) { return eRetVal::ERROR; }
+        if (static_cast<size_t>( cursor.end - cursor.p ) < payloadSize) { return eRetVal::ERROR; }
+
+        Cursor payload{ cursor.p, cursor.p + payloadSize };
+        cursor.p += payloadSize;
+
+        bool ok = true;
+        switch (static_cast<eTraceRecord>( type )) {
+        case eTraceRecord::CONFIG: {
+            uint8_t fullCircle, smooth, largeWorldMode;
+            float rotDampingFactor, panDampingFactor, mouseSensitivity, maxTraditionalRotDeg, deadZone, rebaseDist, settleThreshold, renormThreshold;
+            ok = payload.get( fullCircle ) && payload.get( smooth ) && payload.get( rotDampingFactor ) && payload.get( panDampingFactor )
+              && payload.get( mouseSensitivity ) && payload.get( maxTraditionalRotDeg ) && payload.get( deadZone )
+              && payload.get( rebaseDist ) && payload.get( largeWorldMode ) && payload.get( settleThreshold ) && payload.get( renormThreshold );
+            if (ok) {
+                controls.setInteractionMode( Controls::InteractionModeDesc{ .fullCircle = fullCircle != 0, .smooth = smooth != 0 } );
+                controls.setRotDampingFactor( rotDampingFactor );
+                controls.setPanDampingFactor( panDampingFactor );
+                controls.setMouseSensitivity( mouseSensitivity );
+                controls.setMaxTraditionalRotDeg( maxTraditionalRotDeg );
+                controls.setDeadZone( deadZone );
+                controls.setLargeWorldMode( largeWorldMode != 0, rebaseDist );
+                controls.setSettleThreshold( settleThreshold );
+                controls.setRenormThreshold( renormThreshold );
+            }
+            if (!ok) { return eRetVal::ERROR; }
+            continue; // not a call
+        }
+        case eTraceRecord::UPDATE: {
+            float deltaTimeSec, relMouseX, relMouseY, relMouse_dx, relMouse_dy, camDist, camTiltRadAngle;
+            linAlg::vec3_t camPanDelta;
+            bool LMBpressed;
+            ok = payload.get( deltaTimeSec ) && payload.get( relMouseX ) && payload.get( relMouseY ) && payload.get( relMouse_dx ) && payload.get( relMouse_dy )
+              && payload.get( camDist ) && payload.get( camPanDelta ) && payload.get( camTiltRadAngle ) && payload.get( LMBpressed );
+            if (ok) {
+                controls.update( deltaTimeSec, relMouseX, relMouseY, relMouse_dx, relMouse_dy, camDist, camPanDelta, camTiltRadAngle, LMBpressed );
+            }
+        } break;
+        case eTraceRecord::INGEST_EVENTS: {
+            float deltaTimeSec, camDist, camTiltRadAngle;
+            linAlg::vec3_t camPanDelta;
+            uint32_t numEvents;
+            ok = payload.get( deltaTimeSec ) && payload.get( camDist ) && payload.get( camPanDelta ) && payload.get( camTiltRadAngle ) && payload.get( numEvents );
+            // the count comes from the file - don't allocate more events than the payload can hold
+            ok = ok && uint64_t{ numEvents } * mouseEventSize <= payload.remaining();
+            events.resize( ok ? numEvents : 0 );
+            for (auto& event : events) {
+                ok = ok && payload.get( event.timeSec ) && payload.get( event.relMouseX ) && payload.get( event.relMouseY )
+                   && payload.get( event.relMouse_dx ) && payload.get( event.relMouse_dy ) && payload.get( event.LMBpressed );
+            }
+            if (ok) {
+                controls.ingestEvents( deltaTimeSec, events, camDist, camPanDelta, camTiltRadAngle );
+            }
+        } break;
+        case eTraceRecord::SET_VIEW_MATRIX: {
+            linAlg::mat3x4_t viewMatrix;
+            ok = payload.get( viewMatrix );
+            if (ok) { controls.setViewMatrix( viewMatrix ); }
+        } break;
+        case eTraceRecord::SET_VIEW_MATRIX_AROUND_PIVOT: {
+            linAlg::mat3x4_t viewMatrix;
+            linAlg::vec3_t pivotWS;
+            float camTiltRadAngle, camDist;
+            ok = payload.get( viewMatrix ) && payload.get( pivotWS ) && payload.get( camTiltRadAngle ) && payload.get( camDist );
+            if (ok) { controls.setViewMatrix( viewMatrix, pivotWS, camTiltRadAngle, camDist ); }
+        } break;
+        case eTraceRecord::RESTORE_STATE: {
+            Controls::State state;
+            ok = payloadSize == sizeof( state ) && payload.get( state );
+            if (ok) { ok = controls.restoreState( state ) == eRetVal::OK; }
+        } break;
+        case eTraceRecord::ADD_PAN_DELTA: {
+            linAlg::vec3_t delta;
+            ok = payload.get( delta );
+            if (ok) { controls.addPanDelta( delta ); }
+        } break;
+        case eTraceRecord::SET_REF_FRAME_MAT: {
+            linAlg::mat3_t refFrameMat;
+            ok = payload.get( refFrameMat );
+            if (ok) { controls.setRefFrameMat( refFrameMat ); }
+        } break;
+        case eTraceRecord::SET_ROTATION_PIVOT_WS: {
+            linAlg::vec3_t pivot;
+            ok = payload.get( pivot );
+            if (ok) { controls.setRotationPivotWS( pivot ); }
+        } break;
+        case eTraceRecord::SET_ROTATION_PIVOT_ARC_SPACE_WS: {
+            linAlg::vec3_t pivot;
+            ok = payload.get( pivot );
+            if (ok) { controls.setRotationPivotArcSpaceWS( pivot ); }
+        } break;
+        case eTraceRecord::SEAMLESS_SET_ROTATION_PIVOT_WS:
+        case eTraceRecord::SEAMLESS_SET_ROTATION_PIVOT_ARC_SPACE_WS:
+        case eTraceRecord::COMMON_SEAMLESS_SET_ROTATION_PIVOT_WS: {
+            linAlg::vec3_t pivot;
+            float camTiltRadAngle, camDist;
+            ok = payload.get( pivot ) && payload.get( camTiltRadAngle ) && payload.get( camDist );
+            if (!ok) { break; }
+            if (static_cast<eTraceRecord>( type ) == eTraceRecord::SEAMLESS_SET_ROTATION_PIVOT_WS) {
+                controls.seamlessSetRotationPivotWS( pivot, camTiltRadAngle, camDist );
+            } else if (static_cast<eTraceRecord>( type ) == eTraceRecord::SEAMLESS_SET_ROTATION_PIVOT_ARC_SPACE_WS) {
+                controls.seamlessSetRotationPivotArcSpaceWS( pivot, camTiltRadAngle, camDist );
+            } else {
+                controls.commonSeamlessSetRotationPivotWS( camTiltRadAngle, camDist );
+            }
+        } break;
+        case eTraceRecord::CALC_VIEW_WITHOUT_ARC_MAT_FRAME_MATRICES: {
+            float camTiltRadAngle, camDist;
+            linAlg::vec3_t camPanDelta;
+            ok = payload.get( camTiltRadAngle ) && payload.get( camPanDelta ) && payload.get( camDist );
+            if (ok) { controls.calcViewWithoutArcMatFrameMatrices( camTiltRadAngle, camPanDelta, camDist ); }
+        } break;
+        case eTraceRecord::CALC_ARC_MAT: {
+            float camTiltRadAngle, relMouseX, relMouseY, relMouse_dx, relMouse_dy;
+            bool LMBpressed;
+            ok = payload.get( camTiltRadAngle ) && payload.get( relMouseX ) && payload.get( relMouseY ) && payload.get( relMouse_dx ) && payload.get( relMouse_dy ) && payload.get( LMBpressed );
+            if (ok) { controls.calcArcMat( camTiltRadAngle, relMouseX, relMouseY, relMouse_dx, relMouse_dy, LMBpressed ); }
+        } break;
+        case eTraceRecord::RESET_TRAFOS: {
+            controls.resetTrafos();
+        } break;
+        case eTraceRecord::VIEW_MATRIX: {
+            linAlg::mat3x4_t recordedViewMatrix;
+            ok = payload.get( recordedViewMatrix );
+            if (ok && checkViewMatrices) {
+                const linAlg::mat3x4_t& viewMatrix = controls.getViewMatrix();
+                float maxError = 0.0f;
+                for (int r = 0; r < 3; r++) {
+                    for (int c = 0; c < 4; c++) {
+                        maxError = fmaxf( maxError, fabsf( viewMatrix[r][c] - recordedViewMatrix[r][c] ) );
+                    }
+                }
+                stats.numViewMatrixChecks++;
+                stats.maxViewMatrixError = fmaxf( stats.maxViewMatrixError, maxError );
+                if (maxError > tolerance && stats.firstMismatchCall == UINT64_MAX) {
+                    stats.firstMismatchCall = stats.numCalls - 1;
+                }
+            }
+            if (!ok) { return eRetVal::ERROR; }
+            continue; // not a call
+        }
+        default:
+            return eRetVal::ERROR;
+        }
+
+        if (!ok) { return eRetVal::ERROR; }
+        stats.numCalls++;
+    }
+
+    return (stats.firstMismatchCall == UINT64_MAX) ? eRetVal::OK : eRetVal::ERROR;
+}
@@ -0,0 +1,146 @@
+#ifndef _ARCBALLTRACE_H_4e9b17c3_d2a8_4f05_8b6e_a3c70f1d5e28
+#define _ARCBALLTRACE_H_4e9b17c3_d2a8_4f05_8b6e_a3c70f1d5e28
+
+// binary input traces of ArcBall::Controls sessions, for reproducing perf and stability ("float-wobble") reports
+//
+// a TraceRecorder attached with Controls::setTraceRecorder() appends every call into the Controls (update(), ingestEvents(),
+// the pivot setters, setViewMatrix(), ...) with its arguments; calls nested inside another call are not recorded,
+// settings (interaction mode, damping, dead zone, ...) are written whenever they changed since the last recorded call
+// optionally the resulting view matrix is stored after every update()/ingestEvents() as well
+//
+// a TraceReplayer memory-maps a trace and drives a fresh Controls with it as fast as it can, optionally checking every
+// produced getViewMatrix() against the recorded one
+//
+// file layout (native byte order - little endian on x86 and ARM -, floats as IEEE-754 binary32):
+//   header:  char magic[4] = "ABTR", uint32 version, uint32 flags
+//   records: uint8 type, uint32 payloadSize, payload
+
+#include "eRetVal_ArcBall.h"
+#include "arcBallControls.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <vector>
+
+namespace ArcBall {
+
+    enum class eTraceRecord : uint8_t {
+        CONFIG = 1,
+        UPDATE,
+        INGEST_EVENTS,
+        SET_VIEW_MATRIX,
+        ADD_PAN_DELTA,
+        SET_REF_FRAME_MAT,
+        SET_ROTATION_PIVOT_WS,
+        SET_ROTATION_PIVOT_ARC_SPACE_WS,
+        SEAMLESS_SET_ROTATION_PIVOT_WS,
+        SEAMLESS_SET_ROTATION_PIVOT_ARC_SPACE_WS,
+        COMMON_SEAMLESS_SET_ROTATION_PIVOT_WS,
+        CALC_VIEW_WITHOUT_ARC_MAT_FRAME_MATRICES,
+        CALC_ARC_MAT,
+        RESET_TRAFOS,
+        VIEW_MATRIX, // result of the preceding update() / ingestEvents()
+        SET_VIEW_MATRIX_AROUND_PIVOT,
+        RESTORE_STATE,
+    };
+
+    struct TraceRecorder {
+
+        static constexpr uint32_t version = 5;
+        static constexpr uint32_t flagViewMatrices = 1u << 0;
+
+        // RAII helper for the Controls side - only the outermost of nested calls gets a recorder to record into
+        struct CallScope {
+            explicit CallScope( TraceRecorder* recorder )
+                : mRecorder( recorder )
+                , mIsOutermost( recorder != nullptr && recorder->mCallDepth++ == 0 ) {}
+            ~CallScope() { if (mRecorder != nullptr) { mRecorder->mCallDepth--; } }
+            CallScope( const CallScope& ) = delete;
+            CallScope& operator=( const CallScope& ) = delete;
+
+            TraceRecorder* get() const { return mIsOutermost ? mRecorder : nullptr; }
+        private:
+            TraceRecorder* mRecorder;
+            bool mIsOutermost;
+        };
+
+        TraceRecorder();
+        ~TraceRecorder();
+
+        eRetVal open( const char* filePath, const bool recordViewMatrices );
+        eRetVal close(); // ERROR if anything written since open() didn't make it to the file
+        bool isOpen() const { return mFile != nullptr; }
+
+        // called by Controls
+        void recordUpdate( const Controls& controls, const float deltaTimeSec, const float relMouseX, const float relMouseY, const float relMouse_dx, const float relMouse_dy, const float camDist, const linAlg::vec3_t& camPanDelta, const float camTiltRadAngle, const bool LMBpressed );
+        void recordIngestEvents( const Controls& controls, const float deltaTimeSec, const std::span<const Controls::MouseEvent> events, const float camDist, const linAlg::vec3_t& camPanDelta, const float camTiltRadAngle );
+        void recordViewMatrix( const linAlg::mat3x4_t& viewMatrix );
+        void recordMat3x4( const Controls& controls, const eTraceRecord type, const linAlg::mat3x4_t& mat );
+        void recordMat3( const Controls& controls, const eTraceRecord type, const linAlg::mat3_t& mat );
+        void recordVec3( const Controls& controls, const eTraceRecord type, const linAlg::vec3_t& vec );
+        void recordPivot( const Controls& controls, const eTraceRecord type, const linAlg::vec3_t& pivot, const float camTiltRadAngle, const float camDist );
+        void recordCalcViewWithoutArcMatFrameMatrices( const Controls& controls, const float camTiltRadAngle, const linAlg::vec3_t& camPanDelta, const float camDist );
+        void recordCalcArcMat( const Controls& controls, const float camTiltRadAngle, const float relMouseX, const float relMouseY, const float relMouse_dx, const float relMouse_dy, const bool LMBpressed );
+        void recordSetViewMatrixAroundPivot( const Controls& controls, const linAlg::mat3x4_t& viewMatrix, const linAlg::vec3_t& pivotWS, const float camTiltRadAngle, const float camDist );
+        void recordState( const Controls& controls, const Controls::State& state );
+        void recordNoArgs( const Controls& controls, const eTraceRecord type );
+
+        bool recordsViewMatrices() const { return mRecordViewMatrices; }
+
+    private:
+        struct Config {
+            uint8_t fullCircle;
+            uint8_t smooth;
+            float rotDampingFactor;
+            float panDampingFactor;
+            float mouseSensitivity;
+            float maxTraditionalRotDeg;
+            float deadZone;
+            float rebaseDist;
+            uint8_t largeWorldMode;
+            float settleThreshold;
+            float renormThreshold;
+
+            bool operator==( const Config& ) const = default;
+        };
+
+        void beginRecord( const Controls& controls, const eTraceRecord type, const uint32_t payloadSize );
+        template<class T> void put( const T& value );
+        void flushIfFull();
+
+        FILE* mFile;
+        std::vector<uint8_t> mBuffer;
+        Config mLastConfig;
+        bool mHasConfig;
+        bool mRecordViewMatrices;
+        bool mWriteFailed; // a flush came up short since open()
+        int mCallDepth;
+    };
+
+    struct TraceReplayStats {
+        uint64_t numCalls;
+        uint64_t numViewMatrixChecks;
+        float    maxViewMatrixError;
+        uint64_t firstMismatchCall; // index of the first call whose view matrix was off by more than the tolerance, UINT64_MAX if none
+    };
+
+    struct TraceReplayer {
+        TraceReplayer();
+        ~TraceReplayer();
+
+        eRetVal open( const char* filePath );
+        void close();
+
+        // drives controls (should be freshly constructed) with all recorded calls
+        // returns ERROR on a malformed trace, or if checkViewMatrices is set and a view matrix was off by more than tolerance
+        eRetVal replay( Controls& controls, const bool checkViewMatrices, const float tolerance, TraceReplayStats& stats ) const;
+
+    private:
+        const uint8_t* mData;
+        size_t mSize;
+        bool mIsMapped;
+        std::vector<uint8_t> mFileContents; // where memory mapping isn't available
+    };
+}
+#endif // _ARCBALLTRACE_H_4e9b17c3_d2a8_4f05_8b6e_a3c70f1d5e28
@@ -0,0 +1,150 @@
+#include "arcBallViewHistory.h"
+#include "arcBallQuat.h"
+
+#include <math.h>
+#include <algorithm>
+
+using namespace ArcBall;
+
+namespace {
+    static constexpr float pi = 3.14159265358979f;
+    static constexpr uint32_t rotCompBits = 15;
+    static constexpr uint64_t rotCompMask = (uint64_t{ 1 } << rotCompBits) - 1;
+    static constexpr int rotCompShift = 20 - rotCompBits; // quatToSmallestThree() has 20 bit components
+
+    // block float: the values share the exponent of the largest, mantissas of mantissaBits bits (sign included)
+    template<class Int, size_t N>
+    static int8_t quantizeBlock( const std::array<double, N>& values, const int mantissaBits, std::array<Int, N>& mantissas ) {
+        double maxAbs = 0.0;
+        for (const double v : values) { maxAbs = fmax( maxAbs, fabs( v ) ); }
+        int exp;
+        frexp( maxAbs, &exp );
+        exp = std::clamp( exp, -100, 127 ); // below 2^-100 everything is 0 anyway
+        const double maxMantissa = ldexp( 1.0, mantissaBits - 1 ) - 1.0;
+        for (size_t i = 0; i < N; i++) {
+            mantissas[i] = static_cast<Int>( std::clamp( rint( ldexp( values[i], mantissaBits - 1 - exp ) ), -maxMantissa, maxMantissa ) );
+        }
+        return static_cast<int8_t>( exp );
+    }
+
+    template<class Int>
+    static double dequantizeBlock( const Int mantissa, const int mantissaBits, const int8_t exp ) {
+        return ldexp( static_cast<double>( mantissa ), exp - (mantissaBits - 1) );
+    }
+
+    static std::array<uint16_t, 3> packQuat( const linAlg::vec4_t& q ) {
+        std::array<int32_t, 3> comps;
+        uint64_t packed = uint64_t{ quatToSmallestThree( q, comps ) } << (3 * rotCompBits);
+        for (int i = 0; i < 3; i++) {
+            const int32_t comp = std::clamp( (comps[i] + (1 << (rotCompShift - 1))) >> rotCompShift, -(1 << (rotCompBits - 1)), (1 << (rotCompBits - 1)) - 1 );
+            packed |= (static_cast<uint64_t>( static_cast<uint32_t>( comp ) ) & rotCompMask) << (i * rotCompBits);
+        }
+        return std::array<uint16_t, 3>{ static_cast<uint16_t>( packed ), static_cast<uint16_t>( packed >> 16 ), static_cast<uint16_t>( packed >> 32 ) };
+    }
+
+    static linAlg::vec4_t unpackQuat( const std::array<uint16_t, 3>& rot ) {
+        const uint64_t packed = uint64_t{ rot[0] } | (uint64_t{ rot[1] } << 16) | (uint64_t{ rot[2] } << 32);
+        std::array<int32_t, 3> comps;
+        for (int i = 0; i < 3; i++) {
+            const uint32_t bits = static_cast<uint32_t>( (packed >> (i * rotCompBits)) & rotCompMask );
+            comps[i] = (static_cast<int32_t>( bits << (32 - rotCompBits) ) >> (32 - rotCompBits)) * (1 << rotCompShift); // sign extend, back to 20 bits
+        }
+        return quatFromSmallestThree( static_cast<uint8_t>( packed >> (3 * rotCompBits) ), comps );
+    }
+}
+
+ArcBall::ViewHistory::ViewHistory( const size_t capacity )
+    : mEntries( std::max( capacity, size_t{ 1 } ) )
+    , mFirstIdx( 0 )
+    , mNumEntries( 0 )
+    , mCurrentIdx( 0 ) {
+}
+
+void ArcBall::ViewHistory::clear() {
+    mFirstIdx = 0;
+    mNumEntries = 0;
+    mCurrentIdx = 0;
+}
+
+void ArcBall::ViewHistory::push( const Controls& controls ) {
+    const CameraKeyframe keyframe = CameraPath::captureKeyframe( 0.0, controls );
+
+    const std::array<double, 3>& originWS = controls.getOriginWS();
+
+    Entry entry;
+    entry.rot = packQuat( keyframe.arcQuat );
+    std::array<double, 3> pivotWS;
+    for (int i = 0; i < 3; i++) { pivotWS[i] = originWS[i] + static_cast<double>( keyframe.pivotWS[i] ); }
+    entry.pivotExp = quantizeBlock( pivotWS, 32, entry.pivotWS );
+    std::array<int16_t, 4> view;
+    entry.viewExp = quantizeBlock( std::array<double, 4>{ keyframe.panVector[0], keyframe.panVector[1], keyframe.panVector[2], keyframe.camDist }, 16, view );
+    entry.panVector = { view[0], view[1], view[2] };
+    entry.camDist = view[3];
+    entry.camTiltRadAngle = static_cast<int16_t>( lrintf( remainderf( keyframe.camTiltRadAngle, 2.0f * pi ) * (32767.0f / pi) ) );
+    entry.hasOrigin = (originWS[0] != 0.0 || originWS[1] != 0.0 || originWS[2] != 0.0) ? 1 : 0;
+
+    // drop the redo entries, then the oldest one if there is no room
+    mNumEntries = (mNumEntries == 0) ? 0 : mCurrentIdx + 1;
+    if (mNumEntries == mEntries.size()) {
+        mFirstIdx = (mFirstIdx + 1) % mEntries.size();
+        mNumEntries--;
+    }
+    mEntries[(mFirstIdx + mNumEntries) % mEntries.size()] = entry;
+    mCurrentIdx = mNumEntries;
+    mNumEntries++;
+}
+
+eRetVal ArcBall::ViewHistory::undo( Controls& controls ) {
+    if (!canUndo()) { return eRetVal::ERROR; }
+    mCurrentIdx--;
+    applyEntry( entryAt( mCurrentIdx ), controls );
+    return eRetVal::OK;
+}
+
+eRetVal ArcBall::ViewHistory::redo( Controls& controls ) {
+    if (!canRedo()) { return eRetVal::ERROR; }
+    mCurrentIdx++;
+    applyEntry( entryAt( mCurrentIdx ), controls );
+    return eRetVal::OK;
+}
+
+eRetVal ArcBall::ViewHistory::restore( const size_t idx, Controls& controls ) const {
+    if (idx >= mNumEntries) { return eRetVal::ERROR; }
+    applyEntry( entryAt( idx ), controls );
+    return eRetVal::OK;
+}
+
+CameraKeyframe ArcBall::ViewHistory::getKeyframe( const size_t idx ) const {
+    return decodeEntry( entryAt( idx ), getOriginWS( idx ) );
+}
+
+std::array<double, 3> ArcBall::ViewHistory::getOriginWS( const size_t idx ) const {
+    const Entry& entry = entryAt( idx );
+    return entry.hasOrigin ? decodePivot( entry ) : std::array<double, 3>{ 0.0, 0.0, 0.0 };
+}
+
+std::array<double, 3> ArcBall::ViewHistory::decodePivot( const Entry& entry ) {
+    std::array<double, 3> pivotWS;
+    for (int i = 0; i < 3; i++) { pivotWS[i] = dequantizeBlock( entry.pivotWS[i], 32, entry.pivotExp ); }
+    return pivotWS;
+}
+
+// pivot relative to originWS
+CameraKeyframe ArcBall::ViewHistory::decodeEntry( const Entry& entry, const std::array<double, 3>& originWS ) {
+    const std::array<double, 3> pivotWS = decodePivot( entry );
+    CameraKeyframe keyframe;
+    keyframe.timeSec = 0.0;
+    keyframe.arcQuat = unpackQuat( entry.rot );
+    for (int i = 0; i < 3; i++) {
+        keyframe.pivotWS[i] = static_cast<float>( pivotWS[i] - originWS[i] );
+        keyframe.panVector[i] = static_cast<float>( dequantizeBlock( entry.panVector[i], 16, entry.viewExp ) );
+    }
+    keyframe.camDist = static_cast<float>( dequantizeBlock( entry.camDist, 16, entry.viewExp ) );
+    keyframe.camTiltRadAngle = static_cast<float>( entry.camTiltRadAngle ) * (pi / 32767.0f);
+    return keyframe;
+}
+
+// in large-world mode controls may have rebased since - the view stays the same if the pivot moves along with the origin
+void ArcBall::ViewHistory::applyEntry( const Entry& entry, Controls& controls ) {
+    CameraPath::applyKeyframe( controls, decodeEntry( entry, controls.getOriginWS() ) );
+}
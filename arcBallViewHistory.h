@@ -0,0 +1,74 @@
+#ifndef _ARCBALLVIEWHISTORY_H_5c2e9a71_d40b_4f6e_8a13_b7f0c64e21d9
+#define _ARCBALLVIEWHISTORY_H_5c2e9a71_d40b_4f6e_8a13_b7f0c64e21d9
+
+// bounded undo / redo history and bookmarks of views
+//
+// entries hold the view of a Controls (a CameraKeyframe - arc rotation, pivot, pan, tilt, distance - plus the large-world origin)
+// in 32 bytes; the ring buffer is allocated once, pushing, stepping and restoring are O(1)
+//   rotation:        smallest three, 15 bit components (6 bytes)           ~5e-5 rad
+//   pivot:           origin + pivot as one block float, 32 bit mantissas   2^-31 of its largest coordinate (5e-3 at 1e7 units)
+//   pan and camDist: block float, 16 bit mantissas                         2^-16 of the largest of them, i.e. of the view distance
+//   tilt:            16 bit over +-pi                                      5e-5 rad
+// ~5e-5 rad is well below a pixel (about 1e-3 rad at 1080p and a 60 degree fov) - an undo has to land on the same picture, not on
+// the same bits; Controls::saveState() / restoreState() is the bit-exact alternative at sizeof( Controls::State )
+// restoring puts the Controls into the view the entry was taken from (CameraPath::applyKeyframe()), inertia and drags are not part of it
+
+#include "eRetVal_ArcBall.h"
+#include "arcBallControls.h"
+#include "arcBallCameraPath.h"
+
+#include <stdint.h>
+#include <stddef.h>
+#include <array>
+#include <vector>
+
+namespace ArcBall {
+
+    struct ViewHistory {
+        explicit ViewHistory( const size_t capacity );
+
+        // stores the current view of controls (tilt and distance of its last update()) right after the current entry and makes it the current one
+        // redo entries are dropped, and the oldest entry once the history is full
+        void push( const Controls& controls );
+
+        // step to the previous / next entry and put controls into its view; ERROR if there is none
+        eRetVal undo( Controls& controls );
+        eRetVal redo( Controls& controls );
+        bool canUndo() const { return mNumEntries > 0 && mCurrentIdx > 0; }
+        bool canRedo() const { return mCurrentIdx + 1 < mNumEntries; }
+
+        // bookmarks: entry idx (0 is the oldest) without changing the current entry; ERROR if idx is out of range
+        eRetVal restore( const size_t idx, Controls& controls ) const;
+        CameraKeyframe getKeyframe( const size_t idx ) const; // relative to getOriginWS( idx ), timeSec is 0
+        std::array<double, 3> getOriginWS( const size_t idx ) const; // {0,0,0} unless the Controls had moved its origin (large-world mode)
+
+        void clear();
+        size_t size() const { return mNumEntries; }
+        size_t getCapacity() const { return mEntries.size(); }
+        size_t getCurrentIdx() const { return mCurrentIdx; } // meaningless while empty
+
+    private:
+        struct Entry {
+            std::array<int32_t, 3> pivotWS;   // origin + pivot, * 2^(pivotExp - 31)
+            std::array<int16_t, 3> panVector; // * 2^(viewExp - 15)
+            int16_t camDist;                  // * 2^(viewExp - 15)
+            std::array<uint16_t, 3> rot;      // smallest three: index of the dropped component in bits 45..46, three 15 bit components below
+            int16_t camTiltRadAngle;          // * pi / 32767
+            int8_t pivotExp;
+            int8_t viewExp;
+            uint8_t hasOrigin;                // 0: the origin was {0,0,0}, getOriginWS() stays that way
+        };
+        static_assert( sizeof( Entry ) == 32 );
+
+        const Entry& entryAt( const size_t idx ) const { return mEntries[(mFirstIdx + idx) % mEntries.size()]; }
+        static std::array<double, 3> decodePivot( const Entry& entry );
+        static CameraKeyframe decodeEntry( const Entry& entry, const std::array<double, 3>& originWS );
+        static void applyEntry( const Entry& entry, Controls& controls );
+
+        std::vector<Entry> mEntries;
+        size_t mFirstIdx; // ring buffer slot of entry 0
+        size_t mNumEntries;
+        size_t mCurrentIdx;
+    };
+}
+#endif // _ARCBALLVIEWHISTORY_H_5c2e9a71_d40b_4f6e_8a13_b7f0c64e21d9
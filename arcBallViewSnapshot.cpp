@@ -0,0 +1,56 @@
+#include "arcBallViewSnapshot.h"
+
+#include <string.h>
+
+using namespace ArcBall;
+
+ArcBall::ViewSnapshotChannel::ViewSnapshotChannel()
+    : mLatestSlot( 0 )
+    , mNextSequence( 1 ) {
+
+    for (auto& slot : mSlots) {
+        slot.seqLock.store( 0, std::memory_order_relaxed );
+        memset( &slot.snapshot, 0, sizeof( slot.snapshot ) );
+    }
+}
+
+void ArcBall::ViewSnapshotChannel::publish( const Controls& controls ) {
+    // fetch everything first, the lazily expanded matrices must not be evaluated while the slot is marked busy
+    const linAlg::mat3x4_t& viewMat = controls.getViewMatrix();
+    const linAlg::mat3x4_t& viewRotMat = controls.getViewRotMat();
+    const linAlg::mat3x4_t& arcRotMat = controls.getArcRotMat();
+    const linAlg::vec3_t pivotArcSpaceWS = controls.getRotationPivotOffsetArcSpaceWS();
+    const std::array<double, 3>& originWS = controls.getOriginWS();
+
+    const uint32_t slotIdx = (mLatestSlot.load( std::memory_order_relaxed ) + 1) % numSlots;
+    Slot& slot = mSlots[slotIdx];
+    const uint64_t sequence = mNextSequence++;
+
+    slot.seqLock.store( 2 * sequence - 1, std::memory_order_relaxed ); // odd => busy
+    std::atomic_thread_fence( std::memory_order_release );
+
+    slot.snapshot.viewMat = viewMat;
+    slot.snapshot.viewRotMat = viewRotMat;
+    slot.snapshot.arcRotMat = arcRotMat;
+    slot.snapshot.rotationPivotPosArcSpaceWS = pivotArcSpaceWS;
+    slot.snapshot.originWS = originWS;
+    slot.snapshot.sequence = sequence;
+
+    slot.seqLock.store( 2 * sequence, std::memory_order_release );
+    mLatestSlot.store( slotIdx, std::memory_order_release );
+}
+
+bool ArcBall::ViewSnapshotChannel::read( ViewSnapshot& snapshot ) const {
+    for (;;) {
+        const Slot& slot = mSlots[mLatestSlot.load( std::memory_order_acquire )];
+
+        const uint64_t seqBefore = slot.seqLock.load( std::memory_order_acquire );
+        if (seqBefore == 0) { return false; }
+        if (seqBefore & 1u) { continue; } // writer lapped us and is refilling this slot - the next latest slot is complete
+
+        memcpy( &snapshot, &slot.snapshot, sizeof( snapshot ) );
+
+        std::atomic_thread_fence( std::memory_order_acquire );
+        if (slot.seqLock.load( std::memory_order_relaxed ) == seqBefore) { return true; }
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef _ARCBALLVIEWSNAPSHOT_H_0f5d8a2e_93b4_4c61_a7e0_2d1c6b84f39a
+#define _ARCBALLVIEWSNAPSHOT_H_0f5d8a2e_93b4_4c61_a7e0_2d1c6b84f39a
+
+// hands the matrices of one ArcBall::Controls from the input thread to any number of render threads without locks
+//
+// the input thread (the only writer) calls publish() after each update - or lets Controls::update() do it via setSnapshotChannel()
+// render threads call read() whenever they need a view, they get a consistent copy of the most recently published state
+// neither side ever waits on a lock: publish() writes into the slot that was published longest ago, 
+// read() copies the latest slot and only retries if the writer lapped all slots while the copy was in flight
+
+#include "arcBallControls.h"
+
+#include <stdint.h>
+#include <atomic>
+
+namespace ArcBall {
+
+    struct ViewSnapshot {
+        linAlg::mat3x4_t viewMat;
+        linAlg::mat3x4_t viewRotMat;
+        linAlg::mat3x4_t arcRotMat;
+        linAlg::vec3_t   rotationPivotPosArcSpaceWS;
+        std::array<double, 3> originWS; // the matrices map (posWS - originWS), see Controls::setLargeWorldMode()
+        uint64_t         sequence; // increases by one with every publish(), 0 means nothing has been published yet
+    };
+
+    struct ViewSnapshotChannel {
+        ViewSnapshotChannel();
+
+        // writer side - one thread only
+        void publish( const Controls& controls );
+
+        // reader side - any number of threads; returns false if nothing has been published yet
+        bool read( ViewSnapshot& snapshot ) const;
+
+        uint64_t getLatestSequence() const { return mSlots[mLatestSlot.load( std::memory_order_acquire )].seqLock.load( std::memory_order_acquire ) / 2u; }
+
+    private:
+        static constexpr uint32_t numSlots = 3;
+
+        struct alignas(64) Slot {
+            std::atomic<uint64_t> seqLock; // odd while the writer is busy with the slot, otherwise 2 * snapshot.sequence
+            ViewSnapshot snapshot;
+        };
+
+        Slot mSlots[numSlots];
+        std::atomic<uint32_t> mLatestSlot;
+        uint64_t mNextSequence; // only touched by the writer
+    };
+}
+#endif // _ARCBALLVIEWSNAPSHOT_H_0f5d8a2e_93b4_4c61_a7e0_2d1c6b84f39a
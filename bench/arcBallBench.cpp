@@ -0,0 +1,158 @@
+#include "arcBallBench.h"
+#include "arcBallMath.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+using namespace ArcBallBench;
+
+namespace {
+    using benchClock = std::chrono::steady_clock;
+
+    static const char* simdName() {
+    #if defined( ARCBALL_MATH_AVX2 )
+        return "AVX2";
+    #elif defined( ARCBALL_MATH_SSE4 )
+        return "SSE4";
+    #else
+        return "scalar";
+    #endif
+    }
+
+    static bool isInstrumented() {
+    #if defined( ARCBALL_INSTRUMENTATION )
+        return true;
+    #else
+        return false;
+    #endif
+    }
+
+    static void putJsonString( FILE* f, const std::string& s ) {
+        fputc( '"', f );
+        for (const char c : s) {
+            if (c == '"' || c == '\\') { fputc( '\\', f ); }
+            fputc( c, f );
+        }
+        fputc( '"', f );
+    }
+
+    static void writeJson( FILE* f, const Suite& suite ) {
+        fprintf( f, "{\n  \"benchmark\": \"arcBallBench\",\n  \"version\": 1,\n" );
+        fprintf( f, "  \"build\": { \"simd\": \"%s\", \"instrumentation\": %s },\n", simdName(), isInstrumented() ? "true" : "false" );
+        fprintf( f, "  \"results\": [" );
+        const std::vector<Result>& results = suite.getResults();
+        for (size_t i = 0; i < results.size(); i++) {
+            const Result& r = results[i];
+            fprintf( f, "%s\n    { \"name\": ", (i > 0) ? "," : "" );
+            putJsonString( f, r.name );
+            fprintf( f, ", \"unit\": " );
+            putJsonString( f, r.unit );
+            fprintf( f, ", \"ns_per_op\": %.6g, \"ns_per_op_variance\": %.6g, \"ns_per_op_stddev\": %.6g, \"ns_per_op_min\": %.6g, \"ops_per_sec\": %.6g, \"samples\": %u, \"ops_per_sample\": %llu }",
+                     r.nsPerOp, r.nsPerOpVariance, sqrt( r.nsPerOpVariance ), r.nsPerOpMin, r.opsPerSec, r.numSamples, static_cast<unsigned long long>( r.opsPerSample ) );
+        }
+        fprintf( f, "\n  ],\n  \"metrics\": [" );
+        const std::vector<Metric>& metrics = suite.getMetrics();
+        for (size_t i = 0; i < metrics.size(); i++) {
+            fprintf( f, "%s\n    { \"name\": ", (i > 0) ? "," : "" );
+            putJsonString( f, metrics[i].name );
+            fprintf( f, ", \"unit\": " );
+            putJsonString( f, metrics[i].unit );
+            fprintf( f, ", \"value\": %.6g }", metrics[i].value );
+        }
+        fprintf( f, "\n  ]\n}\n" );
+    }
+
+    static void printUsage() {
+        printf( "usage: arcBallBench [--filter <substring>] [--samples <n>] [--min-sample-ms <ms>] [--quick] [--json <file or ->]\n" );
+    }
+}
+
+void ArcBallBench::Suite::run( const std::string& name, const std::string& unit, const uint64_t opsPerCall, const std::function<void()>& fn ) {
+    if (!isSelected( name )) { return; }
+
+    // warm up, then double the calls per sample until a sample takes long enough
+    fn();
+    uint64_t numCalls = 1;
+    for (;;) {
+        const auto t0 = benchClock::now();
+        for (uint64_t i = 0; i < numCalls; i++) { fn(); }
+        const double ms = std::chrono::duration<double, std::milli>( benchClock::now() - t0 ).count();
+        if (ms >= mOptions.minSampleMs || numCalls >= (uint64_t{ 1 } << 40)) { break; }
+        numCalls = (ms > 0.0) ? std::max( numCalls * 2, static_cast<uint64_t>( static_cast<double>( numCalls ) * mOptions.minSampleMs / ms ) ) : numCalls * 2;
+    }
+
+    const uint32_t numSamples = std::max( mOptions.numSamples, 1u );
+    std::vector<double> samples( numSamples );
+    for (double& sample : samples) {
+        const auto t0 = benchClock::now();
+        for (uint64_t i = 0; i < numCalls; i++) { fn(); }
+        sample = std::chrono::duration<double, std::nano>( benchClock::now() - t0 ).count() / static_cast<double>( numCalls * opsPerCall );
+    }
+
+    Result result;
+    result.name = name;
+    result.unit = unit;
+    result.opsPerSample = numCalls * opsPerCall;
+    result.numSamples = numSamples;
+    double sum = 0.0;
+    for (const double sample : samples) { sum += sample; }
+    result.nsPerOp = sum / numSamples;
+    double sumSq = 0.0;
+    for (const double sample : samples) { sumSq += (sample - result.nsPerOp) * (sample - result.nsPerOp); }
+    result.nsPerOpVariance = (numSamples > 1) ? sumSq / (numSamples - 1) : 0.0;
+    result.nsPerOpMin = *std::min_element( samples.begin(), samples.end() );
+    result.opsPerSec = (result.nsPerOp > 0.0) ? 1.0e9 / result.nsPerOp : 0.0;
+
+    fprintf( mOptions.tableOut, "%-52s %12.2f ns/%-6s %14.4g %s/s  +-%6.2f%%  (min %.2f)\n", name.c_str(), result.nsPerOp, unit.c_str(), result.opsPerSec, unit.c_str(),
+             (result.nsPerOp > 0.0) ? 100.0 * sqrt( result.nsPerOpVariance ) / result.nsPerOp : 0.0, result.nsPerOpMin );
+    fflush( mOptions.tableOut );
+    mResults.push_back( result );
+}
+
+void ArcBallBench::Suite::addMetric( const std::string& name, const std::string& unit, const double value ) {
+    if (!isSelected( name )) { return; }
+    fprintf( mOptions.tableOut, "%-52s %12.6g %s\n", name.c_str(), value, unit.c_str() );
+    fflush( mOptions.tableOut );
+    mMetrics.push_back( Metric{ name, unit, value } );
+}
+
+int main( int argc, char** argv ) {
+    Suite::Options options;
+    const char* jsonPath = nullptr;
+    for (int i = 1; i < argc; i++) {
+        const bool hasValue = i + 1 < argc;
+        if (strcmp( argv[i], "--filter" ) == 0 && hasValue) { options.filter = argv[++i]; }
+        else if (strcmp( argv[i], "--samples" ) == 0 && hasValue) { options.numSamples = static_cast<uint32_t>( atoi( argv[++i] ) ); }
+        else if (strcmp( argv[i], "--min-sample-ms" ) == 0 && hasValue) { options.minSampleMs = atof( argv[++i] ); }
+        else if (strcmp( argv[i], "--quick" ) == 0) { options.quick = true; }
+        else if (strcmp( argv[i], "--json" ) == 0 && hasValue) { jsonPath = argv[++i]; }
+        else { printUsage(); return (strcmp( argv[i], "--help" ) == 0) ? 0 : 1; }
+    }
+
+    // with the JSON going to stdout, the table goes to stderr
+    const bool jsonToStdout = jsonPath != nullptr && strcmp( jsonPath, "-" ) == 0;
+    if (jsonToStdout) { options.tableOut = stderr; }
+
+    fprintf( options.tableOut, "arcBallBench - simd: %s, instrumentation: %s\n", simdName(), isInstrumented() ? "on" : "off" );
+
+    Suite suite( options );
+    addControlsBenches( suite );
+    addBatchBenches( suite );
+    addStatsBenches( suite );
+    addBasicControlsBenches( suite );
+    addPickingBenches( suite );
+    addTransformBenches( suite );
+    addStreamBenches( suite );
+    addRenormBenches( suite );
+
+    if (jsonPath != nullptr) {
+        FILE* f = jsonToStdout ? stdout : fopen( jsonPath, "w" );
+        if (f == nullptr) { fprintf( stderr, "can't write %s\n", jsonPath ); return 1; }
+        writeJson( f, suite );
+        if (!jsonToStdout) { fclose( f ); }
+    }
+    return 0;
+}
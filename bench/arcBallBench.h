@@ -0,0 +1,112 @@
+#ifndef _ARCBALLBENCH_H_3f0a8c51_9e27_4b6d_a4c3_71d25e08bf96
+#define _ARCBALLBENCH_H_3f0a8c51_9e27_4b6d_a4c3_71d25e08bf96
+
+// tiny headless benchmark harness for the arc ball hot paths (arcBallBench executable)
+//
+// every case is a function doing opsPerCall operations; the harness calls it often enough to fill a sample of minSampleMs,
+// takes numSamples such samples and reports ns/op (mean, variance and min over the samples) and ops/s, as a table and optionally as JSON
+// numbers that aren't timings (bytes per packet, correction rates, ...) go in as metrics
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <array>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace ArcBallBench {
+
+    // keeps the compiler from dropping computations whose results are never used
+    template<class T>
+    inline void doNotOptimize( const T& value ) {
+    #if defined( __GNUC__ )
+        asm volatile( "" : : "r,m"( value ) : "memory" );
+    #else
+        static volatile const void* sink;
+        sink = &value;
+    #endif
+    }
+
+    struct Result {
+        std::string name;
+        std::string unit;        // what one op is - "op", "event", "point", ...
+        uint64_t opsPerSample;
+        uint32_t numSamples;
+        double   nsPerOp;         // mean over the samples
+        double   nsPerOpVariance; // sample variance over the samples, ns^2
+        double   nsPerOpMin;
+        double   opsPerSec;       // 1e9 / nsPerOp
+    };
+
+    struct Metric {
+        std::string name;
+        std::string unit;
+        double      value;
+    };
+
+    struct Suite {
+        struct Options {
+            uint32_t    numSamples = 10;
+            double      minSampleMs = 20.0;
+            bool        quick = false; // smaller problem sizes, for smoke testing
+            std::string filter;        // only cases whose name contains it
+            FILE*       tableOut = stdout; // where the human readable results go
+        };
+
+        explicit Suite( const Options& options ) : mOptions( options ) {}
+
+        bool isSelected( const std::string& name ) const { return mOptions.filter.empty() || name.find( mOptions.filter ) != std::string::npos; }
+        bool isQuick() const { return mOptions.quick; }
+
+        // fn does opsPerCall ops of unit each time it is called; skipped if not selected
+        void run( const std::string& name, const std::string& unit, const uint64_t opsPerCall, const std::function<void()>& fn );
+        void run( const std::string& name, const uint64_t opsPerCall, const std::function<void()>& fn ) { run( name, "op", opsPerCall, fn ); }
+        void addMetric( const std::string& name, const std::string& unit, const double value );
+
+        const std::vector<Result>& getResults() const { return mResults; }
+        const std::vector<Metric>& getMetrics() const { return mMetrics; }
+
+    private:
+        Options mOptions;
+        std::vector<Result> mResults;
+        std::vector<Metric> mMetrics;
+    };
+
+    // same pseudo random numbers on every run
+    struct Lcg {
+        uint32_t state = 12345u;
+        float next() { state = state * 1664525u + 1013904223u; return static_cast<float>( state >> 8 ) * (1.0f / 16777216.0f); } // [0, 1)
+    };
+
+    // mouse input of one update(), relative screen coordinates
+    struct MouseInput {
+        float relMouseX, relMouseY, relMouse_dx, relMouse_dy;
+    };
+
+    inline constexpr int numMouseInputs = 256; // per call of a case, cycled through
+
+    inline std::array<MouseInput, numMouseInputs> makeMouseInputs() {
+        Lcg lcg;
+        std::array<MouseInput, numMouseInputs> inputs;
+        for (MouseInput& input : inputs) {
+            input.relMouseX = 0.2f + 0.6f * lcg.next();
+            input.relMouseY = 0.2f + 0.6f * lcg.next();
+            input.relMouse_dx = 0.02f * (lcg.next() - 0.5f);
+            input.relMouse_dy = 0.02f * (lcg.next() - 0.5f);
+        }
+        return inputs;
+    }
+
+    // the cases, one function per module
+    void addControlsBenches( Suite& suite );
+    void addBatchBenches( Suite& suite );
+    void addStatsBenches( Suite& suite );
+    void addBasicControlsBenches( Suite& suite );
+    void addPickingBenches( Suite& suite );
+    void addTransformBenches( Suite& suite );
+    void addStreamBenches( Suite& suite );
+    void addRenormBenches( Suite& suite );
+}
+#endif // _ARCBALLBENCH_H_3f0a8c51_9e27_4b6d_a4c3_71d25e08bf96
@@ -0,0 +1,47 @@
+#include "arcBallBench.h"
+#include "arcBallBasicControls.h"
+
+#include <array>
+
+using namespace ArcBallBench;
+using namespace ArcBall;
+
+namespace {
+    // the drags of controls/update/*, through BasicControls<Mode, float> and through Controls set to the same mode
+    template<class Mode>
+    static void benchUpdate( Suite& suite, const std::string& modeName ) {
+        const std::array<MouseInput, numMouseInputs> inputs = makeMouseInputs();
+        {
+            BasicControls<Mode, float> controls;
+            int frame = 0;
+            suite.run( "basic/BasicControls::update/" + modeName, numMouseInputs, [&]() {
+                for (const MouseInput& input : inputs) {
+                    const bool LMBpressed = (frame++ & 64) == 0;
+                    controls.update( 1.0f / 60.0f, input.relMouseX, input.relMouseY, input.relMouse_dx, input.relMouse_dy, 5.0f, linAlg::vec3_t{ 0.0f, 0.0f, 0.0f }, 0.1f, LMBpressed );
+                }
+                doNotOptimize( controls.getViewMatrix() );
+            } );
+            suite.addMetric( "basic/sizeof/BasicControls/" + modeName, "bytes", static_cast<double>( sizeof( controls ) ) );
+        }
+        {
+            Controls controls;
+            controls.setInteractionMode( Mode::desc );
+            int frame = 0;
+            suite.run( "basic/Controls::update/" + modeName, numMouseInputs, [&]() {
+                for (const MouseInput& input : inputs) {
+                    const bool LMBpressed = (frame++ & 64) == 0;
+                    controls.update( 1.0f / 60.0f, input.relMouseX, input.relMouseY, input.relMouse_dx, input.relMouse_dy, 5.0f, linAlg::vec3_t{ 0.0f, 0.0f, 0.0f }, 0.1f, LMBpressed );
+                }
+                doNotOptimize( controls.getViewMatrix() );
+            } );
+        }
+    }
+}
+
+void ArcBallBench::addBasicControlsBenches( Suite& suite ) {
+    benchUpdate<FullCircleMode>( suite, "fullCircle" );
+    benchUpdate<FullCircleSmoothMode>( suite, "fullCircle+smooth" );
+    benchUpdate<TraditionalMode>( suite, "traditional" );
+    benchUpdate<TraditionalSmoothMode>( suite, "traditional+smooth" );
+    suite.addMetric( "basic/sizeof/Controls", "bytes", static_cast<double>( sizeof( Controls ) ) );
+}
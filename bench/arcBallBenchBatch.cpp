@@ -0,0 +1,60 @@
+#include "arcBallBench.h"
+#include "arcBallControlsBatch.h"
+
+#include <math.h>
+#include <vector>
+
+using namespace ArcBallBench;
+using namespace ArcBall;
+
+namespace {
+    // per-controller input of one frame, every controller dragging a bit differently
+    struct BatchInput {
+        std::vector<float> dx, dy, camDist, panX, panY, tilt;
+        std::vector<uint8_t> LMBpressed;
+
+        explicit BatchInput( const size_t n ) : dx( n ), dy( n ), camDist( n ), panX( n ), panY( n ), tilt( n ), LMBpressed( n ) {
+            for (size_t i = 0; i < n; i++) {
+                const float f = static_cast<float>( i );
+                dx[i] = 0.003f * sinf( 0.37f * f );
+                dy[i] = 0.002f * cosf( 0.21f * f );
+                camDist[i] = 3.0f + 0.01f * f;
+                panX[i] = 1.0e-4f;
+                panY[i] = -1.0e-4f;
+                tilt[i] = 0.1f;
+                LMBpressed[i] = 1;
+            }
+        }
+    };
+}
+
+void ArcBallBench::addBatchBenches( Suite& suite ) {
+    for (const size_t n : { size_t{ 1 }, size_t{ 64 }, size_t{ 4096 }, size_t{ 65536 } }) {
+        if (suite.isQuick() && n > 4096) { continue; }
+        const BatchInput in( n );
+        std::vector<linAlg::mat3x4_t> viewMatrices( n );
+
+        // per controller: the batch ...
+        {
+            ControlsBatch batch( n );
+            const ControlsBatch::Input input{ in.dx.data(), in.dy.data(), in.camDist.data(), in.panX.data(), in.panY.data(), in.tilt.data(), in.LMBpressed.data() };
+            suite.run( "batch/ControlsBatch::update/N=" + std::to_string( n ), "ctrl", n, [&]() {
+                batch.update( input, viewMatrices.data() );
+                doNotOptimize( viewMatrices[n - 1] );
+            } );
+        }
+
+        // ... against one Controls::update() per controller, same mode and input
+        {
+            std::vector<Controls> controls( n );
+            for (Controls& c : controls) { c.setInteractionMode( Controls::InteractionModeDesc{ .fullCircle = true, .smooth = false } ); }
+            suite.run( "batch/Controls::update/N=" + std::to_string( n ), "ctrl", n, [&]() {
+                for (size_t i = 0; i < n; i++) {
+                    controls[i].update( 1.0f / 60.0f, 0.5f, 0.5f, in.dx[i], in.dy[i], in.camDist[i], linAlg::vec3_t{ in.panX[i], in.panY[i], 0.0f }, in.tilt[i], true );
+                    viewMatrices[i] = controls[i].getViewMatrix();
+                }
+                doNotOptimize( viewMatrices[n - 1] );
+            } );
+        }
+    }
+}
@@ -0,0 +1,113 @@
+#include "arcBallBench.h"
+#include "arcBallControls.h"
+
+#include <array>
+#include <vector>
+
+using namespace ArcBallBench;
+using namespace ArcBall;
+
+namespace {
+    static void benchCalcArcMat( Suite& suite, const std::string& name, const Controls::InteractionModeDesc modeDesc ) {
+        const std::array<MouseInput, numMouseInputs> inputs = makeMouseInputs();
+        Controls controls;
+        controls.setInteractionMode( modeDesc );
+        controls.calcArcMat( 0.1f, 0.5f, 0.5f, 0.0f, 0.0f, true );
+        suite.run( name, numMouseInputs, [&]() {
+            for (const MouseInput& input : inputs) {
+                controls.calcArcMat( 0.1f, input.relMouseX, input.relMouseY, input.relMouse_dx, input.relMouse_dy, true );
+            }
+            doNotOptimize( controls.getArcRotMat() );
+        } );
+    }
+
+    static void benchUpdate( Suite& suite, const std::string& name, const Controls::InteractionModeDesc modeDesc ) {
+        const std::array<MouseInput, numMouseInputs> inputs = makeMouseInputs();
+        Controls controls;
+        controls.setInteractionMode( modeDesc );
+        int frame = 0;
+        suite.run( name, numMouseInputs, [&]() {
+            for (const MouseInput& input : inputs) {
+                // drags of 64 frames with a release in between, so smooth mode coasts some of the time
+                const bool LMBpressed = (frame++ & 64) == 0;
+                controls.update( 1.0f / 60.0f, input.relMouseX, input.relMouseY, input.relMouse_dx, input.relMouse_dy, 5.0f, linAlg::vec3_t{ 0.0f, 0.0f, 0.0f }, 0.1f, LMBpressed );
+            }
+            doNotOptimize( controls.getViewMatrix() );
+        } );
+    }
+
+    // one frame at 60 Hz worth of events from a mouse polled at pollingRateHz, the button going up and down every 64 frames
+    static void benchIngestEvents( Suite& suite, const std::string& name, const int pollingRateHz ) {
+        const std::array<MouseInput, numMouseInputs> inputs = makeMouseInputs();
+        const int numEventsPerFrame = pollingRateHz / 60;
+        std::vector<Controls::MouseEvent> events( numEventsPerFrame );
+        Controls controls;
+        controls.setInteractionMode( Controls::InteractionModeDesc{ .fullCircle = true, .smooth = true } );
+        int frame = 0;
+        int inputIdx = 0;
+        double timeSec = 0.0;
+        suite.run( name, "event", numEventsPerFrame, [&]() {
+            const bool LMBpressed = (frame++ & 64) == 0;
+            for (Controls::MouseEvent& event : events) {
+                const MouseInput& input = inputs[inputIdx++ % numMouseInputs];
+                timeSec += 1.0 / pollingRateHz;
+                event = Controls::MouseEvent{ timeSec, input.relMouseX, input.relMouseY, input.relMouse_dx * 0.1f, input.relMouse_dy * 0.1f, LMBpressed };
+            }
+            controls.ingestEvents( 1.0f / 60.0f, events, 5.0f, linAlg::vec3_t{ 0.0f, 0.0f, 0.0f }, 0.1f );
+            doNotOptimize( controls.getViewMatrix() );
+        } );
+    }
+}
+
+void ArcBallBench::addControlsBenches( Suite& suite ) {
+    {
+        const std::array<MouseInput, numMouseInputs> inputs = makeMouseInputs();
+        suite.run( "controls/mapScreenPosToArcBallPosNDC", numMouseInputs, [&]() {
+            for (const MouseInput& input : inputs) {
+                linAlg::vec3_t mouseNDC;
+                Controls::mapScreenPosToArcBallPosNDC( mouseNDC, linAlg::vec2_t{ input.relMouseX, input.relMouseY } );
+                doNotOptimize( mouseNDC );
+            }
+        } );
+    }
+
+    benchCalcArcMat( suite, "controls/calcArcMat/fullCircle", Controls::InteractionModeDesc{ .fullCircle = true, .smooth = false } );
+    benchCalcArcMat( suite, "controls/calcArcMat/traditional", Controls::InteractionModeDesc{ .fullCircle = false, .smooth = false } );
+
+    {
+        Controls controls;
+        linAlg::vec3_t panDelta{ 0.0f, 0.0f, 0.0f };
+        suite.run( "controls/calcViewWithoutArcMatFrameMatrices", numMouseInputs, [&]() {
+            for (int i = 0; i < numMouseInputs; i++) {
+                // changing pan, tilt and distance so the cached view inputs never match
+                panDelta[0] = (i & 1) ? 1.0e-3f : -1.0e-3f;
+                controls.calcViewWithoutArcMatFrameMatrices( 0.1f + 1.0e-4f * static_cast<float>( i ), panDelta, 5.0f + 1.0e-3f * static_cast<float>( i ) );
+            }
+            doNotOptimize( controls.getViewMatrix() );
+        } );
+    }
+
+    benchUpdate( suite, "controls/update/fullCircle", Controls::InteractionModeDesc{ .fullCircle = true, .smooth = false } );
+    benchUpdate( suite, "controls/update/traditional", Controls::InteractionModeDesc{ .fullCircle = false, .smooth = false } );
+    benchUpdate( suite, "controls/update/fullCircle+smooth", Controls::InteractionModeDesc{ .fullCircle = true, .smooth = true } );
+
+    benchIngestEvents( suite, "controls/ingestEvents/1000Hz", 1000 );
+    benchIngestEvents( suite, "controls/ingestEvents/8000Hz", 8000 );
+
+    {
+        // pivots far enough apart to never be skipped as unchanged
+        std::array<linAlg::vec3_t, numMouseInputs> pivots;
+        Lcg lcg;
+        for (linAlg::vec3_t& pivot : pivots) { pivot = linAlg::vec3_t{ lcg.next() - 0.5f, lcg.next() - 0.5f, lcg.next() - 0.5f }; }
+
+        Controls controls;
+        controls.update( 1.0f / 60.0f, 0.5f, 0.5f, 0.01f, 0.005f, 5.0f, linAlg::vec3_t{ 0.0f, 0.0f, 0.0f }, 0.1f, true );
+        suite.run( "controls/seamlessSetRotationPivotWS", numMouseInputs, [&]() {
+            for (const linAlg::vec3_t& pivot : pivots) { controls.seamlessSetRotationPivotWS( pivot, 0.1f, 5.0f ); }
+            doNotOptimize( controls.getViewMatrix() );
+        } );
+        suite.run( "controls/getRotationPivotOffsetWS", numMouseInputs, [&]() {
+            for (int i = 0; i < numMouseInputs; i++) { doNotOptimize( controls.getRotationPivotOffsetWS() ); }
+        } );
+    }
+}
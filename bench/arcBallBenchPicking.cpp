@@ -0,0 +1,82 @@
+#include "arcBallBench.h"
+#include "arcBallPicking.h"
+
+#include <math.h>
+#include <array>
+#include <vector>
+
+using namespace ArcBallBench;
+using namespace ArcBall;
+
+namespace {
+    // rolling terrain of gridSize x gridSize quads over [-10, 10] in x and z, two triangles each
+    struct TerrainMesh {
+        std::vector<float>    positions;
+        std::vector<uint32_t> indices;
+
+        explicit TerrainMesh( const uint32_t gridSize ) {
+            const float spacing = 20.0f / static_cast<float>( gridSize );
+            positions.reserve( 3 * size_t{ gridSize + 1 } * (gridSize + 1) );
+            for (uint32_t z = 0; z <= gridSize; z++) {
+                for (uint32_t x = 0; x <= gridSize; x++) {
+                    const float fx = static_cast<float>( x ) * spacing - 10.0f;
+                    const float fz = static_cast<float>( z ) * spacing - 10.0f;
+                    positions.insert( positions.end(), { fx, 0.5f * sinf( fx * 1.3f ) * cosf( fz * 0.7f ) + 0.05f * sinf( fx * 17.0f ) * sinf( fz * 23.0f ), fz } );
+                }
+            }
+            indices.reserve( 6 * size_t{ gridSize } * gridSize );
+            for (uint32_t z = 0; z < gridSize; z++) {
+                for (uint32_t x = 0; x < gridSize; x++) {
+                    const uint32_t a = z * (gridSize + 1) + x;
+                    const uint32_t c = a + gridSize + 1;
+                    indices.insert( indices.end(), { a, c, a + 1, a + 1, c, c + 1 } );
+                }
+            }
+        }
+
+        size_t getNumVertices() const { return positions.size() / 3; }
+        size_t getNumTriangles() const { return indices.size() / 3; }
+    };
+}
+
+void ArcBallBench::addPickingBenches( Suite& suite ) {
+    // camera 15 units out, dragged to look down onto the terrain at an angle
+    Controls controls;
+    for (int i = 0; i < 20; i++) {
+        controls.update( 1.0f / 60.0f, 0.5f, 0.5f, 0.0f, 0.02f, -15.0f, linAlg::vec3_t{ 0.0f, 0.0f, 0.0f }, 0.0f, true );
+    }
+    const PickProjection projection{ .fovYRadAngle = 1.0f, .aspectRatio = 16.0f / 9.0f };
+    const std::array<MouseInput, numMouseInputs> inputs = makeMouseInputs();
+
+    // 2237 x 2237 quads is the 10M triangles of a large scan / terrain tile - a few seconds per build and about 1 GB while it runs
+    const std::vector<uint32_t> gridSizes = suite.isQuick() ? std::vector<uint32_t>{ 32 } : std::vector<uint32_t>{ 128, 512, 2237 };
+    for (const uint32_t gridSize : gridSizes) {
+        const TerrainMesh mesh( gridSize );
+        const std::string sizeName = "/tris=" + std::to_string( mesh.getNumTriangles() );
+
+        // single-threaded, so the number doesn't depend on the machine's core count
+        suite.run( "picking/PickingBVH::build" + sizeName, "triangle", mesh.getNumTriangles(), [&]() {
+            PickingBVH bvh;
+            bvh.build( mesh.positions.data(), mesh.getNumVertices(), mesh.indices.data(), mesh.getNumTriangles(), 1 );
+            doNotOptimize( bvh.getNumNodes() );
+        } );
+
+        PickingBVH bvh;
+        bvh.build( mesh.positions.data(), mesh.getNumVertices(), mesh.indices.data(), mesh.getNumTriangles(), 1 );
+        suite.run( "picking/PickingBVH::pick" + sizeName, "pick", numMouseInputs, [&]() {
+            for (const MouseInput& input : inputs) {
+                PickHit hit;
+                doNotOptimize( bvh.pick( controls, linAlg::vec2_t{ input.relMouseX, input.relMouseY }, projection, hit ) );
+            }
+        } );
+
+        // misses are cheaper than hits, so this says what the pick timing is made of
+        size_t numHits = 0;
+        for (const MouseInput& input : inputs) {
+            PickHit hit;
+            numHits += bvh.pick( controls, linAlg::vec2_t{ input.relMouseX, input.relMouseY }, projection, hit ) ? 1 : 0;
+        }
+        suite.addMetric( "picking/hitRate" + sizeName, "fraction", static_cast<double>( numHits ) / numMouseInputs );
+        suite.addMetric( "picking/numNodes" + sizeName, "nodes", static_cast<double>( bvh.getNumNodes() ) );
+    }
+}
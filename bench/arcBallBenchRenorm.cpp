@@ -0,0 +1,75 @@
+#include "arcBallBench.h"
+#include "arcBallControls.h"
+#include "arcBallQuat.h"
+
+#include <math.h>
+#include <array>
+#include <limits>
+
+using namespace ArcBallBench;
+using namespace ArcBall;
+
+namespace {
+    static constexpr int numChainSteps = 4096; // per call, from the identity on
+    static constexpr float renormThreshold = std::numeric_limits<float>::epsilon() * 4.0f; // Controls' default
+}
+
+// accumulating one small rotation after the other, as the arc rotation does while dragging / coasting:
+// a full normalization after every composition against the thresholded Newton step of Controls (renormalizeQuat()),
+// and against no correction at all for the cost of the composition itself
+void ArcBallBench::addRenormBenches( Suite& suite ) {
+    const linAlg::vec4_t deltaQuat = quatFromAxisAngle( linAlg::vec3_t{ 0.48f, 0.6f, 0.64f }, 0.013f );
+
+    suite.run( "renorm/compositionOnly", "composition", numChainSteps, [&]() {
+        linAlg::vec4_t quat = identityQuat;
+        for (int i = 0; i < numChainSteps; i++) { quat = quatMul( deltaQuat, quat ); }
+        doNotOptimize( quat );
+    } );
+    suite.run( "renorm/normalizeEveryStep", "composition", numChainSteps, [&]() {
+        linAlg::vec4_t quat = identityQuat;
+        for (int i = 0; i < numChainSteps; i++) {
+            quat = quatMul( deltaQuat, quat );
+            linAlg::normalize( quat );
+        }
+        doNotOptimize( quat );
+    } );
+    suite.run( "renorm/renormalizeQuat", "composition", numChainSteps, [&]() {
+        linAlg::vec4_t quat = identityQuat;
+        for (int i = 0; i < numChainSteps; i++) {
+            quat = quatMul( deltaQuat, quat );
+            renormalizeQuat( quat, renormThreshold );
+        }
+        doNotOptimize( quat );
+    } );
+
+    // how often the Newton step kicks in and how far |q| gets off in between, over a long chain ...
+    {
+        const int numSteps = suite.isQuick() ? 100000 : 10000000;
+        linAlg::vec4_t quat = identityQuat;
+        int numCorrections = 0;
+        float maxNormError = 0.0f;
+        for (int i = 0; i < numSteps; i++) {
+            quat = quatMul( deltaQuat, quat );
+            const float absNormError = renormalizeQuat( quat, renormThreshold );
+            maxNormError = fmaxf( maxNormError, absNormError );
+            numCorrections += (absNormError > renormThreshold) ? 1 : 0;
+        }
+        suite.addMetric( "renorm/chain/correctionRate", "fraction", static_cast<double>( numCorrections ) / numSteps );
+        suite.addMetric( "renorm/chain/maxNormError", "|1-|q|^2|", maxNormError );
+    }
+
+    // ... and in Controls over drags of varying direction, from its NumericHealth
+    {
+        const std::array<MouseInput, numMouseInputs> inputs = makeMouseInputs();
+        const int numFrames = suite.isQuick() ? 10000 : 1000000;
+        Controls controls;
+        controls.setInteractionMode( Controls::InteractionModeDesc{ .fullCircle = true, .smooth = true } );
+        for (int frame = 0; frame < numFrames; frame++) {
+            const MouseInput& input = inputs[frame % numMouseInputs];
+            controls.update( 1.0f / 60.0f, input.relMouseX, input.relMouseY, input.relMouse_dx, input.relMouse_dy, 5.0f, linAlg::vec3_t{ 0.0f, 0.0f, 0.0f }, 0.1f, (frame & 64) == 0 );
+        }
+        const Controls::NumericHealth& health = controls.getNumericHealth();
+        suite.addMetric( "renorm/Controls/correctionRate", "fraction", static_cast<double>( health.numCorrections ) / static_cast<double>( health.numCompositions ) );
+        suite.addMetric( "renorm/Controls/maxNormError", "|1-|q|^2|", health.maxArcQuatNormError );
+    }
+}
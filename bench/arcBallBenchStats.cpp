@@ -0,0 +1,29 @@
+#include "arcBallBench.h"
+#include "arcBallControls.h"
+#include "arcBallStats.h"
+
+using namespace ArcBallBench;
+using namespace ArcBall;
+
+// the overhead of the instrumentation on the hot paths is the difference between the controls/* cases of arcBallBench and
+// arcBallBench_instrumented (the same sources, built with -DARCBALL_INSTRUMENTATION); these are the costs of its own
+void ArcBallBench::addStatsBenches( Suite& suite ) {
+    Controls controls;
+    for (int i = 0; i < 1000; i++) {
+        controls.update( 1.0f / 60.0f, 0.5f, 0.5f, 0.01f, 0.005f, 5.0f, linAlg::vec3_t{ 0.0f, 0.0f, 0.0f }, 0.1f, (i & 64) == 0 );
+    }
+
+    suite.run( "stats/Controls::getStats", 1, [&]() { doNotOptimize( controls.getStats() ); } );
+    suite.run( "stats/getGlobalStats", 1, [&]() { doNotOptimize( getGlobalStats() ); } );
+
+#if defined( ARCBALL_INSTRUMENTATION )
+    // what every instrumented branch / timed call adds
+    stats::InstanceStats instanceStats;
+    suite.run( "stats/count", 256, [&]() {
+        for (int i = 0; i < 256; i++) { ARCBALL_STAT_COUNT( instanceStats, ARC_ROTATIONS ); }
+    } );
+    suite.run( "stats/scopedTimer", 256, [&]() {
+        for (int i = 0; i < 256; i++) { ARCBALL_STAT_TIME( instanceStats, UPDATE ); }
+    } );
+#endif
+}
@@ -0,0 +1,93 @@
+#include "arcBallBench.h"
+#include "arcBallStateStream.h"
+
+#include <vector>
+
+using namespace ArcBallBench;
+using namespace ArcBall;
+
+namespace {
+    static constexpr int numPhaseFrames = 300;
+    static constexpr int numSessionFrames = 6 * numPhaseFrames;
+
+    // a presenter session of numSessionFrames frames at 60 Hz, 300 frames each of: dragging, coasting, panning, tilting,
+    // zooming and sitting still; a new pivot every 1000 frames - one copy of the presenter per frame
+    static std::vector<Controls> recordSession() {
+        Lcg lcg;
+        Controls presenter;
+        presenter.setLargeWorldMode( true, 8.0f );
+        std::vector<Controls> frames;
+        frames.reserve( numSessionFrames );
+        float relMouseX = 0.5f, relMouseY = 0.5f, camTiltRadAngle = 0.0f, camDist = 15.0f;
+        for (int frame = 0; frame < numSessionFrames; frame++) {
+            const int phase = frame / numPhaseFrames;
+            float dx = 0.0f, dy = 0.0f;
+            linAlg::vec3_t panDelta{ 0.0f, 0.0f, 0.0f };
+            if (phase == 0) {
+                dx = (lcg.next() - 0.3f) * 0.01f;
+                dy = (lcg.next() - 0.5f) * 0.01f;
+                relMouseX = (relMouseX + dx < 0.0f || relMouseX + dx > 1.0f) ? 0.5f : relMouseX + dx;
+                relMouseY = (relMouseY + dy < 0.0f || relMouseY + dy > 1.0f) ? 0.5f : relMouseY + dy;
+            }
+            if (phase == 2) { panDelta = linAlg::vec3_t{ (lcg.next() - 0.5f) * 0.05f, (lcg.next() - 0.5f) * 0.05f, 0.0f }; }
+            if (phase == 3) { camTiltRadAngle += 0.002f; }
+            if (phase == 4) { camDist += (lcg.next() - 0.5f) * 0.1f; }
+            if (frame % 1000 == 999) {
+                presenter.seamlessSetRotationPivotWS( linAlg::vec3_t{ lcg.next() * 20.0f - 10.0f, lcg.next() * 20.0f - 10.0f, lcg.next() * 20.0f - 10.0f }, camTiltRadAngle, camDist );
+            }
+            presenter.update( 1.0f / 60.0f, relMouseX, relMouseY, dx, dy, camDist, panDelta, camTiltRadAngle, phase == 0 );
+            frames.push_back( presenter );
+        }
+        return frames;
+    }
+}
+
+// the per-frame costs on both ends of a StateStreamEncoder / StateStreamDecoder with the default settings, and what goes over the wire
+void ArcBallBench::addStreamBenches( Suite& suite ) {
+    const std::vector<Controls> frames = recordSession();
+
+    std::vector<std::vector<uint8_t>> packets( frames.size() );
+    {
+        StateStreamEncoder encoder;
+        for (size_t i = 0; i < frames.size(); i++) { encoder.encode( frames[i], packets[i] ); }
+    }
+
+    {
+        StateStreamEncoder encoder;
+        std::vector<uint8_t> packet;
+        suite.run( "stream/StateStreamEncoder::encode", "packet", frames.size(), [&]() {
+            for (const Controls& frame : frames) { encoder.encode( frame, packet ); }
+            doNotOptimize( packet.data() );
+        } );
+    }
+    // a new decoder for every pass, the first packet is a keyframe
+    suite.run( "stream/StateStreamDecoder::decode", "packet", packets.size(), [&]() {
+        StateStreamDecoder decoder;
+        for (const std::vector<uint8_t>& packet : packets) { decoder.decode( packet ); }
+        doNotOptimize( decoder.getKeyframe() );
+    } );
+    {
+        Controls follower;
+        suite.run( "stream/StateStreamDecoder::decode+apply", "packet", packets.size(), [&]() {
+            StateStreamDecoder decoder;
+            for (const std::vector<uint8_t>& packet : packets) {
+                decoder.decode( packet );
+                decoder.apply( follower );
+            }
+            doNotOptimize( follower.getViewMatrix() );
+        } );
+    }
+
+    size_t numBytes = 0, numKeyframeBytes = 0, numKeyframes = 0;
+    for (const std::vector<uint8_t>& packet : packets) {
+        numBytes += packet.size();
+        if (packet[0] & static_cast<uint8_t>( eStateStreamFlag::KEYFRAME )) {
+            numKeyframeBytes += packet.size();
+            numKeyframes++;
+        }
+    }
+    suite.addMetric( "stream/bytesPerPacket", "bytes", static_cast<double>( numBytes ) / packets.size() );
+    suite.addMetric( "stream/bytesPerKeyframe", "bytes", static_cast<double>( numKeyframeBytes ) / numKeyframes );
+    suite.addMetric( "stream/bytesPerDelta", "bytes", static_cast<double>( numBytes - numKeyframeBytes ) / (packets.size() - numKeyframes) );
+    suite.addMetric( "stream/bytesPerSecAt60Hz", "bytes/s", static_cast<double>( numBytes ) / packets.size() * 60.0 );
+}
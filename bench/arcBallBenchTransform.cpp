@@ -0,0 +1,77 @@
+#include "arcBallBench.h"
+#include "arcBallControls.h"
+#include "arcBallMath.h"
+#include "arcBallParallel.h"
+
+#include <span>
+#include <vector>
+
+using namespace ArcBallBench;
+using namespace ArcBall;
+
+namespace {
+    // vertex with the position inside, as overlays tend to have it
+    struct Vertex {
+        linAlg::vec3_t pos;
+        float u, v, pad;
+    };
+
+    // the baseline: one transformPoint() per point
+    static void transformPointsLoop( const linAlg::mat3x4_t& m, const linAlg::vec3_t* in, linAlg::vec3_t* out, const size_t numPoints ) {
+        const linAlg::mat3x4_t mCopy = m; // can't alias out
+        for (size_t i = 0; i < numPoints; i++) { out[i] = transformPoint( mCopy, in[i] ); }
+    }
+}
+
+// Controls::transformPoints() WS -> ES on one thread, each layout against the plain per-point loop over the same matrix
+void ArcBallBench::addTransformBenches( Suite& suite ) {
+    Controls controls;
+    controls.update( 1.0f / 60.0f, 0.5f, 0.5f, 0.01f, 0.005f, 5.0f, linAlg::vec3_t{ 0.0f, 0.0f, 0.0f }, 0.1f, true );
+    controls.update( 1.0f / 60.0f, 0.5f, 0.5f, 0.01f, 0.005f, 5.0f, linAlg::vec3_t{ 0.0f, 0.0f, 0.0f }, 0.1f, true );
+    const linAlg::mat3x4_t m = controls.getCoordSpaceTransform( eCoordSpace::WS, eCoordSpace::ES );
+
+    const std::vector<size_t> sizes = suite.isQuick() ? std::vector<size_t>{ 1024 } : std::vector<size_t>{ 1024, 65536, size_t{ 1 } << 20 };
+    for (const size_t n : sizes) {
+        const std::string sizeName = "/N=" + std::to_string( n );
+
+        Lcg lcg;
+        std::vector<linAlg::vec3_t> points( n );
+        std::vector<Vertex> vertices( n );
+        std::vector<float> x( n ), y( n ), z( n );
+        for (size_t i = 0; i < n; i++) {
+            points[i] = linAlg::vec3_t{ lcg.next() - 0.5f, lcg.next() - 0.5f, lcg.next() - 0.5f };
+            vertices[i] = Vertex{ points[i], 0.0f, 0.0f, 0.0f };
+            x[i] = points[i][0];
+            y[i] = points[i][1];
+            z[i] = points[i][2];
+        }
+        std::vector<linAlg::vec3_t> outPoints( n );
+        std::vector<Vertex> outVertices( vertices );
+        std::vector<float> outX( n ), outY( n ), outZ( n );
+
+        suite.run( "transform/scalarLoop" + sizeName, "point", n, [&]() {
+            transformPointsLoop( m, points.data(), outPoints.data(), n );
+            doNotOptimize( outPoints[n - 1] );
+        } );
+        suite.run( "transform/Controls::transformPoints/vec3" + sizeName, "point", n, [&]() {
+            controls.transformPoints( eCoordSpace::WS, eCoordSpace::ES, std::span<const linAlg::vec3_t>( points ), std::span<linAlg::vec3_t>( outPoints ), 1 );
+            doNotOptimize( outPoints[n - 1] );
+        } );
+        suite.run( "transform/Controls::transformPoints/stride24" + sizeName, "point", n, [&]() {
+            controls.transformPoints( eCoordSpace::WS, eCoordSpace::ES, vertices[0].pos.data(), sizeof( Vertex ), outVertices[0].pos.data(), sizeof( Vertex ), n, 1 );
+            doNotOptimize( outVertices[n - 1] );
+        } );
+        suite.run( "transform/Controls::transformPoints/SoA" + sizeName, "point", n, [&]() {
+            controls.transformPoints( eCoordSpace::WS, eCoordSpace::ES, std::span<const float>( x ), std::span<const float>( y ), std::span<const float>( z ),
+                                      std::span<float>( outX ), std::span<float>( outY ), std::span<float>( outZ ), 1 );
+            doNotOptimize( outZ[n - 1] );
+        } );
+    }
+
+    // what a thread of parallelForRanges() costs - the overhead the minimum chunk sizes of its callers are weighed against
+    for (const uint32_t numThreads : { 2u, 4u }) {
+        suite.run( "transform/parallelForRanges/threads=" + std::to_string( numThreads ), "call", 1, [&]() {
+            parallelForRanges( numThreads, numThreads, 1, []( const size_t start, const size_t count ) { doNotOptimize( start + count ); } );
+        } );
+    }
+}
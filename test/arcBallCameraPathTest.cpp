@@ -0,0 +1,109 @@
+// CameraPath keyframes against the Controls they were captured from: the path evaluated at a keyframe's time has to give that
+// Controls' getViewMatrix(), and loading the keyframe into a live Controls has to be seamless - the next update() without input
+// keeps the view, and drags from there on rotate like they would have in the captured Controls
+
+#include "arcBallTest.h"
+#include "arcBallCameraPath.h"
+
+#include <math.h>
+#include <vector>
+
+using namespace ArcBall;
+using namespace ArcBallTest;
+
+namespace {
+    // float rounding through quatFromRotMat() and back, on translations of up to ~20 units
+    static constexpr float tolerance = 2.0e-5f;
+
+    struct Capture {
+        Controls controls;
+        float camDist;
+        float camTiltRadAngle;
+    };
+
+    // a Controls dragged, panned, tilted and zoomed, with pivot changes; a copy of it every 50 frames
+    static std::vector<Capture> recordCaptures( const Controls::InteractionModeDesc modeDesc ) {
+        Lcg lcg;
+        Controls controls;
+        controls.setInteractionMode( modeDesc );
+        std::vector<Capture> captures;
+        float camDist = -12.0f, camTiltRadAngle = 0.0f;
+        for (int frame = 0; frame < 1000; frame++) {
+            const bool LMBpressed = (frame % 200) < 120;
+            const float dx = LMBpressed ? (lcg.next() - 0.4f) * 0.02f : 0.0f;
+            const float dy = LMBpressed ? (lcg.next() - 0.5f) * 0.02f : 0.0f;
+            const linAlg::vec3_t panDelta = (frame % 200 >= 150) ? linAlg::vec3_t{ (lcg.next() - 0.5f) * 0.05f, (lcg.next() - 0.5f) * 0.05f, 0.0f } : linAlg::vec3_t{ 0.0f, 0.0f, 0.0f };
+            camTiltRadAngle += 0.001f;
+            camDist += (lcg.next() - 0.5f) * 0.05f;
+            if (frame % 300 == 299) {
+                controls.seamlessSetRotationPivotWS( linAlg::vec3_t{ lcg.next() * 10.0f - 5.0f, lcg.next() * 10.0f - 5.0f, lcg.next() * 10.0f - 5.0f }, camTiltRadAngle, camDist );
+            }
+            controls.update( 1.0f / 60.0f, 0.3f + 0.4f * lcg.next(), 0.3f + 0.4f * lcg.next(), dx, dy, camDist, panDelta, camTiltRadAngle, LMBpressed );
+            if (frame % 50 == 49) { captures.push_back( Capture{ controls, camDist, camTiltRadAngle } ); }
+        }
+        return captures;
+    }
+
+    static void testKeyframes( const Controls::InteractionModeDesc modeDesc, const size_t modeIdx ) {
+        const std::vector<Capture> captures = recordCaptures( modeDesc );
+        CameraPath path;
+        for (size_t k = 0; k < captures.size(); k++) {
+            check( path.addKeyframe( CameraPath::captureKeyframe( 0.5 * static_cast<double>( k ), captures[k].controls ) ) == eRetVal::OK, "CameraPath::addKeyframe", k );
+        }
+
+        float maxError = 0.0f;
+        for (size_t k = 0; k < captures.size(); k++) {
+            const Capture& capture = captures[k];
+            const size_t idx = modeIdx * 1000 + k;
+
+            // the path runs through the captured views
+            linAlg::mat3x4_t viewMatrix;
+            check( path.evaluate( 0.5 * static_cast<double>( k ), viewMatrix ) == eRetVal::OK, "CameraPath::evaluate", idx );
+            float error = maxAbsDiff( viewMatrix, capture.controls.getViewMatrix() );
+            maxError = fmaxf( maxError, error );
+            check( error <= tolerance, "path at keyframe time vs captured view", idx );
+
+            // loaded into a Controls that was somewhere else entirely ...
+            CameraKeyframe keyframe;
+            check( path.evaluateKeyframe( 0.5 * static_cast<double>( k ), keyframe ) == eRetVal::OK, "CameraPath::evaluateKeyframe", idx );
+            Controls live;
+            live.setInteractionMode( modeDesc );
+            live.update( 1.0f / 60.0f, 0.5f, 0.5f, 0.1f, -0.05f, -3.0f, linAlg::vec3_t{ 1.0f, 2.0f, 0.0f }, 0.7f, true );
+            live.update( 1.0f / 60.0f, 0.5f, 0.5f, 0.0f, 0.0f, -3.0f, linAlg::vec3_t{ 0.0f, 0.0f, 0.0f }, 0.7f, false );
+            CameraPath::applyKeyframe( live, keyframe );
+            error = maxAbsDiff( live.getViewMatrix(), capture.controls.getViewMatrix() );
+            maxError = fmaxf( maxError, error );
+            check( error <= tolerance, "view right after applyKeyframe()", idx );
+
+            // ... the next update() without input keeps the view ...
+            live.update( 1.0f / 60.0f, 0.5f, 0.5f, 0.0f, 0.0f, capture.camDist, linAlg::vec3_t{ 0.0f, 0.0f, 0.0f }, capture.camTiltRadAngle, false );
+            error = maxAbsDiff( live.getViewMatrix(), capture.controls.getViewMatrix() );
+            maxError = fmaxf( maxError, error );
+            check( error <= tolerance, "view after the first update() following applyKeyframe()", idx );
+
+            // ... and a new drag from there rotates around the same pivot as in the captured Controls (without its inertia, and with
+            // the captured Controls' own drag - if the keyframe was taken mid-drag - released first)
+            if (!modeDesc.smooth) {
+                Controls captured = capture.controls;
+                for (int frame = 0; frame < 21; frame++) {
+                    for (Controls* c : { &captured, &live }) {
+                        const bool LMBpressed = frame > 0; // a release only counts with the mouse at rest
+                        c->update( 1.0f / 60.0f, 0.5f, 0.5f, LMBpressed ? 0.004f : 0.0f, LMBpressed ? -0.002f : 0.0f, capture.camDist, linAlg::vec3_t{ 0.0f, 0.0f, 0.0f }, capture.camTiltRadAngle, LMBpressed );
+                    }
+                }
+                error = maxAbsDiff( live.getViewMatrix(), captured.getViewMatrix() );
+                maxError = fmaxf( maxError, error );
+                check( error <= 10.0f * tolerance, "dragging after applyKeyframe() vs dragging the captured Controls", idx );
+            }
+        }
+        printf( "mode %zu: max view matrix error %g\n", modeIdx, maxError );
+    }
+}
+
+int main() {
+    testKeyframes( Controls::InteractionModeDesc{ .fullCircle = true, .smooth = true }, 0 );
+    testKeyframes( Controls::InteractionModeDesc{ .fullCircle = true, .smooth = false }, 1 );
+    testKeyframes( Controls::InteractionModeDesc{ .fullCircle = false, .smooth = true }, 2 );
+    testKeyframes( Controls::InteractionModeDesc{ .fullCircle = false, .smooth = false }, 3 );
+    return report( "arcBallCameraPath" );
+}
@@ -0,0 +1,89 @@
+// ControlsBatch against one Controls per controller, set to the batch's fullCircle non-smooth mode and fed the same input:
+// the view matrices have to stay within float tolerance of each other over a long session, on the wide lanes and on the scalar tail
+// plus the unsupported modes, which have to make update() fail
+
+#include "arcBallTest.h"
+#include "arcBallControlsBatch.h"
+
+#include <math.h>
+#include <vector>
+
+using namespace ArcBall;
+using namespace ArcBallTest;
+
+namespace {
+    static constexpr size_t numControls = 37; // a few full AVX / SSE blocks and a tail
+    static constexpr int numFrames = 2000;
+
+    // both run the same math in a different order, the difference is float rounding piling up over the frames -
+    // around 2e-3 after 2000 frames of 3 to 4 units camera distance
+    static constexpr float tolerance = 1.0e-2f;
+
+    static void testAgainstControls() {
+        Lcg lcg;
+        const Controls::InteractionModeDesc modeDesc{ .fullCircle = true, .smooth = false };
+        ControlsBatch batch( numControls );
+        std::vector<Controls> controls( numControls );
+        for (size_t i = 0; i < numControls; i++) {
+            controls[i].setInteractionMode( modeDesc );
+            const linAlg::vec3_t pivot{ lcg.next() - 0.5f, lcg.next() - 0.5f, lcg.next() - 0.5f };
+            controls[i].setRotationPivotArcSpaceWS( pivot );
+            batch.setRotationPivotArcSpaceWS( i, pivot );
+        }
+
+        std::vector<float> dx( numControls ), dy( numControls ), camDist( numControls ), panX( numControls ), panY( numControls ), tilt( numControls );
+        std::vector<uint8_t> LMBpressed( numControls );
+        const ControlsBatch::Input input{ dx.data(), dy.data(), camDist.data(), panX.data(), panY.data(), tilt.data(), LMBpressed.data() };
+        std::vector<linAlg::mat3x4_t> viewMatrices( numControls );
+
+        float maxDiff = 0.0f;
+        for (int frame = 0; frame < numFrames; frame++) {
+            for (size_t i = 0; i < numControls; i++) {
+                dx[i] = (lcg.next() - 0.45f) * 0.01f;
+                dy[i] = (lcg.next() - 0.5f) * 0.01f;
+                camDist[i] = 3.0f + static_cast<float>( i ) / numControls;
+                panX[i] = (lcg.next() - 0.5f) * 1.0e-3f;
+                panY[i] = (lcg.next() - 0.5f) * 1.0e-3f;
+                tilt[i] = 0.1f + 0.0001f * static_cast<float>( frame );
+                LMBpressed[i] = ((frame + static_cast<int>( i ) * 7) % 200 < 150) ? 1 : 0; // drags of varying phase, with releases
+            }
+            check( batch.update( input, viewMatrices.data() ) == eRetVal::OK, "ControlsBatch::update", static_cast<size_t>( frame ) );
+            for (size_t i = 0; i < numControls; i++) {
+                controls[i].update( 1.0f / 60.0f, 0.5f, 0.5f, dx[i], dy[i], camDist[i], linAlg::vec3_t{ panX[i], panY[i], 0.0f }, tilt[i], LMBpressed[i] != 0 );
+                const float diff = maxAbsDiff( viewMatrices[i], controls[i].getViewMatrix() );
+                maxDiff = fmaxf( maxDiff, diff );
+                check( diff <= tolerance, "batch view matrix vs Controls", static_cast<size_t>( frame ) * numControls + i );
+            }
+        }
+        printf( "max view matrix difference over %d frames: %g\n", numFrames, maxDiff );
+    }
+
+    static void testUnsupportedModes() {
+        const Controls::InteractionModeDesc unsupported[] = {
+            { .fullCircle = true, .smooth = true }, // the Controls default
+            { .fullCircle = false, .smooth = false },
+            { .fullCircle = false, .smooth = true },
+        };
+        std::vector<float> zeros( 4, 0.0f ), ones( 4, 1.0f );
+        std::vector<uint8_t> LMBpressed( 4, 1 );
+        const ControlsBatch::Input input{ zeros.data(), zeros.data(), ones.data(), zeros.data(), zeros.data(), zeros.data(), LMBpressed.data() };
+        for (size_t m = 0; m < 3; m++) {
+            linAlg::mat3x4_t viewMatrices[4] = {};
+            ControlsBatch constructed( 4, unsupported[m] );
+            check( constructed.update( input, viewMatrices ) == eRetVal::ERROR, "update() with an unsupported mode from the constructor", m );
+            check( viewMatrices[0][0][0] == 0.0f, "view matrices untouched", m );
+
+            ControlsBatch batch( 4 );
+            check( batch.setInteractionMode( unsupported[m] ) == eRetVal::ERROR, "setInteractionMode() with an unsupported mode", m );
+            check( batch.update( input, viewMatrices ) == eRetVal::ERROR, "update() with an unsupported mode from setInteractionMode()", m );
+            check( batch.setInteractionMode( Controls::InteractionModeDesc{ .fullCircle = true, .smooth = false } ) == eRetVal::OK, "setInteractionMode() back to the supported mode", m );
+            check( batch.update( input, viewMatrices ) == eRetVal::OK, "update() with the supported mode", m );
+        }
+    }
+}
+
+int main() {
+    testAgainstControls();
+    testUnsupportedModes();
+    return report( "arcBallControlsBatch" );
+}
@@ -0,0 +1,324 @@
+// arcBallMath.h kernels against plain scalar references, built once per code path (see CMakeLists.txt)
+// the scalar and SSE4.1 paths have to match the references bit for bit, the AVX2 one (fused multiply-adds) to within a few ulps
+// array kernels are run on every length up to a few vector widths, from unaligned starts, with several strides, and in place
+
+#include "arcBallMath.h"
+#include "arcBallQuat.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <random>
+#include <vector>
+
+#if defined( ARCBALL_MATH_TEST_EXPECT_AVX2 ) && !defined( ARCBALL_MATH_AVX2 )
+    #error "built for the AVX2 path, but arcBallMath.h didn't pick it"
+#elif defined( ARCBALL_MATH_TEST_EXPECT_SSE4 ) && (!defined( ARCBALL_MATH_SSE4 ) || defined( ARCBALL_MATH_AVX2 ))
+    #error "built for the SSE4.1 path, but arcBallMath.h didn't pick it"
+#elif defined( ARCBALL_MATH_TEST_EXPECT_SCALAR ) && defined( ARCBALL_MATH_SSE4 )
+    #error "built for the scalar path, but arcBallMath.h didn't pick it"
+#endif
+
+using namespace ArcBall;
+
+namespace {
+    static constexpr int skipReturnCode = 77; // ctest SKIP_RETURN_CODE: the CPU can't run this build
+
+    static int numFailures = 0;
+    static int numChecks = 0;
+
+    #if defined( ARCBALL_MATH_AVX2 )
+        // fused multiply-adds round once where the references round twice
+        static constexpr float relTolerance = 4.0f * 1.1920929e-7f;
+    #else
+        static constexpr float relTolerance = 0.0f;
+    #endif
+
+    // |a - ref| within relTolerance of the magnitude of the terms that went into ref (scale), exact match if relTolerance is 0
+    static bool isClose( const float a, const float ref, const float scale ) {
+        if (relTolerance == 0.0f) { return memcmp( &a, &ref, sizeof( float ) ) == 0; }
+        return fabsf( a - ref ) <= relTolerance * fmaxf( scale, 1.0f );
+    }
+
+    static void check( const bool ok, const char* what, const size_t idx ) {
+        numChecks++;
+        if (ok) { return; }
+        if (numFailures < 20) { printf( "FAILED: %s (index %zu)\n", what, idx ); }
+        numFailures++;
+    }
+
+    // the references - the plain scalar code the kernels have to reproduce
+
+    static void refMulAffine( linAlg::mat3x4_t& r, const linAlg::mat3x4_t& a, const linAlg::mat3x4_t& b ) {
+        linAlg::mat3x4_t tmp;
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 4; j++) {
+                tmp[i][j] = a[i][0] * b[0][j] + a[i][1] * b[1][j] + a[i][2] * b[2][j];
+            }
+            tmp[i][3] += a[i][3];
+        }
+        r = tmp;
+    }
+
+    static linAlg::vec3_t refTransformPoint( const linAlg::mat3x4_t& m, const linAlg::vec3_t& p ) {
+        linAlg::vec3_t r;
+        for (int i = 0; i < 3; i++) { r[i] = m[i][0] * p[0] + m[i][1] * p[1] + m[i][2] * p[2] + m[i][3]; }
+        return r;
+    }
+
+    static void refRigidInverse( linAlg::mat3x4_t& inv, const linAlg::mat3x4_t& m ) {
+        for (int r = 0; r < 3; r++) {
+            for (int c = 0; c < 3; c++) { inv[r][c] = m[c][r]; }
+            inv[r][3] = -(m[0][r] * m[0][3] + m[1][r] * m[1][3] + m[2][r] * m[2][3]);
+        }
+    }
+
+    static void refOrthonormalize( linAlg::mat3_t& m ) {
+        for (int r = 0; r < 2; r++) {
+            if (r == 1) {
+                const float d = m[0][0] * m[1][0] + m[0][1] * m[1][1] + m[0][2] * m[1][2];
+                for (int c = 0; c < 3; c++) { m[1][c] = m[1][c] - m[0][c] * d; }
+            }
+            const float len = sqrtf( m[r][0] * m[r][0] + m[r][1] * m[r][1] + m[r][2] * m[r][2] );
+            for (int c = 0; c < 3; c++) { m[r][c] /= len; }
+        }
+        m[2] = linAlg::vec3_t{ m[0][1] * m[1][2] - m[0][2] * m[1][1], m[0][2] * m[1][0] - m[0][0] * m[1][2], m[0][0] * m[1][1] - m[0][1] * m[1][0] };
+    }
+
+    // magnitude of the terms summed up for row i of m * { p, 1 }, for the tolerance
+    static float pointScale( const linAlg::mat3x4_t& m, const int i, const linAlg::vec3_t& p ) {
+        return fabsf( m[i][0] * p[0] ) + fabsf( m[i][1] * p[1] ) + fabsf( m[i][2] * p[2] ) + fabsf( m[i][3] );
+    }
+
+    struct Rng {
+        std::mt19937 engine{ 7 };
+        std::uniform_real_distribution<float> dist{ -1.0f, 1.0f };
+        float operator()() { return dist( engine ); }
+    };
+
+    static linAlg::mat3x4_t randomRigid( Rng& rng, const float transScale ) {
+        linAlg::vec4_t q{ rng(), rng(), rng(), rng() };
+        linAlg::normalize( q );
+        linAlg::mat3x4_t m;
+        loadRotTransMatrix( m, q, linAlg::vec3_t{ rng() * transScale, rng() * transScale, rng() * transScale } );
+        return m;
+    }
+
+    static linAlg::mat3x4_t randomAffine( Rng& rng ) {
+        linAlg::mat3x4_t m;
+        for (auto& row : m) {
+            for (float& v : row) { v = rng() * 10.0f; }
+        }
+        return m;
+    }
+
+    static void testMulAffine( Rng& rng ) {
+        for (int i = 0; i < 10000; i++) {
+            const linAlg::mat3x4_t a = (i & 1) ? randomRigid( rng, 100.0f ) : randomAffine( rng );
+            const linAlg::mat3x4_t b = (i & 2) ? randomRigid( rng, 100.0f ) : randomAffine( rng );
+            linAlg::mat3x4_t ref, r;
+            refMulAffine( ref, a, b );
+            mulAffine( r, a, b );
+            bool ok = true;
+            for (int row = 0; row < 3; row++) {
+                for (int col = 0; col < 4; col++) {
+                    const float scale = fabsf( a[row][0] * b[0][col] ) + fabsf( a[row][1] * b[1][col] ) + fabsf( a[row][2] * b[2][col] ) + ((col == 3) ? fabsf( a[row][3] ) : 0.0f);
+                    ok = ok && isClose( r[row][col], ref[row][col], scale );
+                }
+            }
+            check( ok, "mulAffine", i );
+
+            // r may be a or b
+            linAlg::mat3x4_t aliasA = a, aliasB = b;
+            mulAffine( aliasA, aliasA, b );
+            mulAffine( aliasB, a, aliasB );
+            check( memcmp( &aliasA, &r, sizeof( r ) ) == 0 && memcmp( &aliasB, &r, sizeof( r ) ) == 0, "mulAffine in place", i );
+        }
+    }
+
+    static void testTransformPoint( Rng& rng ) {
+        for (int i = 0; i < 10000; i++) {
+            const linAlg::mat3x4_t m = randomRigid( rng, 100.0f );
+            const linAlg::vec3_t p{ rng() * 50.0f, rng() * 50.0f, rng() * 50.0f };
+            const linAlg::vec3_t ref = refTransformPoint( m, p );
+            const linAlg::vec3_t r = transformPoint( m, p );
+            // scalar everywhere, so exact in every build
+            check( memcmp( &r, &ref, sizeof( r ) ) == 0, "transformPoint", i );
+        }
+    }
+
+    static void testRigidInverse( Rng& rng ) {
+        for (int i = 0; i < 10000; i++) {
+            const linAlg::mat3x4_t m = randomRigid( rng, 100.0f );
+            linAlg::mat3x4_t ref, inv;
+            refRigidInverse( ref, m );
+            loadRigidInverse( inv, m );
+            bool ok = true;
+            for (int r = 0; r < 3; r++) {
+                for (int c = 0; c < 3; c++) { ok = ok && inv[r][c] == ref[r][c]; }
+                const float scale = fabsf( m[0][r] * m[0][3] ) + fabsf( m[1][r] * m[1][3] ) + fabsf( m[2][r] * m[2][3] );
+                ok = ok && isClose( inv[r][3], ref[r][3], scale );
+            }
+            check( ok, "loadRigidInverse", i );
+
+            // and it is the inverse
+            linAlg::mat3x4_t id;
+            mulAffine( id, inv, m );
+            float err = 0.0f;
+            for (int r = 0; r < 3; r++) {
+                for (int c = 0; c < 4; c++) { err = fmaxf( err, fabsf( id[r][c] - ((r == c) ? 1.0f : 0.0f) ) ); }
+            }
+            check( err < 1.0e-4f, "loadRigidInverse * m == identity", i );
+        }
+    }
+
+    static void testOrthonormalize( Rng& rng ) {
+        for (int i = 0; i < 10000; i++) {
+            // a rotation with noise on it, like an accumulated one
+            const linAlg::mat3x4_t rot = randomRigid( rng, 0.0f );
+            linAlg::mat3_t m;
+            for (int r = 0; r < 3; r++) {
+                for (int c = 0; c < 3; c++) { m[r][c] = rot[r][c] + 1.0e-3f * rng(); }
+            }
+            linAlg::mat3_t ref = m;
+            refOrthonormalize( ref );
+            orthonormalize( m );
+            // scalar everywhere, but linAlg's normalize() might round differently than the reference
+            bool ok = true;
+            for (int r = 0; r < 3; r++) {
+                for (int c = 0; c < 3; c++) { ok = ok && fabsf( m[r][c] - ref[r][c] ) <= 4.0f * 1.1920929e-7f; }
+            }
+            check( ok, "orthonormalize", i );
+
+            float err = 0.0f;
+            for (int r = 0; r < 3; r++) {
+                for (int c = 0; c < 3; c++) { err = fmaxf( err, fabsf( linAlg::dot( m[r], m[c] ) - ((r == c) ? 1.0f : 0.0f) ) ); }
+            }
+            check( err < 1.0e-6f, "orthonormalize orthonormal", i );
+        }
+    }
+
+    static void testTransformPointsSoA( Rng& rng ) {
+        static constexpr size_t maxPoints = 37; // a few vector widths plus every possible tail
+        static constexpr size_t pad = 3;        // starts up to 3 floats off alignment, guard values behind the ends
+        static constexpr float guard = 12345.0f;
+
+        const linAlg::mat3x4_t m = randomRigid( rng, 100.0f );
+        for (size_t offset = 0; offset <= pad; offset++) {
+            for (size_t n = 0; n <= maxPoints; n++) {
+                std::vector<float> in[3], out[3];
+                for (int c = 0; c < 3; c++) {
+                    in[c].assign( maxPoints + 2 * pad, guard );
+                    out[c].assign( maxPoints + 2 * pad, guard );
+                    for (size_t i = 0; i < n; i++) { in[c][offset + i] = rng() * 50.0f; }
+                }
+                transformPointsSoA( m, in[0].data() + offset, in[1].data() + offset, in[2].data() + offset,
+                                    out[0].data() + offset, out[1].data() + offset, out[2].data() + offset, n );
+
+                bool ok = true;
+                for (size_t i = 0; i < n; i++) {
+                    const linAlg::vec3_t p{ in[0][offset + i], in[1][offset + i], in[2][offset + i] };
+                    const linAlg::vec3_t ref = refTransformPoint( m, p );
+                    for (int c = 0; c < 3; c++) { ok = ok && isClose( out[c][offset + i], ref[c], pointScale( m, c, p ) ); }
+                }
+                for (int c = 0; c < 3; c++) {
+                    for (size_t i = 0; i < out[c].size(); i++) {
+                        if (i < offset || i >= offset + n) { ok = ok && out[c][i] == guard; }
+                    }
+                }
+                check( ok, "transformPointsSoA", n );
+
+                // out may be in
+                transformPointsSoA( m, in[0].data() + offset, in[1].data() + offset, in[2].data() + offset,
+                                    in[0].data() + offset, in[1].data() + offset, in[2].data() + offset, n );
+                check( in[0] == out[0] && in[1] == out[1] && in[2] == out[2], "transformPointsSoA in place", n );
+            }
+        }
+    }
+
+    static void testTransformPointsStrided( Rng& rng ) {
+        static constexpr size_t maxPoints = 37;
+        static constexpr float guard = 12345.0f;
+
+        const linAlg::mat3x4_t m = randomRigid( rng, 100.0f );
+        // tightly packed (the wide path), padded to 16, vertex struct sized, and an odd one; in and out strides may differ
+        const size_t strides[] = { 12, 16, 24, 28 };
+        for (const size_t inStride : strides) {
+            for (const size_t outStride : strides) {
+                for (size_t offset = 0; offset <= 3; offset++) { // in floats, off any alignment
+                    for (size_t n = 0; n <= maxPoints; n++) {
+                        const size_t inFloats = offset + (maxPoints + 1) * inStride / sizeof( float );
+                        const size_t outFloats = offset + (maxPoints + 1) * outStride / sizeof( float );
+                        std::vector<float> in( inFloats, guard ), out( outFloats, guard );
+                        for (size_t i = 0; i < n; i++) {
+                            for (int c = 0; c < 3; c++) { in[offset + i * inStride / sizeof( float ) + c] = rng() * 50.0f; }
+                        }
+                        const std::vector<float> inCopy = in;
+                        transformPointsStrided( m, in.data() + offset, inStride, out.data() + offset, outStride, n );
+
+                        // points where they belong, everything else untouched
+                        std::vector<bool> isPoint( outFloats, false );
+                        bool ok = in == inCopy;
+                        for (size_t i = 0; i < n; i++) {
+                            const float* p = in.data() + offset + i * inStride / sizeof( float );
+                            const linAlg::vec3_t pt{ p[0], p[1], p[2] };
+                            const linAlg::vec3_t ref = refTransformPoint( m, pt );
+                            for (int c = 0; c < 3; c++) {
+                                const size_t idx = offset + i * outStride / sizeof( float ) + c;
+                                ok = ok && isClose( out[idx], ref[c], pointScale( m, c, pt ) );
+                                isPoint[idx] = true;
+                            }
+                        }
+                        for (size_t i = 0; i < outFloats; i++) {
+                            if (!isPoint[i]) { ok = ok && out[i] == guard; }
+                        }
+                        check( ok, "transformPointsStrided", inStride * 1000 + outStride * 10 + n );
+
+                        // out may be in with the same stride
+                        if (inStride == outStride) {
+                            transformPointsStrided( m, in.data() + offset, inStride, in.data() + offset, inStride, n );
+                            check( in == out, "transformPointsStrided in place", inStride * 1000 + n );
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    static bool canRunThisBuild() {
+    #if defined( __GNUC__ ) && (defined( __x86_64__ ) || defined( __i386__ ))
+        __builtin_cpu_init();
+        #if defined( ARCBALL_MATH_AVX2 )
+            return __builtin_cpu_supports( "avx2" ) && __builtin_cpu_supports( "fma" );
+        #elif defined( ARCBALL_MATH_SSE4 )
+            return __builtin_cpu_supports( "sse4.1" );
+        #endif
+    #endif
+        return true;
+    }
+}
+
+int main() {
+#if defined( ARCBALL_MATH_AVX2 )
+    const char* path = "AVX2";
+#elif defined( ARCBALL_MATH_SSE4 )
+    const char* path = "SSE4.1";
+#else
+    const char* path = "scalar";
+#endif
+    if (!canRunThisBuild()) {
+        printf( "arcBallMath %s: not supported by this CPU, skipped\n", path );
+        return skipReturnCode;
+    }
+
+    Rng rng;
+    testMulAffine( rng );
+    testTransformPoint( rng );
+    testRigidInverse( rng );
+    testOrthonormalize( rng );
+    testTransformPointsSoA( rng );
+    testTransformPointsStrided( rng );
+
+    printf( "arcBallMath %s: %d of %d checks failed\n", path, numFailures, numChecks );
+    return (numFailures == 0) ? 0 : 1;
+}
@@ -0,0 +1,106 @@
+// a long presenter session through StateStreamEncoder -> StateStreamDecoder -> apply(): the follower's view matrix has to stay within
+// the tolerance documented in arcBallStateStream.h of the presenter's on every frame, from the first to the last - no drift
+// plus gaps (rejected deltas until the next keyframe) and truncated packets
+
+#include "arcBallTest.h"
+#include "arcBallStateStream.h"
+
+#include <math.h>
+#include <vector>
+
+using namespace ArcBall;
+using namespace ArcBallTest;
+
+namespace {
+    static constexpr int numFrames = 200000; // about an hour at 60 Hz
+    static constexpr int numPhaseFrames = 300;
+
+    static void testLongSession() {
+        const StateStreamQuantization quantization;
+        Lcg lcg;
+        Controls presenter;
+        presenter.setLargeWorldMode( true, 8.0f );
+        Controls follower;
+        StateStreamEncoder encoder( quantization );
+        StateStreamDecoder decoder;
+        std::vector<uint8_t> packet;
+
+        float relMouseX = 0.5f, relMouseY = 0.5f, camTiltRadAngle = 0.0f, camDist = -15.0f;
+        float maxError = 0.0f, maxErrorLastMinute = 0.0f;
+        for (int frame = 0; frame < numFrames; frame++) {
+            // dragging, coasting, panning, tilting, zooming, sitting still; a new pivot every 1000 frames
+            const int phase = (frame / numPhaseFrames) % 6;
+            float dx = 0.0f, dy = 0.0f;
+            linAlg::vec3_t panDelta{ 0.0f, 0.0f, 0.0f };
+            if (phase == 0) {
+                dx = (lcg.next() - 0.3f) * 0.01f;
+                dy = (lcg.next() - 0.5f) * 0.01f;
+                relMouseX = (relMouseX + dx < 0.0f || relMouseX + dx > 1.0f) ? 0.5f : relMouseX + dx;
+                relMouseY = (relMouseY + dy < 0.0f || relMouseY + dy > 1.0f) ? 0.5f : relMouseY + dy;
+            }
+            if (phase == 2) { panDelta = linAlg::vec3_t{ (lcg.next() - 0.5f) * 0.05f, (lcg.next() - 0.5f) * 0.05f, 0.0f }; }
+            if (phase == 3) { camTiltRadAngle += 0.002f; }
+            if (phase == 4) { camDist = fminf( camDist + (lcg.next() - 0.5f) * 0.1f, -1.0f ); }
+            if (frame % 1000 == 999) {
+                presenter.seamlessSetRotationPivotWS( linAlg::vec3_t{ lcg.next() * 20.0f - 10.0f, lcg.next() * 20.0f - 10.0f, lcg.next() * 20.0f - 10.0f }, camTiltRadAngle, camDist );
+            }
+            presenter.update( 1.0f / 60.0f, relMouseX, relMouseY, dx, dy, camDist, panDelta, camTiltRadAngle, phase == 0 );
+
+            encoder.encode( presenter, packet );
+            check( decoder.decode( packet ) == eRetVal::OK, "StateStreamDecoder::decode", static_cast<size_t>( frame ) );
+            check( decoder.apply( follower ) == eRetVal::OK, "StateStreamDecoder::apply", static_cast<size_t>( frame ) );
+            check( decoder.getOriginWS() == presenter.getOriginWS(), "decoded origin", static_cast<size_t>( frame ) );
+
+            // the tolerance grows with the distance of the pivot from the origin, through the rotation error
+            const linAlg::vec3_t pivotWS = presenter.getRotationPivotOffsetWS();
+            const float pivotDist = sqrtf( linAlg::dot( pivotWS, pivotWS ) );
+            const float tolerance = calcStateStreamTolerance( quantization, pivotDist + fabsf( camDist ) );
+            const float error = maxAbsDiff( follower.getViewMatrix(), presenter.getViewMatrix() );
+            maxError = fmaxf( maxError, error );
+            if (frame >= numFrames - 3600) { maxErrorLastMinute = fmaxf( maxErrorLastMinute, error ); }
+            check( error <= tolerance, "follower view matrix vs presenter", static_cast<size_t>( frame ) );
+        }
+        printf( "max follower view matrix error: %g over %d frames, %g in the last minute\n", maxError, numFrames, maxErrorLastMinute );
+    }
+
+    static void testGapsAndTruncation() {
+        Controls presenter;
+        StateStreamEncoder encoder( StateStreamQuantization{}, 1000 );
+        StateStreamDecoder decoder;
+        std::vector<uint8_t> packet;
+
+        presenter.update( 1.0f / 60.0f, 0.5f, 0.5f, 0.01f, 0.0f, -15.0f, linAlg::vec3_t{ 0.0f, 0.0f, 0.0f }, 0.0f, true );
+        encoder.encode( presenter, packet );
+        check( decoder.decode( packet ) == eRetVal::OK, "first keyframe", 0 );
+
+        // a lost delta: the next one is refused, as is everything until a keyframe
+        for (int i = 0; i < 3; i++) {
+            presenter.update( 1.0f / 60.0f, 0.5f, 0.5f, 0.01f, 0.0f, -15.0f, linAlg::vec3_t{ 0.0f, 0.0f, 0.0f }, 0.0f, true );
+            encoder.encode( presenter, packet );
+            if (i == 0) { continue; }
+            check( decoder.decode( packet ) == eRetVal::ERROR && decoder.needsKeyframe(), "delta after a gap", i );
+        }
+        encoder.requestKeyframe();
+        presenter.update( 1.0f / 60.0f, 0.5f, 0.5f, 0.01f, 0.0f, -15.0f, linAlg::vec3_t{ 0.0f, 0.0f, 0.0f }, 0.0f, true );
+        encoder.encode( presenter, packet );
+        check( decoder.decode( packet ) == eRetVal::OK && !decoder.needsKeyframe(), "keyframe after a gap", 0 );
+
+        // every truncation of a keyframe and of a delta
+        for (const bool keyframe : { true, false }) {
+            if (keyframe) { encoder.requestKeyframe(); }
+            presenter.update( 1.0f / 60.0f, 0.5f, 0.5f, 0.01f, 0.005f, -14.0f, linAlg::vec3_t{ 0.01f, 0.0f, 0.0f }, 0.1f, true );
+            encoder.encode( presenter, packet );
+            for (size_t size = 0; size < packet.size(); size++) {
+                StateStreamDecoder truncatedDecoder = decoder;
+                check( truncatedDecoder.decode( std::span<const uint8_t>( packet.data(), size ) ) == eRetVal::ERROR, "truncated packet", size );
+            }
+            check( decoder.decode( packet ) == eRetVal::OK, "complete packet", packet.size() );
+        }
+    }
+}
+
+int main() {
+    testLongSession();
+    testGapsAndTruncation();
+    return report( "arcBallStateStream" );
+}
@@ -0,0 +1,171 @@
+// Controls::saveState() -> restoreState() has to be bit-exact: the restored Controls shows the same view matrix, saves the same bytes
+// and continues exactly like the original, in every interaction mode, mid-drag and while coasting
+// ViewHistory entries are quantized, restoring them has to land within the precision documented in arcBallViewHistory.h
+
+#include "arcBallTest.h"
+#include "arcBallViewHistory.h"
+#include "arcBallMath.h"
+
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+using namespace ArcBall;
+using namespace ArcBallTest;
+
+namespace {
+    struct FrameInput {
+        float relMouseX, relMouseY, dx, dy, camDist, camTiltRadAngle;
+        linAlg::vec3_t panDelta;
+        bool LMBpressed;
+    };
+
+    // phases of 120 frames: dragging twice, letting go, panning, zooming, tilting
+    static std::vector<FrameInput> makeSession( const int numFrames, const uint32_t seed ) {
+        Lcg lcg{ seed };
+        std::vector<FrameInput> session( numFrames );
+        for (int frame = 0; frame < numFrames; frame++) {
+            const int phase = (frame / 120) % 5;
+            FrameInput& in = session[frame];
+            in.LMBpressed = phase < 2;
+            in.dx = in.LMBpressed ? (lcg.next() - 0.5f) * 0.02f : 0.0f;
+            in.dy = in.LMBpressed ? (lcg.next() - 0.5f) * 0.02f : 0.0f;
+            in.relMouseX = 0.2f + 0.6f * lcg.next();
+            in.relMouseY = 0.2f + 0.6f * lcg.next();
+            in.camDist = -15.0f + ((phase == 3) ? static_cast<float>( frame % 120 ) * 0.01f : 0.0f);
+            in.camTiltRadAngle = (phase == 4) ? static_cast<float>( frame % 120 ) * 0.002f : 0.1f;
+            in.panDelta = (phase == 2) ? linAlg::vec3_t{ (lcg.next() - 0.5f) * 0.1f, (lcg.next() - 0.5f) * 0.1f, 0.0f } : linAlg::vec3_t{ 0.0f, 0.0f, 0.0f };
+        }
+        return session;
+    }
+
+    static void step( Controls& controls, const FrameInput& in ) {
+        controls.update( 1.0f / 60.0f, in.relMouseX, in.relMouseY, in.dx, in.dy, in.camDist, in.panDelta, in.camTiltRadAngle, in.LMBpressed );
+    }
+
+    static void setUp( Controls& controls, const Controls::InteractionModeDesc modeDesc ) {
+        controls.setInteractionMode( modeDesc );
+        controls.setLargeWorldMode( true, 4.0f ); // rebases every few frames, so the origin is part of the state too
+    }
+
+    static void testSaveRestore() {
+        const Controls::InteractionModeDesc modes[] = {
+            { .fullCircle = true, .smooth = true },
+            { .fullCircle = true, .smooth = false },
+            { .fullCircle = false, .smooth = true },
+            { .fullCircle = false, .smooth = false },
+        };
+        const std::vector<FrameInput> session = makeSession( 3000, 1 );
+        for (size_t m = 0; m < 4; m++) {
+            for (const int cut : { 100, 239, 250, 700, 1234 }) { // mid-drag, at the release, coasting, ...
+                Controls original;
+                setUp( original, modes[m] );
+                for (int frame = 0; frame < cut; frame++) {
+                    step( original, session[frame] );
+                    if (frame % 500 == 77) { original.seamlessSetRotationPivotWS( linAlg::vec3_t{ 1.0f, 2.0f, 3.0f }, session[frame].camTiltRadAngle, session[frame].camDist ); }
+                }
+                const size_t idx = m * 10000 + cut;
+
+                Controls::State state, stateAgain;
+                original.saveState( state );
+                original.saveState( stateAgain );
+                check( memcmp( &state, &stateAgain, sizeof( state ) ) == 0, "saveState() twice gives the same bytes", idx );
+
+                // into a Controls that differs in everything
+                Controls restored;
+                restored.setInteractionMode( Controls::InteractionModeDesc{ .fullCircle = !modes[m].fullCircle, .smooth = !modes[m].smooth } );
+                restored.setMouseSensitivity( 3.0f );
+                restored.update( 0.1f, 0.3f, 0.3f, 0.1f, 0.1f, 5.0f, linAlg::vec3_t{ 1.0f, 1.0f, 0.0f }, 1.0f, true );
+                check( restored.restoreState( state ) == eRetVal::OK, "restoreState()", idx );
+                check( maxAbsDiff( restored.getViewMatrix(), original.getViewMatrix() ) == 0.0f, "restored view matrix", idx );
+                Controls::State restoredState;
+                restored.saveState( restoredState );
+                check( memcmp( &state, &restoredState, sizeof( state ) ) == 0, "saveState() of the restored Controls", idx );
+
+                // both go on exactly alike
+                bool sameViews = true;
+                for (int frame = cut; frame < cut + 1500; frame++) {
+                    step( original, session[frame] );
+                    step( restored, session[frame] );
+                    sameViews = sameViews && maxAbsDiff( restored.getViewMatrix(), original.getViewMatrix() ) == 0.0f && restored.getOriginWS() == original.getOriginWS();
+                }
+                check( sameViews, "continuing after restoreState()", idx );
+            }
+        }
+
+        // other format versions are refused and leave the Controls alone
+        Controls controls;
+        step( controls, session[0] );
+        Controls::State state, before, after;
+        controls.saveState( state );
+        controls.saveState( before );
+        state.version = Controls::State::formatVersion + 1;
+        check( controls.restoreState( state ) == eRetVal::ERROR, "restoreState() of another version", 0 );
+        controls.saveState( after );
+        check( memcmp( &before, &after, sizeof( before ) ) == 0, "Controls unchanged after a refused restoreState()", 0 );
+    }
+
+    // eye space position of the absolute WS point P, in the view of controls
+    static linAlg::vec3_t toES( const Controls& controls, const std::array<double, 3>& pointWS ) {
+        const std::array<double, 3>& originWS = controls.getOriginWS();
+        const linAlg::vec3_t p{ static_cast<float>( pointWS[0] - originWS[0] ), static_cast<float>( pointWS[1] - originWS[1] ), static_cast<float>( pointWS[2] - originWS[2] ) };
+        return transformPoint( controls.getViewMatrix(), p );
+    }
+
+    static void testViewHistory() {
+        // 5e-5 rad rotation + tilt error and 2^-16 of the 15 unit view distance, for points within a few units of the pivot
+        static constexpr float tolerance = 2.0e-3f;
+
+        const std::vector<FrameInput> session = makeSession( 6000, 2 );
+        Controls controls;
+        setUp( controls, Controls::InteractionModeDesc{ .fullCircle = true, .smooth = true } );
+        ViewHistory history( 1000 );
+        std::vector<Controls> pushed;
+        for (int frame = 0; frame < 6000; frame++) {
+            step( controls, session[frame] );
+            if (frame % 4 == 0) {
+                history.push( controls );
+                pushed.push_back( controls );
+            }
+        }
+        check( history.size() == 1000, "ViewHistory::size()", history.size() );
+        check( history.getCurrentIdx() == 999, "ViewHistory::getCurrentIdx()", history.getCurrentIdx() );
+
+        // every entry, into a Controls that has moved on (and rebased) since
+        float maxError = 0.0f;
+        for (size_t idx = 0; idx < history.size(); idx++) {
+            Controls restored = controls;
+            check( history.restore( idx, restored ) == eRetVal::OK, "ViewHistory::restore()", idx );
+            const Controls& reference = pushed[pushed.size() - history.size() + idx];
+            const std::array<double, 3> pivotWS{ reference.getOriginWS()[0] + reference.getRotationPivotOffsetWS()[0],
+                                                 reference.getOriginWS()[1] + reference.getRotationPivotOffsetWS()[1],
+                                                 reference.getOriginWS()[2] + reference.getRotationPivotOffsetWS()[2] };
+            for (const std::array<double, 3>& offset : { std::array<double, 3>{ 0.0, 0.0, 0.0 }, std::array<double, 3>{ 3.0, -2.0, 1.0 }, std::array<double, 3>{ -1.0, 4.0, -3.0 } }) {
+                const std::array<double, 3> pointWS{ pivotWS[0] + offset[0], pivotWS[1] + offset[1], pivotWS[2] + offset[2] };
+                const linAlg::vec3_t a = toES( restored, pointWS );
+                const linAlg::vec3_t b = toES( reference, pointWS );
+                const float error = fmaxf( fmaxf( fabsf( a[0] - b[0] ), fabsf( a[1] - b[1] ) ), fabsf( a[2] - b[2] ) );
+                maxError = fmaxf( maxError, error );
+                check( error <= tolerance, "restored view vs pushed view", idx );
+            }
+        }
+        printf( "max ViewHistory view error: %g\n", maxError );
+        check( history.restore( history.size(), controls ) == eRetVal::ERROR, "ViewHistory::restore() out of range", 0 );
+
+        // undo / redo, and a push dropping the redo entries
+        for (int i = 0; i < 10; i++) { check( history.undo( controls ) == eRetVal::OK, "ViewHistory::undo()", i ); }
+        check( history.getCurrentIdx() == 989, "current entry after 10 undos", history.getCurrentIdx() );
+        check( history.redo( controls ) == eRetVal::OK && history.getCurrentIdx() == 990, "ViewHistory::redo()", history.getCurrentIdx() );
+        history.push( controls );
+        check( !history.canRedo() && history.size() == 992 && history.getCurrentIdx() == 991, "push() after undo drops the redo entries", history.size() );
+
+        history.clear();
+        check( !history.canUndo() && history.undo( controls ) == eRetVal::ERROR, "ViewHistory::undo() when empty", 0 );
+    }
+}
+
+int main() {
+    testSaveRestore();
+    testViewHistory();
+    return report( "arcBallState" );
+}
@@ -0,0 +1,47 @@
+#ifndef _ARCBALLTEST_H_8d3f61a2_5b0e_4c97_a1d4_62e9c0b7f315
+#define _ARCBALLTEST_H_8d3f61a2_5b0e_4c97_a1d4_62e9c0b7f315
+
+// bits shared by the tests against the arcball library: check() counts and prints failures, report() sums them up
+// for main() - 0 if all checks passed, 1 otherwise
+
+#include "arcBallControls.h"
+
+#include <stdio.h>
+#include <math.h>
+
+namespace ArcBallTest {
+
+    inline int numFailures = 0;
+    inline int numChecks = 0;
+
+    inline void check( const bool ok, const char* what, const size_t idx ) {
+        numChecks++;
+        if (ok) { return; }
+        if (numFailures < 20) { printf( "FAILED: %s (index %zu)\n", what, idx ); }
+        numFailures++;
+    }
+
+    inline int report( const char* testName ) {
+        printf( "%s: %d of %d checks failed\n", testName, numFailures, numChecks );
+        return (numFailures == 0) ? 0 : 1;
+    }
+
+    // largest absolute element difference
+    inline float maxAbsDiff( const linAlg::mat3x4_t& a, const linAlg::mat3x4_t& b ) {
+        float maxDiff = 0.0f;
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 4; j++) { maxDiff = fmaxf( maxDiff, fabsf( a[i][j] - b[i][j] ) ); }
+        }
+        return maxDiff;
+    }
+
+    // small deterministic generator in [0, 1), same sequence on every platform
+    struct Lcg {
+        uint32_t state = 12345u;
+        float next() {
+            state = state * 1664525u + 1013904223u;
+            return static_cast<float>( state >> 8 ) * (1.0f / 16777216.0f);
+        }
+    };
+}
+#endif // _ARCBALLTEST_H_8d3f61a2_5b0e_4c97_a1d4_62e9c0b7f315
@@ -0,0 +1,164 @@
+// TraceRecorder -> TraceReplayer round trip: a recorded session replayed into a fresh Controls has to reproduce every
+// recorded view matrix exactly, and traces cut short anywhere inside a record (or with a short CONFIG record) have to be rejected
+// usage: arcBallTraceTest <directory for the trace files>
+
+#include "arcBallTest.h"
+#include "arcBallTrace.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+using namespace ArcBall;
+using namespace ArcBallTest;
+
+namespace {
+    static bool readFile( const std::string& path, std::vector<uint8_t>& data ) {
+        FILE* file = fopen( path.c_str(), "rb" );
+        if (file == nullptr) { return false; }
+        data.clear();
+        uint8_t buffer[4096];
+        size_t numRead;
+        while ((numRead = fread( buffer, 1, sizeof( buffer ), file )) > 0) { data.insert( data.end(), buffer, buffer + numRead ); }
+        fclose( file );
+        return true;
+    }
+
+    static bool writeFile( const std::string& path, const uint8_t* data, const size_t size ) {
+        FILE* file = fopen( path.c_str(), "wb" );
+        if (file == nullptr) { return false; }
+        const bool ok = (fwrite( data, 1, size, file ) == size);
+        return (fclose( file ) == 0) && ok;
+    }
+
+    static eRetVal replayFile( const std::string& path, const bool checkViewMatrices, TraceReplayStats& stats ) {
+        TraceReplayer replayer;
+        if (replayer.open( path.c_str() ) != eRetVal::OK) { return eRetVal::ERROR; }
+        Controls controls;
+        return replayer.replay( controls, checkViewMatrices, 0.0f, stats );
+    }
+
+    // dragging, coasting, event batches, a mode change, pivot changes and a setViewMatrix()
+    static void recordSession( Controls& controls ) {
+        Lcg lcg;
+        float relMouseX = 0.5f, relMouseY = 0.5f;
+        double timeSec = 0.0;
+        for (int frame = 0; frame < 600; frame++) {
+            const float dx = (lcg.next() - 0.4f) * 0.01f;
+            const float dy = (lcg.next() - 0.5f) * 0.01f;
+            relMouseX = (relMouseX + dx < 0.0f || relMouseX + dx > 1.0f) ? 0.5f : relMouseX + dx;
+            relMouseY = (relMouseY + dy < 0.0f || relMouseY + dy > 1.0f) ? 0.5f : relMouseY + dy;
+            const linAlg::vec3_t panDelta{ (lcg.next() - 0.5f) * 0.01f, 0.0f, 0.0f };
+
+            if (frame == 200) { controls.setInteractionMode( Controls::InteractionModeDesc{ .fullCircle = false, .smooth = true } ); }
+            if (frame == 300) { controls.seamlessSetRotationPivotWS( linAlg::vec3_t{ 1.0f, -2.0f, 3.0f }, 0.1f, 5.0f ); }
+            if (frame == 400) { controls.setViewMatrix( controls.getViewMatrix() ); }
+
+            if (frame % 3 == 0) {
+                Controls::MouseEvent events[3];
+                for (Controls::MouseEvent& event : events) {
+                    timeSec += 1.0 / 180.0;
+                    event = Controls::MouseEvent{ timeSec, relMouseX, relMouseY, dx / 3.0f, dy / 3.0f, (frame & 64) == 0 };
+                }
+                controls.ingestEvents( 1.0f / 60.0f, events, 5.0f, panDelta, 0.1f );
+            } else {
+                timeSec += 1.0 / 60.0;
+                controls.update( 1.0f / 60.0f, relMouseX, relMouseY, dx, dy, 5.0f, panDelta, 0.1f, (frame & 64) == 0 );
+            }
+        }
+    }
+
+    // offsets of all records behind the header
+    static std::vector<size_t> findRecords( const std::vector<uint8_t>& data, const size_t headerSize ) {
+        std::vector<size_t> offsets;
+        size_t offset = headerSize;
+        while (offset + 5 <= data.size()) {
+            uint32_t payloadSize;
+            memcpy( &payloadSize, &data[offset + 1], sizeof( payloadSize ) );
+            offsets.push_back( offset );
+            offset += 5 + payloadSize;
+        }
+        return offsets;
+    }
+}
+
+int main( int argc, char* argv[] ) {
+    const std::string dir = (argc > 1) ? argv[1] : ".";
+    const std::string tracePath = dir + "/arcBallTraceTest.abtr";
+    const std::string cutPath = dir + "/arcBallTraceTest_cut.abtr";
+    static constexpr size_t headerSize = 12; // "ABTR", version, flags
+
+    // record ...
+    linAlg::mat3x4_t recordedViewMatrix;
+    {
+        TraceRecorder recorder;
+        check( recorder.open( tracePath.c_str(), true ) == eRetVal::OK, "TraceRecorder::open", 0 );
+        Controls controls;
+        controls.setTraceRecorder( &recorder );
+        recordSession( controls );
+        controls.setTraceRecorder( nullptr );
+        check( recorder.close() == eRetVal::OK, "TraceRecorder::close", 0 );
+        recordedViewMatrix = controls.getViewMatrix();
+    }
+
+    // ... replay, every view matrix bit for bit
+    {
+        TraceReplayer replayer;
+        check( replayer.open( tracePath.c_str() ) == eRetVal::OK, "TraceReplayer::open", 0 );
+        Controls controls;
+        TraceReplayStats stats;
+        check( replayer.replay( controls, true, 0.0f, stats ) == eRetVal::OK, "replay", 0 );
+        check( stats.numViewMatrixChecks == 600, "numViewMatrixChecks", static_cast<size_t>( stats.numViewMatrixChecks ) );
+        check( stats.maxViewMatrixError == 0.0f, "maxViewMatrixError", 0 );
+        check( stats.firstMismatchCall == UINT64_MAX, "firstMismatchCall", 0 );
+        check( maxAbsDiff( controls.getViewMatrix(), recordedViewMatrix ) == 0.0f, "final view matrix", 0 );
+    }
+
+    // cut short inside every record's type / size, and inside every payload
+    std::vector<uint8_t> data;
+    check( readFile( tracePath, data ), "reading the trace", 0 );
+    const std::vector<size_t> records = findRecords( data, headerSize );
+    check( records.size() > 600, "number of records", records.size() );
+    for (size_t i = 0; i < records.size(); i++) {
+        const size_t recordEnd = (i + 1 < records.size()) ? records[i + 1] : data.size();
+        for (const size_t cut : { records[i] + 1, records[i] + 3, recordEnd - 1 }) {
+            TraceReplayStats stats;
+            check( writeFile( cutPath, data.data(), cut ), "writing the cut trace", i );
+            check( replayFile( cutPath, false, stats ) == eRetVal::ERROR, "trace cut inside a record", i );
+        }
+    }
+    // cut at a record boundary it's just a shorter session
+    {
+        TraceReplayStats stats;
+        check( writeFile( cutPath, data.data(), records[records.size() / 2] ), "writing the cut trace", 0 );
+        check( replayFile( cutPath, true, stats ) == eRetVal::OK, "trace cut at a record boundary", 0 );
+    }
+
+    // a CONFIG record with a complete but too short payload
+    {
+        std::vector<uint8_t> shortConfig( data.begin(), data.begin() + headerSize );
+        const uint32_t payloadSize = 5;
+        shortConfig.push_back( static_cast<uint8_t>( eTraceRecord::CONFIG ) );
+        shortConfig.insert( shortConfig.end(), reinterpret_cast<const uint8_t*>( &payloadSize ), reinterpret_cast<const uint8_t*>( &payloadSize ) + sizeof( payloadSize ) );
+        shortConfig.insert( shortConfig.end(), payloadSize, uint8_t{ 1 } );
+        TraceReplayStats stats;
+        check( writeFile( cutPath, shortConfig.data(), shortConfig.size() ), "writing the short CONFIG trace", 0 );
+        check( replayFile( cutPath, false, stats ) == eRetVal::ERROR, "short CONFIG record", 0 );
+    }
+    // same for a VIEW_MATRIX record
+    {
+        std::vector<uint8_t> shortViewMatrix( data.begin(), data.begin() + headerSize );
+        const uint32_t payloadSize = 8;
+        shortViewMatrix.push_back( static_cast<uint8_t>( eTraceRecord::VIEW_MATRIX ) );
+        shortViewMatrix.insert( shortViewMatrix.end(), reinterpret_cast<const uint8_t*>( &payloadSize ), reinterpret_cast<const uint8_t*>( &payloadSize ) + sizeof( payloadSize ) );
+        shortViewMatrix.insert( shortViewMatrix.end(), payloadSize, uint8_t{ 0 } );
+        TraceReplayStats stats;
+        check( writeFile( cutPath, shortViewMatrix.data(), shortViewMatrix.size() ), "writing the short VIEW_MATRIX trace", 0 );
+        check( replayFile( cutPath, true, stats ) == eRetVal::ERROR, "short VIEW_MATRIX record", 0 );
+    }
+
+    if (numFailures == 0) { remove( tracePath.c_str() ); }
+    remove( cutPath.c_str() );
+    return report( "arcBallTrace" );
+}